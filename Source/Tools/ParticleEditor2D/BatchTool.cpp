@@ -0,0 +1,627 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "BatchTool.h"
+#include "ColorGradientFrame.h"
+#include "EffectHeaderExporter.h"
+#include "EffectMemory.h"
+#include "EffectOptimizer.h"
+#include "EffectParams.h"
+#include "ParticleStream.h"
+#include "PexImporter.h"
+#include "SpritePreprocessor.h"
+
+#include <Urho3D/Container/Sort.h>
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Engine/Engine.h>
+#include <Urho3D/Engine/EngineDefs.h>
+#include <Urho3D/IO/File.h>
+#include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/Graphics/Texture2D.h>
+#include <Urho3D/IO/MemoryBuffer.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Urho2D/ParticleEffect2D.h>
+#include <Urho3D/Urho2D/Sprite2D.h>
+
+#include <QApplication>
+#include <QFile>
+#include <QVBoxLayout>
+
+#include <cstdio>
+
+namespace Urho3D
+{
+
+BatchTool::BatchTool(Context* context) :
+    Object(context)
+{
+}
+
+BatchTool::~BatchTool()
+{
+}
+
+bool BatchTool::IsBatchCommand(const Vector<String>& arguments)
+{
+    if (arguments.Empty())
+        return false;
+
+    const String& command = arguments[0];
+    return command == "-import" || command == "-bench-import" || command == "-preprocess-sprites" ||
+        command == "-export-header" || command == "-bench-color-preview" || command == "-optimize" ||
+        command == "-query-stream";
+}
+
+int BatchTool::Run(const Vector<String>& arguments)
+{
+    // Widget benchmark, needs neither a directory nor the engine
+    if (!arguments.Empty() && arguments[0] == "-bench-color-preview")
+        return BenchColorPreview(arguments.Size() > 1 ? Max(ToUInt(arguments[1]), 1U) : 1000);
+    // Reads the stream file only
+    if (!arguments.Empty() && arguments[0] == "-query-stream")
+    {
+        if (arguments.Size() < 3)
+        {
+            PrintLine("Usage: ParticleEditor2D -query-stream <file> <counts|bounds|speed|size|rotation|ttl> [bins]", true);
+            return 1;
+        }
+        return QueryStream(GetInternalPath(arguments[1]), arguments[2], arguments.Size() > 3 ? Max(ToUInt(arguments[3]), 1U) : 20);
+    }
+
+    if (!IsBatchCommand(arguments) || arguments.Size() < 2)
+    {
+        PrintLine("Usage: ParticleEditor2D -import <directory> [budgetKB]\n"
+            "       ParticleEditor2D -bench-import <directory> [iterations]\n"
+            "       ParticleEditor2D -preprocess-sprites <directory> [scale]\n"
+            "       ParticleEditor2D -export-header <directory> <header> [namespace]\n"
+            "       ParticleEditor2D -bench-color-preview [ticks]\n"
+            "       ParticleEditor2D -optimize <directory> [thresholdPercent] [outputDirectory]\n"
+            "       ParticleEditor2D -query-stream <file> <counts|bounds|speed|size|rotation|ttl> [bins]", true);
+        return 1;
+    }
+
+    if (!InitializeEngine())
+        return 1;
+
+    const String& command = arguments[0];
+    const String pathName = GetInternalPath(arguments[1]);
+
+    if (command == "-import")
+        return Import(pathName, arguments.Size() > 2 ? ToUInt(arguments[2]) * 1024 : 0);
+    if (command == "-export-header")
+    {
+        if (arguments.Size() < 3)
+        {
+            PrintLine("Usage: ParticleEditor2D -export-header <directory> <header> [namespace]", true);
+            return 1;
+        }
+        return ExportHeader(pathName, GetInternalPath(arguments[2]), arguments.Size() > 3 ? arguments[3] : String("Effects"));
+    }
+    if (command == "-optimize")
+    {
+        const float threshold = arguments.Size() > 2 ? Max(ToFloat(arguments[2]), 0.0f) / 100.0f : EffectOptimizerSettings().threshold_;
+        return Optimize(pathName, threshold, arguments.Size() > 3 ? GetInternalPath(arguments[3]) : String::EMPTY);
+    }
+    if (command == "-preprocess-sprites")
+        return PreprocessSprites(pathName, arguments.Size() > 2 ? Max(ToFloat(arguments[2]), 0.0f) : 1.0f);
+
+    unsigned iterations = arguments.Size() > 2 ? ToUInt(arguments[2]) : 10;
+    return BenchImport(pathName, Max(iterations, 1U));
+}
+
+bool BatchTool::InitializeEngine()
+{
+    engine_ = new Engine(context_);
+
+    VariantMap engineParameters;
+    engineParameters[EP_HEADLESS] = true;
+    engineParameters[EP_RESOURCE_PATHS] = "CoreData;Data";
+    engineParameters[EP_LOG_NAME] = "ParticleEditor2D.log";
+    engineParameters[EP_LOG_QUIET] = true;
+
+    return engine_->Initialize(engineParameters);
+}
+
+int BatchTool::Import(const String& pathName, unsigned budgetBytes)
+{
+    Vector<String> fileNames;
+    GetSubsystem<FileSystem>()->ScanDir(fileNames, pathName, "*.pex", SCAN_FILES, true);
+
+    SharedPtr<PexImporter> importer(new PexImporter(context_));
+    Vector<SharedPtr<ParticleEffect2D> > effects;
+    unsigned imported = importer->ImportDirectory(pathName, effects);
+
+    for (const PexImportIssue& issue: importer->GetIssues())
+    {
+        PrintLine(issue.fileName_ + ":" + String(issue.issue_.line_) + ": " + (issue.issue_.error_ ? "error: " : "warning: ") +
+            issue.issue_.message_);
+    }
+
+    const unsigned errors = importer->GetNumErrors();
+    PrintLine("Imported " + String(imported) + " of " + String(fileNames.Size()) + " files, " + String(errors) + " errors, " +
+        String(importer->GetIssues().Size() - errors) + " warnings");
+
+    const unsigned overBudget = PrintMemoryReport(pathName, effects, budgetBytes);
+    return errors || overBudget ? 1 : 0;
+}
+
+int BatchTool::BenchImport(const String& pathName, unsigned iterations)
+{
+    Vector<String> fileNames;
+    GetSubsystem<FileSystem>()->ScanDir(fileNames, pathName, "*.pex", SCAN_FILES, true);
+    Sort(fileNames.Begin(), fileNames.End());
+    if (fileNames.Empty())
+    {
+        PrintLine("No .pex files found in " + pathName, true);
+        return 1;
+    }
+
+    // Read everything up front so both paths are timed without disk access
+    const String path = AddTrailingSlash(pathName);
+    Vector<PODVector<char> > contents(fileNames.Size());
+    for (unsigned i = 0; i < fileNames.Size(); ++i)
+    {
+        fileNames[i] = path + fileNames[i];
+        File file(context_, fileNames[i]);
+        contents[i].Resize(file.GetSize());
+        if (!contents[i].Empty())
+            file.Read(&contents[i][0], contents[i].Size());
+    }
+
+    SharedPtr<PexImporter> importer(new PexImporter(context_));
+    HiresTimer timer;
+    long long xmlTime = 0;
+    long long streamTime = 0;
+    unsigned mismatches = 0;
+
+    for (unsigned iteration = 0; iteration < iterations; ++iteration)
+    {
+        for (unsigned i = 0; i < fileNames.Size(); ++i)
+        {
+            const PODVector<char>& data = contents[i];
+
+            timer.Reset();
+            SharedPtr<ParticleEffect2D> xmlEffect(new ParticleEffect2D(context_));
+            xmlEffect->SetName(fileNames[i]);
+            MemoryBuffer buffer(data.Empty() ? 0 : &data[0], data.Size());
+            bool loaded = xmlEffect->Load(buffer);
+            xmlTime += timer.GetUSec(false);
+
+            timer.Reset();
+            SharedPtr<ParticleEffect2D> streamEffect = importer->Import(fileNames[i], data.Empty() ? 0 : &data[0], data.Size());
+            streamTime += timer.GetUSec(false);
+
+            // Both paths must agree on every parameter Urho3D understands
+            if (iteration == 0 && loaded && streamEffect)
+            {
+                EffectParams xmlParams;
+                EffectParams streamParams;
+                ReadEffectParams(xmlEffect, xmlParams);
+                ReadEffectParams(streamEffect, streamParams);
+                if (xmlParams != streamParams)
+                {
+                    PrintLine(fileNames[i] + ": streaming import differs from XMLFile import");
+                    ++mismatches;
+                }
+            }
+        }
+        importer->ClearIssues();
+    }
+
+    const unsigned loads = iterations * fileNames.Size();
+    char line[256];
+    sprintf(line, "%u files x %u iterations", fileNames.Size(), iterations);
+    PrintLine(line);
+    sprintf(line, "XMLFile:   %10.3f ms total, %8.2f us per file", xmlTime / 1000.0, (double)xmlTime / loads);
+    PrintLine(line);
+    sprintf(line, "Streaming: %10.3f ms total, %8.2f us per file", streamTime / 1000.0, (double)streamTime / loads);
+    PrintLine(line);
+    sprintf(line, "Speedup:   %10.2fx", streamTime ? (double)xmlTime / streamTime : 0.0);
+    PrintLine(line);
+
+    return mismatches ? 1 : 0;
+}
+
+int BatchTool::PreprocessSprites(const String& pathName, float scale)
+{
+    // Share the editor's cache directory
+    QCoreApplication::setApplicationName("Urho2DParticleEditor");
+
+    Vector<String> fileNames;
+    GetSubsystem<FileSystem>()->ScanDir(fileNames, pathName, "*.pex", SCAN_FILES, true);
+    Sort(fileNames.Begin(), fileNames.End());
+
+    SharedPtr<SpritePreprocessor> preprocessor(new SpritePreprocessor(context_));
+    preprocessor->SetScale(scale);
+
+    const String path = AddTrailingSlash(pathName);
+    PexParser parser;
+    unsigned sourceMemory = 0;
+    unsigned processedMemory = 0;
+    unsigned failed = 0;
+
+    for (const String& fileName: fileNames)
+    {
+        QFile file(QString::fromUtf8((path + fileName).CString()));
+        if (!file.open(QIODevice::ReadOnly))
+            continue;
+        const QByteArray data = file.readAll();
+
+        EffectParams params;
+        if (!parser.Parse(data.constData(), data.size(), params) || params.texture_.Empty())
+            continue;
+
+        ProcessedSprite sprite = preprocessor->Process(GetParentPath(path + fileName) + params.texture_, params);
+        if (sprite.path_.isEmpty())
+        {
+            PrintLine(fileName + ": could not process " + params.texture_, true);
+            ++failed;
+            continue;
+        }
+
+        char line[256];
+        sprintf(line, "%4dx%-4d -> %4dx%-4d (max particle %.0f px)", sprite.sourceWidth_, sprite.sourceHeight_, sprite.width_,
+            sprite.height_, SpritePreprocessor::GetMaxParticleSize(params));
+        PrintLine(String(line) + " " + fileName);
+
+        sourceMemory += SpritePreprocessor::GetTextureMemory(sprite.sourceWidth_, sprite.sourceHeight_);
+        processedMemory += SpritePreprocessor::GetTextureMemory(sprite.width_, sprite.height_);
+    }
+
+    char line[256];
+    sprintf(line, "Texture memory with mips: %.1f KB -> %.1f KB", sourceMemory / 1024.0, processedMemory / 1024.0);
+    PrintLine(line);
+
+    return failed ? 1 : 0;
+}
+
+int BatchTool::ExportHeader(const String& pathName, const String& headerFileName, const String& namespaceName)
+{
+    Vector<String> fileNames;
+    GetSubsystem<FileSystem>()->ScanDir(fileNames, pathName, "*.pex", SCAN_FILES, true);
+    Sort(fileNames.Begin(), fileNames.End());
+
+    const String path = AddTrailingSlash(pathName);
+    SharedPtr<PexImporter> importer(new PexImporter(context_));
+    SharedPtr<EffectHeaderExporter> exporter(new EffectHeaderExporter(context_));
+
+    for (const String& fileName: fileNames)
+    {
+        SharedPtr<ParticleEffect2D> effect = importer->Import(path + fileName);
+        if (!effect)
+            continue;
+
+        // Export what the engine holds after loading, e.g. particle counts as integers
+        EffectParams params;
+        ReadEffectParams(effect, params);
+        if (!exporter->AddEffect(GetFileName(fileName), fileName, params))
+        {
+            PrintLine(path + fileName + ": infinite or NaN parameter, cannot export", true);
+            return 1;
+        }
+    }
+
+    for (const PexImportIssue& issue: importer->GetIssues())
+    {
+        PrintLine(issue.fileName_ + ":" + String(issue.issue_.line_) + ": " + (issue.issue_.error_ ? "error: " : "warning: ") +
+            issue.issue_.message_);
+    }
+
+    String report;
+    if (!exporter->Verify(report))
+    {
+        PrintLine("Exported values do not round-trip:\n" + report, true);
+        return 1;
+    }
+
+    if (!exporter->Save(headerFileName, namespaceName))
+    {
+        PrintLine("Could not write " + headerFileName, true);
+        return 1;
+    }
+
+    PrintLine("Exported " + String(exporter->GetNumEffects()) + " effects to " + headerFileName);
+    return 0;
+}
+
+int BatchTool::BenchColorPreview(unsigned ticks)
+{
+    // Widgets need a GUI application, the offscreen platform works without a display
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    int argc = 1;
+    char name[] = "ParticleEditor2D";
+    char* argv[] = { name, nullptr };
+    QApplication application(argc, argv);
+
+    // Re-polishing cost depends on the application style sheet, so use the editor's
+    QFile file(":/qdarkstyle/style.qss");
+    if (file.open(QFile::ReadOnly | QFile::Text))
+        application.setStyleSheet(QLatin1String(file.readAll()));
+
+    QWidget window;
+    QVBoxLayout* layout = new QVBoxLayout(&window);
+    QFrame* styledFrame = new QFrame();
+    styledFrame->setFixedHeight(20);
+    styledFrame->setAutoFillBackground(true);
+    layout->addWidget(styledFrame);
+    ColorGradientFrame* paintedFrame = new ColorGradientFrame();
+    paintedFrame->setFixedHeight(20);
+    layout->addWidget(paintedFrame);
+    window.resize(300, 60);
+    window.show();
+    application.processEvents();
+
+    HiresTimer timer;
+    long long styledTime = 0;
+    long long paintedTime = 0;
+
+    for (unsigned i = 0; i < ticks; ++i)
+    {
+        // Every tick changes the colors, like dragging a slider
+        const int value = i % 256;
+        const QColor start(value, 128, 255 - value, 255);
+        const QColor end(255 - value, 64, value, 128);
+
+        timer.Reset();
+        char styleSheet[256];
+        sprintf(styleSheet, "background-color: qlineargradient(x1:0, y1:0.5, x2:1, y2:0.5, stop:0 rgba(%d, %d, %d, %d), stop:1 rgba(%d, %d, %d, %d))",
+            start.red(), start.green(), start.blue(), start.alpha(), end.red(), end.green(), end.blue(), end.alpha());
+        styledFrame->setStyleSheet(styleSheet);
+        styledFrame->repaint();
+        styledTime += timer.GetUSec(false);
+
+        timer.Reset();
+        paintedFrame->setColors(start, end);
+        paintedFrame->repaint();
+        paintedTime += timer.GetUSec(false);
+    }
+
+    char line[256];
+    sprintf(line, "%u color ticks", ticks);
+    PrintLine(line);
+    sprintf(line, "Style sheet: %10.3f ms total, %8.2f us per tick", styledTime / 1000.0, (double)styledTime / ticks);
+    PrintLine(line);
+    sprintf(line, "Painted:     %10.3f ms total, %8.2f us per tick", paintedTime / 1000.0, (double)paintedTime / ticks);
+    PrintLine(line);
+    sprintf(line, "Speedup:     %10.2fx", paintedTime ? (double)styledTime / paintedTime : 0.0);
+    PrintLine(line);
+
+    return 0;
+}
+
+unsigned BatchTool::PrintMemoryReport(const String& pathName, const Vector<SharedPtr<ParticleEffect2D> >& effects,
+    unsigned budgetBytes)
+{
+    struct Row
+    {
+        String fileName_;
+        EffectMemory memory_;
+    };
+
+    const String path = AddTrailingSlash(pathName);
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+    SharedPtr<SpritePreprocessor> preprocessor(new SpritePreprocessor(context_));
+    Vector<Row> rows;
+
+    for (const SharedPtr<ParticleEffect2D>& effect: effects)
+    {
+        EffectParams params;
+        ReadEffectParams(effect, params);
+
+        // The headless engine creates no GPU textures. Without one, count the sprite at the size the editor opens
+        // it with, downscaled by default.
+        unsigned textureMemory = 0;
+        Sprite2D* sprite = effect->GetSprite();
+        Texture2D* texture = sprite ? sprite->GetTexture() : nullptr;
+        if (texture && texture->GetWidth())
+            textureMemory = texture->GetMemoryUse();
+        else if (sprite)
+        {
+            const ProcessedSprite processed = preprocessor->Process(cache->GetResourceFileName(sprite->GetName()), params);
+            textureMemory = SpritePreprocessor::GetTextureMemory(processed.width_, processed.height_);
+        }
+
+        Row row;
+        row.fileName_ = effect->GetName().StartsWith(path) ? effect->GetName().Substring(path.Length()) : effect->GetName();
+        row.memory_ = EstimateEffectMemory((unsigned)params.Get(PARAM_MAX_PARTICLES), textureMemory);
+        rows.Push(row);
+    }
+
+    Sort(rows.Begin(), rows.End(), [](const Row& lhs, const Row& rhs) {
+        return lhs.memory_.GetTotal() > rhs.memory_.GetTotal();
+    });
+
+    // Each effect counted as if it owned its texture, as in a layer opened on its own
+    unsigned total = 0;
+    unsigned overBudget = 0;
+    char line[256];
+    PrintLine("   total KB  particles   vertices    texture  file");
+    for (const Row& row: rows)
+    {
+        const EffectMemory& memory = row.memory_;
+        const bool over = budgetBytes && memory.GetTotal() > budgetBytes;
+        sprintf(line, "%11.1f %10.1f %10.1f %10.1f  ", memory.GetTotal() / 1024.0, memory.particles_ / 1024.0,
+            memory.vertices_ / 1024.0, memory.texture_ / 1024.0);
+        PrintLine(String(line) + row.fileName_ + (over ? "  over budget" : ""));
+
+        total += memory.GetTotal();
+        if (over)
+            ++overBudget;
+    }
+
+    sprintf(line, "%u effects, %.1f KB total, largest %.1f KB", rows.Size(), total / 1024.0,
+        rows.Empty() ? 0.0 : rows[0].memory_.GetTotal() / 1024.0);
+    PrintLine(line);
+    if (budgetBytes)
+    {
+        sprintf(line, "%u effects over the budget of %u KB", overBudget, budgetBytes / 1024);
+        PrintLine(line);
+    }
+
+    return overBudget;
+}
+
+
+int BatchTool::Optimize(const String& pathName, float threshold, const String& outputPathName)
+{
+    Vector<String> fileNames;
+    GetSubsystem<FileSystem>()->ScanDir(fileNames, pathName, "*.pex", SCAN_FILES, true);
+    Sort(fileNames.Begin(), fileNames.End());
+
+    const String path = AddTrailingSlash(pathName);
+    SharedPtr<PexImporter> importer(new PexImporter(context_));
+    PexParser parser;
+    EffectOptimizerSettings settings;
+    settings.threshold_ = threshold;
+
+    float originalCost = 0.0f;
+    float optimizedCost = 0.0f;
+    unsigned improved = 0;
+    unsigned failed = 0;
+
+    for (const String& fileName: fileNames)
+    {
+        QFile file(QString::fromUtf8((path + fileName).CString()));
+        EffectParams params;
+        if (!file.open(QIODevice::ReadOnly))
+            continue;
+        const QByteArray data = file.readAll();
+        if (!parser.Parse(data.constData(), data.size(), params))
+        {
+            PrintLine(fileName + ": could not parse", true);
+            ++failed;
+            continue;
+        }
+
+        EffectOptimizer optimizer(params, LoadEffectSprite(path + fileName, params), settings);
+        EffectOptimizerResult result = optimizer.Optimize();
+        originalCost += result.originalCost_;
+        optimizedCost += result.cost_;
+        if (!result.IsImproved())
+        {
+            PrintLine(fileName + ": already lean");
+            continue;
+        }
+
+        ++improved;
+        PrintLine(fileName + ":\n    " + EffectOptimizer::GetSummary(params, result).Replaced("\n", "\n    "));
+
+        if (outputPathName.Empty())
+            continue;
+
+        // The proposal is written as a full effect, so the original importer path handles texture and defaults
+        SharedPtr<ParticleEffect2D> effect = importer->Import(path + fileName);
+        importer->ClearIssues();
+        const String outputFileName = AddTrailingSlash(outputPathName) + fileName;
+        GetSubsystem<FileSystem>()->CreateDir(GetPath(outputFileName));
+        File output(context_);
+        if (!effect || !output.Open(outputFileName, FILE_WRITE))
+        {
+            PrintLine(outputFileName + ": could not write", true);
+            ++failed;
+            continue;
+        }
+        ApplyEffectParams(effect, result.params_);
+        if (!effect->Save(output))
+        {
+            PrintLine(outputFileName + ": could not write", true);
+            ++failed;
+        }
+    }
+
+    char line[128];
+    sprintf(line, "%u of %u effects cheaper, total fill cost -%.0f%%", improved, fileNames.Size(),
+        originalCost > 0.0f ? 100.0f * (1.0f - optimizedCost / originalCost) : 0.0f);
+    PrintLine(line);
+
+    return failed ? 1 : 0;
+}
+
+
+int BatchTool::QueryStream(const String& fileName, const String& query, unsigned numBins)
+{
+    ParticleStreamReader reader;
+    if (!reader.Open(fileName))
+    {
+        PrintLine(fileName + ": not a particle stream", true);
+        return 1;
+    }
+
+    char line[256];
+    if (query == "counts")
+    {
+        PrintLine("time,simulated,written,emitter");
+        for (unsigned i = 0; i < reader.GetNumFrames(); ++i)
+        {
+            const ParticleStreamFrame& frame = reader.GetFrame(i);
+            sprintf(line, "%.4f,%u,%u,%u", frame.time_, frame.simulatedParticles_, frame.numParticles_, frame.emitterParticles_);
+            PrintLine(line);
+        }
+        return 0;
+    }
+
+    if (query == "bounds")
+    {
+        // Frames without particles have no bounds
+        PrintLine("time,minX,minY,maxX,maxY");
+        for (unsigned i = 0; i < reader.GetNumFrames(); ++i)
+        {
+            const ParticleStreamFrame& frame = reader.GetFrame(i);
+            if (!frame.simulatedParticles_)
+                continue;
+            sprintf(line, "%.4f,%.2f,%.2f,%.2f,%.2f", frame.time_, frame.min_.x_, frame.min_.y_, frame.max_.x_, frame.max_.y_);
+            PrintLine(line);
+        }
+        return 0;
+    }
+
+    for (unsigned i = 0; i < MAX_STREAM_VALUES; ++i)
+    {
+        if (query != STREAM_VALUE_NAMES[i])
+            continue;
+
+        PODVector<unsigned> counts;
+        float min, max;
+        if (!reader.GetHistogram((ParticleStreamValue)i, numBins, counts, min, max))
+        {
+            PrintLine(fileName + ": no particles recorded", true);
+            return 1;
+        }
+
+        const float binSize = (max - min) / counts.Size();
+        PrintLine("from,to,count");
+        for (unsigned j = 0; j < counts.Size(); ++j)
+        {
+            sprintf(line, "%.4f,%.4f,%u", min + binSize * j, min + binSize * (j + 1), counts[j]);
+            PrintLine(line);
+        }
+        return 0;
+    }
+
+    PrintLine("Unknown query " + query + ", expected counts, bounds, speed, size, rotation or ttl", true);
+    return 1;
+}
+
+}
@@ -0,0 +1,79 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include <Urho3D/Container/Ptr.h>
+#include <Urho3D/Core/Object.h>
+
+namespace Urho3D
+{
+
+class Engine;
+class ParticleEffect2D;
+
+/// Command line tools that run without the editor window.
+class BatchTool : public Object
+{
+    URHO3D_OBJECT(BatchTool, Object)
+
+public:
+    /// Construct.
+    BatchTool(Context* context);
+    /// Destruct.
+    virtual ~BatchTool();
+
+    /// Return whether the arguments start with a batch command.
+    static bool IsBatchCommand(const Vector<String>& arguments);
+    /// Run the command. Return process exit code.
+    int Run(const Vector<String>& arguments);
+
+private:
+    /// Initialize headless engine.
+    bool InitializeEngine();
+    /// Import every .pex file under the directory and report issues and memory. Fails on import errors or if any
+    /// effect exceeds a nonzero memory budget.
+    int Import(const String& pathName, unsigned budgetBytes);
+    /// Compare XMLFile and streaming import speed on every .pex file under the directory.
+    int BenchImport(const String& pathName, unsigned iterations);
+    /// Preprocess the textures of every .pex file under the directory and report memory saved.
+    int PreprocessSprites(const String& pathName, float scale);
+    /// Export every .pex file under the directory to a C++ header of constexpr tables.
+    int ExportHeader(const String& pathName, const String& headerFileName, const String& namespaceName);
+    /// Compare per tick cost of a style sheet and a painted color gradient preview.
+    int BenchColorPreview(unsigned ticks);
+    /// Print memory of effects imported from the directory, largest first. Return number of effects over a nonzero
+    /// budget.
+    unsigned PrintMemoryReport(const String& pathName, const Vector<SharedPtr<ParticleEffect2D> >& effects,
+        unsigned budgetBytes);
+    /// Propose cheaper parameters for every .pex file under the directory that look the same within the threshold.
+    /// Writes the proposals to the output directory if not empty.
+    int Optimize(const String& pathName, float threshold, const String& outputPathName);
+    /// Print a query of a recorded particle stream as CSV: particle counts or bounds over time, or the distribution
+    /// of a particle value.
+    int QueryStream(const String& fileName, const String& query, unsigned numBins);
+
+    /// Engine.
+    SharedPtr<Engine> engine_;
+};
+
+}
@@ -0,0 +1,73 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "ColorGradientFrame.h"
+
+#include <QLinearGradient>
+#include <QPainter>
+
+namespace Urho3D
+{
+
+ColorGradientFrame::ColorGradientFrame(QWidget* parent) :
+    QFrame(parent),
+    startColor_(Qt::transparent),
+    endColor_(Qt::transparent),
+    brush_(Qt::transparent)
+{
+    // Everything is covered by the gradient
+    setAttribute(Qt::WA_OpaquePaintEvent);
+}
+
+ColorGradientFrame::~ColorGradientFrame()
+{
+}
+
+void ColorGradientFrame::setColors(const QColor& start, const QColor& end)
+{
+    if (start == startColor_ && end == endColor_)
+        return;
+
+    startColor_ = start;
+    endColor_ = end;
+
+    // Bounding box coordinates keep the brush valid across resizes
+    QLinearGradient gradient(0.0, 0.5, 1.0, 0.5);
+    gradient.setCoordinateMode(QGradient::ObjectBoundingMode);
+    gradient.setColorAt(0.0, startColor_);
+    gradient.setColorAt(1.0, endColor_);
+    brush_ = QBrush(gradient);
+
+    update();
+}
+
+void ColorGradientFrame::paintEvent(QPaintEvent* event)
+{
+    QPainter painter(this);
+    painter.fillRect(rect(), palette().window());
+    painter.fillRect(rect(), brush_);
+    painter.end();
+
+    QFrame::paintEvent(event);
+}
+
+}
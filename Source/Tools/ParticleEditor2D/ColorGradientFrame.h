@@ -0,0 +1,55 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include <QBrush>
+#include <QColor>
+#include <QFrame>
+
+namespace Urho3D
+{
+
+/// Horizontal two color gradient, painted directly. Changing colors only repaints, nothing is re-polished.
+class ColorGradientFrame : public QFrame
+{
+public:
+    ColorGradientFrame(QWidget* parent = nullptr);
+    virtual ~ColorGradientFrame();
+
+    /// Set gradient colors. Repaints only if they changed.
+    void setColors(const QColor& start, const QColor& end);
+
+    const QColor& startColor() const { return startColor_; }
+    const QColor& endColor() const { return endColor_; }
+
+protected:
+    virtual void paintEvent(QPaintEvent* event);
+
+private:
+    QColor startColor_;
+    QColor endColor_;
+    /// Gradient brush, rebuilt when colors change.
+    QBrush brush_;
+};
+
+}
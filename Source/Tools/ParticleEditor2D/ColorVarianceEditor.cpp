@@ -20,6 +20,7 @@
 // THE SOFTWARE.
 //
 
+#include "ColorGradientFrame.h"
 #include "FloatEditor.h"
 #include "ColorVarianceEditor.h"
 #include <QComboBox>
@@ -43,10 +44,9 @@ ColorVarianceEditor::ColorVarianceEditor(const QString& text) :
 
     connect(colorModeComboBox_, SIGNAL(currentIndexChanged(int)), this, SLOT(colorModeComboBoxIndexChanged(int)));
 
-    frame_ = new QFrame();
+    frame_ = new ColorGradientFrame();
     vBoxLayout->addWidget(frame_);
     frame_->setFixedHeight(20);
-    frame_->setAutoFillBackground(true);
     
     minColorGroupBox_ = new QGroupBox(tr("Color 1"));
     vBoxLayout->addWidget(minColorGroupBox_);
@@ -112,14 +112,8 @@ void ColorVarianceEditor::editorValueChanged()
     if (colorModeComboBox_->currentIndex() == 0)
         max = min;
 
-    QColor qMinColor = QColor::fromRgbF(min.r_, min.g_, min.b_, min.a_);
-    QColor qMaxColor = QColor::fromRgbF(max.r_, max.g_, max.b_, max.a_);
-    char styleSheet[256];
-    sprintf(styleSheet, "background-color: qlineargradient(x1:0, y1:0.5, x2:1, y2:0.5, stop:0 rgba(%d, %d, %d, %d), stop:1 rgba(%d, %d, %d, %d))", 
-        qMinColor.red(), qMinColor.green(), qMinColor.blue(), qMinColor.alpha(),
-        qMaxColor.red(), qMaxColor.green(), qMaxColor.blue(), qMaxColor.alpha());
-
-    frame_->setStyleSheet(styleSheet);
+    // A plain repaint, a style sheet here would re-polish the frame on every slider tick
+    frame_->setColors(QColor::fromRgbF(min.r_, min.g_, min.b_, min.a_), QColor::fromRgbF(max.r_, max.g_, max.b_, max.a_));
 
     emit valueChanged((min + max) * 0.5f, (max - min) * 0.5f);
 }
@@ -26,10 +26,10 @@
 #include <QGroupBox>
 
 class QComboBox;
-class QFrame;
 
 namespace Urho3D
 {
+class ColorGradientFrame;
 class FloatEditor;
 
 class ColorVarianceEditor : public QGroupBox
@@ -59,7 +59,7 @@ private:
 
     QComboBox* colorModeComboBox_;
 
-    QFrame* frame_;
+    ColorGradientFrame* frame_;
 
     QGroupBox* minColorGroupBox_;
     FloatEditor* minREditor_;
@@ -0,0 +1,263 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "EditHistory.h"
+#include "EditQueue.h"
+#include "ParticleEditor.h"
+
+namespace Urho3D
+{
+
+/// Batches closer together than this merge into one, e.g. the ticks of one slider drag.
+static const unsigned MERGE_TIME_MS = 1000;
+/// Default memory limit.
+static const unsigned DEFAULT_MEMORY_LIMIT = 1024 * 1024;
+
+EditHistory::EditHistory(Context* context) :
+    Object(context),
+    position_(0),
+    memoryUse_(0),
+    memoryLimit_(DEFAULT_MEMORY_LIMIT),
+    nextBatch_(0),
+    batchDepth_(0),
+    sealed_(true)
+{
+}
+
+void EditHistory::BeginBatch()
+{
+    ++batchDepth_;
+}
+
+void EditHistory::EndBatch()
+{
+    if (!batchDepth_ || --batchDepth_ || batch_.empty())
+        return;
+
+    // Continue the last batch while the same parameters keep changing, keeping its old values
+    if (CanMergeBatch())
+    {
+        const unsigned start = entries_.size() - batch_.size();
+        for (unsigned i = 0; i < batch_.size(); ++i)
+        {
+            PODVector<float>& values = entries_[start + i].values_;
+            for (unsigned j = 1; j < values.Size(); j += 2)
+                values[j] = batch_[i].values_[j];
+        }
+    }
+    else
+    {
+        // A new edit discards everything that could be redone
+        while (entries_.size() > position_)
+        {
+            memoryUse_ -= GetEntrySize(entries_.back());
+            entries_.pop_back();
+        }
+
+        const unsigned batch = nextBatch_++;
+        for (unsigned i = 0; i < batch_.size(); ++i)
+        {
+            batch_[i].batch_ = batch;
+            batch_[i].values_.Compact();
+            memoryUse_ += GetEntrySize(batch_[i]);
+            entries_.push_back(batch_[i]);
+        }
+        position_ = entries_.size();
+        Trim();
+    }
+
+    batch_.clear();
+    mergeTimer_.Reset();
+    sealed_ = false;
+
+    emit changed();
+}
+
+void EditHistory::Record(LayerHandle layer, unsigned long long mask, const float* oldValues, const float* newValues)
+{
+    if (!mask)
+        return;
+
+    BeginBatch();
+
+    batch_.push_back(Entry());
+    Entry& entry = batch_.back();
+    entry.batch_ = 0;
+    entry.layer_ = layer;
+    entry.mask_ = mask;
+    for (unsigned i = 0; i < MAX_EFFECT_PARAMS; ++i)
+    {
+        if (mask & (1ULL << i))
+        {
+            entry.values_.Push(oldValues[i]);
+            entry.values_.Push(newValues[i]);
+        }
+    }
+
+    EndBatch();
+}
+
+bool EditHistory::Undo()
+{
+    // Edits of the current frame belong to the history first
+    ParticleEditor::Get()->GetEditQueue()->Flush();
+    sealed_ = true;
+
+    QVector<unsigned> layers;
+    while (position_ > 0 && layers.isEmpty())
+    {
+        // Restore the whole batch, newest entry first; entries of removed layers are skipped
+        const unsigned batch = entries_[position_ - 1].batch_;
+        while (position_ > 0 && entries_[position_ - 1].batch_ == batch)
+        {
+            const Entry& entry = entries_[--position_];
+            if (Restore(entry, true) && !layers.contains(entry.layer_))
+                layers << entry.layer_;
+        }
+    }
+
+    return NotifyRestored(layers);
+}
+
+bool EditHistory::Redo()
+{
+    ParticleEditor::Get()->GetEditQueue()->Flush();
+    sealed_ = true;
+
+    QVector<unsigned> layers;
+    while (position_ < entries_.size() && layers.isEmpty())
+    {
+        const unsigned batch = entries_[position_].batch_;
+        while (position_ < entries_.size() && entries_[position_].batch_ == batch)
+        {
+            const Entry& entry = entries_[position_++];
+            if (Restore(entry, false) && !layers.contains(entry.layer_))
+                layers << entry.layer_;
+        }
+    }
+
+    return NotifyRestored(layers);
+}
+
+void EditHistory::Clear()
+{
+    entries_.clear();
+    position_ = 0;
+    memoryUse_ = 0;
+    sealed_ = true;
+    emit changed();
+}
+
+void EditHistory::SetMemoryLimit(unsigned bytes)
+{
+    memoryLimit_ = bytes;
+    Trim();
+    emit changed();
+}
+
+bool EditHistory::Restore(const Entry& entry, bool undo)
+{
+    float values[MAX_EFFECT_PARAMS];
+    unsigned j = undo ? 0 : 1;
+    for (unsigned i = 0; i < MAX_EFFECT_PARAMS; ++i)
+    {
+        if (entry.mask_ & (1ULL << i))
+        {
+            values[i] = entry.values_[j];
+            j += 2;
+        }
+    }
+
+    // Parameters are set on the live effect, the emitter and its particles stay as they are
+    return ParticleEditor::Get()->GetEditQueue()->Apply(entry.layer_, entry.mask_, values);
+}
+
+bool EditHistory::NotifyRestored(const QVector<unsigned>& layers)
+{
+    // One dirty update and one widget refresh for the whole batch
+    ParticleEditor::Get()->GetEditQueue()->NotifyApplied(layers);
+    if (!layers.isEmpty())
+        emit restored(layers);
+    emit changed();
+    return !layers.isEmpty();
+}
+
+bool EditHistory::CanMergeBatch()
+{
+    if (sealed_ || position_ != entries_.size() || mergeTimer_.GetMSec(false) >= MERGE_TIME_MS)
+        return false;
+    if (GetBatchSize(false) != batch_.size())
+        return false;
+
+    const unsigned start = entries_.size() - batch_.size();
+    for (unsigned i = 0; i < batch_.size(); ++i)
+    {
+        if (entries_[start + i].layer_ != batch_[i].layer_ || entries_[start + i].mask_ != batch_[i].mask_)
+            return false;
+    }
+    return true;
+}
+
+unsigned EditHistory::GetBatchSize(bool front) const
+{
+    if (entries_.empty())
+        return 0;
+
+    const unsigned batch = front ? entries_.front().batch_ : entries_.back().batch_;
+    unsigned size = 0;
+    if (front)
+    {
+        while (size < entries_.size() && entries_[size].batch_ == batch)
+            ++size;
+    }
+    else
+    {
+        while (size < entries_.size() && entries_[entries_.size() - 1 - size].batch_ == batch)
+            ++size;
+    }
+    return size;
+}
+
+unsigned EditHistory::GetEntrySize(const Entry& entry)
+{
+    return sizeof(Entry) + entry.values_.Capacity() * sizeof(float);
+}
+
+void EditHistory::Trim()
+{
+    // Only applied batches are dropped, and the newest one is kept so the last edit can always be undone
+    while (memoryUse_ > memoryLimit_)
+    {
+        const unsigned size = GetBatchSize(true);
+        if (position_ <= size)
+            break;
+
+        for (unsigned i = 0; i < size; ++i)
+        {
+            memoryUse_ -= GetEntrySize(entries_.front());
+            entries_.pop_front();
+        }
+        position_ -= size;
+    }
+}
+
+}
@@ -0,0 +1,132 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "EffectParams.h"
+#include "LayerTable.h"
+
+#include <Urho3D/Container/Vector.h>
+#include <Urho3D/Core/Object.h>
+#include <Urho3D/Core/Timer.h>
+
+#include <QObject>
+#include <QVector>
+
+#include <deque>
+
+namespace Urho3D
+{
+
+/// Undo and redo of parameter edits. Entries keep only the changed parameters of one layer and are grouped into
+/// batches that undo together, e.g. one edit of several selected layers. Consecutive batches changing the same
+/// parameters merge into one, and the oldest batches are dropped once the memory limit is reached.
+class EditHistory : public QObject, public Object
+{
+    Q_OBJECT
+    URHO3D_OBJECT(EditHistory, Object)
+
+public:
+    /// Construct.
+    EditHistory(Context* context);
+
+    /// Start collecting records into one batch.
+    void BeginBatch();
+    /// Finish batch and merge it into the last one if it changed the same parameters of the same layers.
+    void EndBatch();
+    /// Record change of the parameters in mask. Values are indexed by parameter. Outside BeginBatch and EndBatch
+    /// the record is a batch of its own.
+    void Record(LayerHandle layer, unsigned long long mask, const float* oldValues, const float* newValues);
+    /// Start a new entry with the next record instead of merging.
+    void Seal() { sealed_ = true; }
+    /// Undo last batch. Return true if something was restored.
+    bool Undo();
+    /// Redo next batch. Return true if something was restored.
+    bool Redo();
+    /// Remove all entries.
+    void Clear();
+    /// Set memory limit in bytes.
+    void SetMemoryLimit(unsigned bytes);
+
+    /// Return whether there is something to undo.
+    bool CanUndo() const { return position_ > 0; }
+    /// Return whether there is something to redo.
+    bool CanRedo() const { return position_ < entries_.size(); }
+    /// Return memory limit in bytes.
+    unsigned GetMemoryLimit() const { return memoryLimit_; }
+    /// Return memory used by entries in bytes.
+    unsigned GetMemoryUse() const { return memoryUse_; }
+
+signals:
+    /// Emitted when undo or redo availability may have changed.
+    void changed();
+    /// Emitted once after undo or redo restored parameters of layers.
+    void restored(const QVector<unsigned>& layers);
+
+private:
+    /// Change of some parameters of one layer.
+    struct Entry
+    {
+        /// Batch id.
+        unsigned batch_;
+        /// Layer.
+        LayerHandle layer_;
+        /// Bit per changed parameter.
+        unsigned long long mask_;
+        /// Old and new value of each changed parameter, in parameter order.
+        PODVector<float> values_;
+    };
+
+    /// Apply old or new values of entry. Return false if the layer is gone.
+    bool Restore(const Entry& entry, bool undo);
+    /// Notify about layers restored by undo or redo. Return true if there were any.
+    bool NotifyRestored(const QVector<unsigned>& layers);
+    /// Return whether the collected batch changes the same parameters of the same layers as the last one.
+    bool CanMergeBatch();
+    /// Return number of entries in batch starting at front or ending at back.
+    unsigned GetBatchSize(bool front) const;
+    /// Return memory used by entry.
+    static unsigned GetEntrySize(const Entry& entry);
+    /// Drop oldest entries beyond the memory limit.
+    void Trim();
+
+    /// Entries, oldest first.
+    std::deque<Entry> entries_;
+    /// Number of entries that are applied, the rest can be redone.
+    unsigned position_;
+    /// Memory used by entries.
+    unsigned memoryUse_;
+    /// Memory limit.
+    unsigned memoryLimit_;
+    /// Entries of the batch being collected.
+    std::deque<Entry> batch_;
+    /// Id of the next batch.
+    unsigned nextBatch_;
+    /// Nesting depth of BeginBatch.
+    unsigned batchDepth_;
+    /// Do not merge into the last batch.
+    bool sealed_;
+    /// Time since the last batch.
+    Timer mergeTimer_;
+};
+
+}
@@ -0,0 +1,172 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "EditHistory.h"
+#include "EditQueue.h"
+#include "ParticleEditor.h"
+#include "TraceRecorder.h"
+
+#include <Urho3D/Core/CoreEvents.h>
+#include <Urho3D/Urho2D/ParticleEffect2D.h>
+#include <Urho3D/Urho2D/ParticleEmitter2D.h>
+
+namespace Urho3D
+{
+
+static_assert(MAX_EFFECT_PARAMS <= 64, "Pending edit mask is too small");
+
+EditQueue::EditQueue(Context* context) :
+    Object(context)
+{
+    SubscribeToEvent(E_BEGINFRAME, URHO3D_HANDLER(EditQueue, HandleBeginFrame));
+}
+
+void EditQueue::Set(LayerHandle layer, EffectParam param, float value)
+{
+    HashMap<LayerHandle, PendingEdits>::Iterator it = pending_.Find(layer);
+    if (it == pending_.End())
+    {
+        it = pending_.Insert(MakePair(layer, PendingEdits()));
+        it->second_.mask_ = 0;
+    }
+
+    it->second_.mask_ |= 1ULL << param;
+    it->second_.values_[param] = value;
+}
+
+void EditQueue::SetVector2(LayerHandle layer, EffectParam x, const Vector2& value)
+{
+    Set(layer, x, value.x_);
+    Set(layer, (EffectParam)(x + 1), value.y_);
+}
+
+void EditQueue::SetColor(LayerHandle layer, EffectParam r, const Color& value)
+{
+    Set(layer, r, value.r_);
+    Set(layer, (EffectParam)(r + 1), value.g_);
+    Set(layer, (EffectParam)(r + 2), value.b_);
+    Set(layer, (EffectParam)(r + 3), value.a_);
+}
+
+void EditQueue::Offset(LayerHandle layer, EffectParam param, float delta)
+{
+    Set(layer, param, GetValue(layer, param) + delta);
+}
+
+float EditQueue::GetValue(LayerHandle layer, EffectParam param) const
+{
+    HashMap<LayerHandle, PendingEdits>::ConstIterator it = pending_.Find(layer);
+    if (it != pending_.End() && (it->second_.mask_ & (1ULL << param)))
+        return it->second_.values_[param];
+
+    const ParticleEffect2D* effect = ParticleEditor::Get()->GetEffect(layer);
+    return effect ? GetEffectParam(effect, param) : 0.0f;
+}
+
+void EditQueue::MarkChanged(LayerHandle layer)
+{
+    HashMap<LayerHandle, PendingEdits>::Iterator it = pending_.Find(layer);
+    if (it == pending_.End())
+        pending_.Insert(MakePair(layer, PendingEdits()))->second_.mask_ = 0;
+}
+
+void EditQueue::Flush()
+{
+    if (pending_.Empty())
+        return;
+
+    EDITOR_TRACE("EditQueue::Flush");
+
+    // Everything edited in one frame is one undo step
+    EditHistory* history = ParticleEditor::Get()->GetEditHistory();
+    history->BeginBatch();
+    QVector<unsigned> layers;
+    float oldValues[MAX_EFFECT_PARAMS];
+
+    for (HashMap<LayerHandle, PendingEdits>::ConstIterator it = pending_.Begin(); it != pending_.End(); ++it)
+    {
+        const LayerHandle layer = it->first_;
+        const PendingEdits& edits = it->second_;
+
+        // One lookup per layer and frame, however many slider ticks arrived
+        if (!ApplyEdits(layer, edits.mask_, edits.values_, oldValues))
+            continue;
+
+        if (edits.mask_)
+            history->Record(layer, edits.mask_, oldValues, edits.values_);
+        layers << layer;
+    }
+
+    pending_.Clear();
+    history->EndBatch();
+    emit applied(layers);
+}
+
+bool EditQueue::Apply(LayerHandle layer, unsigned long long mask, const float* values)
+{
+    return ApplyEdits(layer, mask, values, nullptr);
+}
+
+void EditQueue::NotifyApplied(const QVector<unsigned>& layers)
+{
+    if (!layers.isEmpty())
+        emit applied(layers);
+}
+
+bool EditQueue::ApplyEdits(LayerHandle layer, unsigned long long mask, const float* values, float* oldValues)
+{
+    ParticleEditor* editor = ParticleEditor::Get();
+    ParticleEffect2D* effect = mask ? editor->GetEffectForEdit(layer) : editor->GetEffect(layer);
+    if (!effect)
+        return false;
+
+    for (unsigned i = 0; i < MAX_EFFECT_PARAMS; ++i)
+    {
+        if (!(mask & (1ULL << i)))
+            continue;
+        if (oldValues)
+            oldValues[i] = GetEffectParam(effect, (EffectParam)i);
+        SetEffectParam(effect, (EffectParam)i, values[i]);
+    }
+
+    // The emitter keeps its own copy of these
+    const unsigned long long emitterMask = (1ULL << PARAM_MAX_PARTICLES) | (1ULL << PARAM_BLEND_MODE);
+    if (mask & emitterMask)
+    {
+        if (ParticleEmitter2D* emitter = editor->GetEmitter(layer))
+        {
+            if (mask & (1ULL << PARAM_MAX_PARTICLES))
+                emitter->SetMaxParticles(effect->GetMaxParticles());
+            if (mask & (1ULL << PARAM_BLEND_MODE))
+                emitter->SetBlendMode(effect->GetBlendMode());
+        }
+    }
+
+    return true;
+}
+
+void EditQueue::HandleBeginFrame(StringHash eventType, VariantMap& eventData)
+{
+    Flush();
+}
+
+}
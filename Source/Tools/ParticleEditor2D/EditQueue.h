@@ -0,0 +1,95 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "EffectParams.h"
+#include "LayerTable.h"
+
+#include <Urho3D/Container/HashMap.h>
+#include <Urho3D/Core/Object.h>
+
+#include <QObject>
+#include <QVector>
+
+namespace Urho3D
+{
+
+/// Collects parameter edits from all attribute editors and applies them once per frame. Repeated edits of the same
+/// parameter of a layer overwrite each other, so dragging a slider costs at most one apply per layer and frame.
+class EditQueue : public QObject, public Object
+{
+    Q_OBJECT
+    URHO3D_OBJECT(EditQueue, Object)
+
+public:
+    /// Construct.
+    EditQueue(Context* context);
+
+    /// Queue parameter change.
+    void Set(LayerHandle layer, EffectParam param, float value);
+    /// Queue change of two consecutive parameters.
+    void SetVector2(LayerHandle layer, EffectParam x, const Vector2& value);
+    /// Queue change of four consecutive parameters.
+    void SetColor(LayerHandle layer, EffectParam r, const Color& value);
+    /// Queue parameter change by offset from its latest value.
+    void Offset(LayerHandle layer, EffectParam param, float delta);
+    /// Report a change that was applied directly, e.g. a new sprite, with the next notification.
+    void MarkChanged(LayerHandle layer);
+    /// Return latest value of parameter, queued or applied.
+    float GetValue(LayerHandle layer, EffectParam param) const;
+
+    /// Apply queued changes now.
+    void Flush();
+    /// Apply parameters in mask immediately without recording them in the edit history, e.g. to undo. Values are
+    /// indexed by parameter. Call NotifyApplied once for all layers afterwards.
+    bool Apply(LayerHandle layer, unsigned long long mask, const float* values);
+    /// Emit applied for layers changed by Apply.
+    void NotifyApplied(const QVector<unsigned>& layers);
+    /// Return whether nothing is queued.
+    bool IsEmpty() const { return pending_.Empty(); }
+
+signals:
+    /// Emitted once per frame, or once per undo step, with every layer changed during it.
+    void applied(const QVector<unsigned>& layers);
+
+private:
+    /// Handle begin frame, apply before the scene update.
+    void HandleBeginFrame(StringHash eventType, VariantMap& eventData);
+
+    /// Apply parameters in mask to layer. Store previous values if oldValues is not null.
+    bool ApplyEdits(LayerHandle layer, unsigned long long mask, const float* values, float* oldValues);
+
+    /// Changes queued for one layer.
+    struct PendingEdits
+    {
+        /// Bit per changed parameter.
+        unsigned long long mask_;
+        /// Latest values.
+        float values_[MAX_EFFECT_PARAMS];
+    };
+
+    /// Pending changes by layer.
+    HashMap<LayerHandle, PendingEdits> pending_;
+};
+
+}
@@ -0,0 +1,329 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "EffectHeaderExporter.h"
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/IO/File.h>
+#include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/Urho2D/ParticleEffect2D.h>
+
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace Urho3D
+{
+
+/// Return parameter name as a C++ field name, e.g. maxParticles.
+static String GetFieldName(EffectParam param)
+{
+    String name(GetEffectParamName(param));
+    name[0] = (char)tolower(name[0]);
+    return name;
+}
+
+/// Return whether the parameter is stored as int.
+static bool IsIntParam(EffectParam param)
+{
+    return param == PARAM_MAX_PARTICLES || param == PARAM_EMITTER_TYPE || param == PARAM_BLEND_MODE;
+}
+
+/// Return number of consecutive parameters set together: 2 for vectors, 4 for colors.
+static unsigned GetParamGroupSize(EffectParam param)
+{
+    switch (param)
+    {
+    case PARAM_SOURCE_POSITION_VARIANCE_X:
+    case PARAM_GRAVITY_X:
+        return 2;
+
+    case PARAM_START_COLOR_R:
+    case PARAM_START_COLOR_VARIANCE_R:
+    case PARAM_FINISH_COLOR_R:
+    case PARAM_FINISH_COLOR_VARIANCE_R:
+        return 4;
+
+    default:
+        return 1;
+    }
+}
+
+/// Format float so that it parses back to the same bits, as a C++ float literal.
+static String FormatFloat(float value)
+{
+    String result = FormatNumber(value, 'g', 9);
+    if (!result.Contains('.') && !result.Contains('e'))
+        result += ".0";
+    return result + "f";
+}
+
+/// Format parameter value as written to the header.
+static String FormatParam(EffectParam param, float value)
+{
+    return IsIntParam(param) ? String((int)value) : FormatFloat(value);
+}
+
+/// Parse parameter value as a compiler would read it from the header. Return NaN if it does not parse, so that it
+/// never matches.
+static float ParseParam(const String& text)
+{
+    // The f suffix is part of the literal for a compiler, toFloat rejects any trailing character
+    const unsigned length = text.EndsWith("f") ? text.Length() - 1 : text.Length();
+    double value;
+    return ParseNumber(text.CString(), length, value) ? (float)value : std::numeric_limits<float>::quiet_NaN();
+}
+
+/// Return string as a C++ string literal.
+static String QuoteString(const String& value)
+{
+    String result("\"");
+    for (unsigned i = 0; i < value.Length(); ++i)
+    {
+        char c = value[i];
+        if (c == '"' || c == '\\')
+            result += '\\';
+        result += c;
+    }
+    return result + "\"";
+}
+
+EffectHeaderExporter::EffectHeaderExporter(Context* context) :
+    Object(context)
+{
+}
+
+bool EffectHeaderExporter::AddEffect(const String& name, const String& fileName, const EffectParams& params)
+{
+    // inf and nan have no C++ literal
+    for (unsigned i = 0; i < MAX_EFFECT_PARAMS; ++i)
+    {
+        if (!std::isfinite(params.values_[i]))
+            return false;
+    }
+
+    ExportedEffect effect;
+    effect.fileName_ = fileName;
+    effect.params_ = params;
+
+    String identifier;
+    for (unsigned i = 0; i < name.Length(); ++i)
+        identifier += isalnum((unsigned char)name[i]) ? name[i] : '_';
+    if (identifier.Empty() || isdigit((unsigned char)identifier[0]))
+        identifier = "effect_" + identifier;
+
+    // Keep identifiers unique, e.g. fire.pex in two directories
+    effect.identifier_ = identifier;
+    for (unsigned suffix = 2; ; ++suffix)
+    {
+        bool unique = true;
+        for (const ExportedEffect& other: effects_)
+        {
+            if (other.identifier_ == effect.identifier_)
+            {
+                unique = false;
+                break;
+            }
+        }
+        if (unique)
+            break;
+        effect.identifier_ = identifier + "_" + String(suffix);
+    }
+
+    effects_.Push(effect);
+    return true;
+}
+
+String EffectHeaderExporter::Generate(const String& namespaceName) const
+{
+    String guard = namespaceName.ToUpper() + "_NO_URHO3D";
+    String text;
+
+    text += "// Generated by ParticleEditor2D from " + String(effects_.Size()) + " effects. Do not edit.\n\n";
+    text += "#pragma once\n\n";
+    text += "#ifndef " + guard + "\n";
+    text += "#include <Urho3D/Core/Context.h>\n";
+    text += "#include <Urho3D/Resource/ResourceCache.h>\n";
+    text += "#include <Urho3D/Urho2D/ParticleEffect2D.h>\n";
+    text += "#include <Urho3D/Urho2D/Sprite2D.h>\n";
+    text += "#endif\n\n";
+    text += "namespace " + namespaceName + "\n{\n\n";
+
+    text += "/// Number of lifetime table samples, from birth to death.\n";
+    text += "constexpr unsigned LIFETIME_SAMPLES = " + String(LIFETIME_SAMPLES) + ";\n\n";
+
+    text += "/// Particle effect parameters, with the same meaning as in ParticleEffect2D.\n";
+    text += "struct EffectData\n{\n";
+    text += "    const char* name;\n";
+    text += "    /// Source effect file relative to the exported directory.\n";
+    text += "    const char* file;\n";
+    text += "    /// Texture file name relative to the effect.\n";
+    text += "    const char* texture;\n";
+    for (unsigned i = 0; i < MAX_EFFECT_PARAMS; ++i)
+    {
+        EffectParam param = (EffectParam)i;
+        text += String("    ") + (IsIntParam(param) ? "int " : "float ") + GetFieldName(param) + ";\n";
+    }
+    text += "    /// Average particle size over lifetime.\n";
+    text += "    float size[LIFETIME_SAMPLES];\n";
+    text += "    /// Average particle color over lifetime, RGBA.\n";
+    text += "    float color[LIFETIME_SAMPLES][4];\n";
+    text += "    /// Average particle rotation over lifetime in degrees.\n";
+    text += "    float rotation[LIFETIME_SAMPLES];\n";
+    text += "};\n\n";
+
+    for (const ExportedEffect& effect: effects_)
+    {
+        const EffectParams& params = effect.params_;
+
+        text += "constexpr EffectData " + effect.identifier_ + " =\n{\n";
+        text += "    " + QuoteString(effect.identifier_) + ",\n";
+        text += "    " + QuoteString(effect.fileName_) + ",\n";
+        text += "    " + QuoteString(params.texture_) + ",\n";
+        for (unsigned i = 0; i < MAX_EFFECT_PARAMS; ++i)
+            text += "    " + FormatParam((EffectParam)i, params.values_[i]) + ", // " + GetFieldName((EffectParam)i) + "\n";
+
+        // Averages interpolate linearly from start to finish, as ParticleEmitter2D does per particle
+        const float startSize = params.Get(PARAM_START_PARTICLE_SIZE);
+        const float finishSize = params.Get(PARAM_FINISH_PARTICLE_SIZE);
+        const Color startColor = params.GetColor(PARAM_START_COLOR_R);
+        const Color finishColor = params.GetColor(PARAM_FINISH_COLOR_R);
+        const float startRotation = params.Get(PARAM_ROTATION_START);
+        const float finishRotation = params.Get(PARAM_ROTATION_END);
+
+        String sizes, colors, rotations;
+        for (unsigned i = 0; i < LIFETIME_SAMPLES; ++i)
+        {
+            const float t = (float)i / (LIFETIME_SAMPLES - 1);
+            const Color color = startColor.Lerp(finishColor, t);
+            const String separator = i + 1 < LIFETIME_SAMPLES ? ", " : "";
+            sizes += FormatFloat(Lerp(startSize, finishSize, t)) + separator;
+            colors += "{ " + FormatFloat(color.r_) + ", " + FormatFloat(color.g_) + ", " + FormatFloat(color.b_) + ", " +
+                FormatFloat(color.a_) + " }" + separator;
+            rotations += FormatFloat(Lerp(startRotation, finishRotation, t)) + separator;
+        }
+        text += "    { " + sizes + " },\n";
+        text += "    { " + colors + " },\n";
+        text += "    { " + rotations + " }\n";
+        text += "};\n\n";
+    }
+
+    text += "/// All effects.\n";
+    text += "constexpr const EffectData* EFFECTS[] =\n{\n";
+    for (const ExportedEffect& effect: effects_)
+        text += "    &" + effect.identifier_ + ",\n";
+    // Zero-length arrays do not compile, NUM_EFFECTS still says 0
+    if (effects_.Empty())
+        text += "    nullptr\n";
+    text += "};\n\n";
+    text += "/// Number of effects.\n";
+    text += "constexpr unsigned NUM_EFFECTS = " + String(effects_.Size()) + ";\n\n";
+
+    // Setters grouped the same way ParticleEffect2D exposes them
+    text += "#ifndef " + guard + "\n";
+    text += "/// Apply parameters to effect. The sprite is left untouched.\n";
+    text += "inline void ApplyEffectData(Urho3D::ParticleEffect2D* effect, const EffectData& data)\n{\n";
+    for (unsigned i = 0; i < MAX_EFFECT_PARAMS; i += GetParamGroupSize((EffectParam)i))
+    {
+        const EffectParam param = (EffectParam)i;
+        const unsigned groupSize = GetParamGroupSize(param);
+        String setter = String("Set") + GetEffectParamName(param);
+
+        String value;
+        if (param == PARAM_EMITTER_TYPE)
+            value = "(Urho3D::EmitterType2D)data." + GetFieldName(param);
+        else if (param == PARAM_BLEND_MODE)
+            value = "(Urho3D::BlendMode)data." + GetFieldName(param);
+        else if (groupSize == 1)
+            value = "data." + GetFieldName(param);
+        else
+        {
+            // Drop the component suffix, e.g. SetGravityX -> SetGravity
+            setter.Resize(setter.Length() - 1);
+            value = groupSize == 2 ? "Urho3D::Vector2(" : "Urho3D::Color(";
+            for (unsigned j = 0; j < groupSize; ++j)
+                value += (j ? ", data." : "data.") + GetFieldName((EffectParam)(i + j));
+            value += ")";
+        }
+        text += "    effect->" + setter + "(" + value + ");\n";
+    }
+    text += "}\n\n";
+
+    text += "/// Create effect. The sprite is loaded from the resource cache as texturePath + data.texture.\n";
+    text += "inline Urho3D::SharedPtr<Urho3D::ParticleEffect2D> CreateEffect(Urho3D::Context* context, const EffectData& data,\n";
+    text += "    const Urho3D::String& texturePath = Urho3D::String::EMPTY)\n{\n";
+    text += "    Urho3D::SharedPtr<Urho3D::ParticleEffect2D> effect(new Urho3D::ParticleEffect2D(context));\n";
+    text += "    effect->SetName(data.name);\n";
+    text += "    ApplyEffectData(effect, data);\n";
+    text += "    if (*data.texture)\n";
+    text += "        effect->SetSprite(context->GetSubsystem<Urho3D::ResourceCache>()->GetResource<Urho3D::Sprite2D>(texturePath + data.texture));\n";
+    text += "    return effect;\n";
+    text += "}\n";
+    text += "#endif\n\n";
+
+    text += "}\n";
+    return text;
+}
+
+bool EffectHeaderExporter::Save(const String& fileName, const String& namespaceName) const
+{
+    File file(context_);
+    if (!file.Open(fileName, FILE_WRITE))
+        return false;
+
+    String text = Generate(namespaceName);
+    return file.Write(text.CString(), text.Length()) == text.Length();
+}
+
+bool EffectHeaderExporter::Verify(String& report) const
+{
+    unsigned mismatches = 0;
+    SharedPtr<ParticleEffect2D> effect(new ParticleEffect2D(context_));
+
+    for (const ExportedEffect& exported: effects_)
+    {
+        // Read back the literals, then go through the same setters as the generated ApplyEffectData
+        EffectParams written;
+        for (unsigned i = 0; i < MAX_EFFECT_PARAMS; ++i)
+            written.values_[i] = ParseParam(FormatParam((EffectParam)i, exported.params_.values_[i]));
+
+        ApplyEffectParams(effect, written);
+        EffectParams applied;
+        ReadEffectParams(effect, applied);
+
+        for (unsigned i = 0; i < MAX_EFFECT_PARAMS; ++i)
+        {
+            const float expected = exported.params_.values_[i];
+            if (memcmp(&applied.values_[i], &expected, sizeof(float)) != 0)
+            {
+                report += exported.identifier_ + "." + GetFieldName((EffectParam)i) + ": expected " + String(expected) +
+                    ", got " + String(applied.values_[i]) + "\n";
+                ++mismatches;
+            }
+        }
+    }
+
+    return mismatches == 0;
+}
+
+}
@@ -0,0 +1,76 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "EffectParams.h"
+
+#include <Urho3D/Core/Object.h>
+
+namespace Urho3D
+{
+
+/// Writes effects as a C++ header of constexpr tables, so a game can embed them without parsing .pex files at
+/// runtime. Besides the parameters, each effect gets average size, color and rotation sampled over its lifetime.
+class EffectHeaderExporter : public Object
+{
+    URHO3D_OBJECT(EffectHeaderExporter, Object)
+
+public:
+    /// Construct.
+    EffectHeaderExporter(Context* context);
+
+    /// Add effect. The name is turned into a unique C++ identifier, the file name is written as is. Return false if
+    /// a parameter is infinite or NaN, which a header cannot hold.
+    bool AddEffect(const String& name, const String& fileName, const EffectParams& params);
+    /// Return number of effects.
+    unsigned GetNumEffects() const { return effects_.Size(); }
+
+    /// Return header text.
+    String Generate(const String& namespaceName) const;
+    /// Write header. Return true on success.
+    bool Save(const String& fileName, const String& namespaceName) const;
+    /// Check that the written values read back and applied to a ParticleEffect2D give the original parameters.
+    /// Return true if all effects round-trip exactly, otherwise describe the mismatches. This is a quick check before
+    /// saving, Test/EffectHeaderExporterTest.cpp compiles a generated header against the source effects.
+    bool Verify(String& report) const;
+
+    /// Number of lifetime samples per table.
+    static const unsigned LIFETIME_SAMPLES = 16;
+
+private:
+    /// Effect to export.
+    struct ExportedEffect
+    {
+        /// C++ identifier.
+        String identifier_;
+        /// Source file name.
+        String fileName_;
+        /// Parameters.
+        EffectParams params_;
+    };
+
+    /// Effects.
+    Vector<ExportedEffect> effects_;
+};
+
+}
@@ -0,0 +1,189 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "EffectLibrary.h"
+#include "PexParser.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+
+#include <algorithm>
+
+namespace
+{
+const quint32 INDEX_MAGIC = 0x50494458; // "PIDX", QDataStream writes big-endian
+const quint32 INDEX_VERSION = 1;
+}
+
+namespace Urho3D
+{
+
+bool EffectLibrary::Load(const QString& indexPath)
+{
+    QFile file(indexPath);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream stream(&file);
+    quint32 magic, version, count;
+    stream >> magic >> version >> count;
+    if (magic != INDEX_MAGIC || version != INDEX_VERSION || stream.status() != QDataStream::Ok)
+        return false;
+
+    // Every entry takes at least its fixed fields and the empty string and hash lengths, so a corrupt count cannot
+    // ask for more entries than the file holds
+    const qint64 minEntrySize = 3 * sizeof(quint32) + 2 * sizeof(qint64) + sizeof(EffectParams::values_);
+    if (count > file.bytesAvailable() / minEntrySize)
+        return false;
+
+    std::vector<EffectLibraryEntry> entries(count);
+    for (EffectLibraryEntry& entry: entries) {
+        QString texture;
+        stream >> entry.path_ >> entry.modified_ >> entry.size_ >> entry.hash_ >> texture;
+        stream.readRawData(reinterpret_cast<char*>(entry.params_.values_), sizeof(entry.params_.values_));
+        entry.params_.texture_ = texture.toUtf8().constData();
+        entry.cost_ = EstimateEffectCost(entry.params_);
+    }
+
+    if (stream.status() != QDataStream::Ok)
+        return false;
+
+    entries_.swap(entries);
+    return true;
+}
+
+bool EffectLibrary::Save(const QString& indexPath) const
+{
+    QFile file(indexPath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    QDataStream stream(&file);
+    stream << INDEX_MAGIC << INDEX_VERSION << quint32(entries_.size());
+    for (const EffectLibraryEntry& entry: entries_) {
+        stream << entry.path_ << entry.modified_ << entry.size_ << entry.hash_ << QString(entry.params_.texture_.CString());
+        stream.writeRawData(reinterpret_cast<const char*>(entry.params_.values_), sizeof(entry.params_.values_));
+    }
+    return stream.status() == QDataStream::Ok;
+}
+
+unsigned EffectLibrary::Refresh(const QStringList& roots)
+{
+    QHash<QString, unsigned> known;
+    for (unsigned i = 0; i < entries_.size(); ++i)
+        known.insert(entries_[i].path_, i);
+
+    std::vector<EffectLibraryEntry> entries;
+    entries.reserve(entries_.size());
+    unsigned parsed = 0;
+
+    for (const QString& root: roots) {
+        QDirIterator it(root, QStringList("*.pex"), QDir::Files, QDirIterator::Subdirectories);
+        while (it.hasNext()) {
+            QFileInfo info(it.next());
+            QString path = info.absoluteFilePath();
+            qint64 modified = info.lastModified().toMSecsSinceEpoch();
+            qint64 size = info.size();
+
+            auto knownIt = known.find(path);
+            if (knownIt != known.end()) {
+                const EffectLibraryEntry& old = entries_[knownIt.value()];
+                if (old.modified_ == modified && old.size_ == size) {
+                    entries.push_back(old);
+                    continue;
+                }
+            }
+
+            QFile file(path);
+            if (!file.open(QIODevice::ReadOnly))
+                continue;
+
+            EffectLibraryEntry entry;
+            entry.path_ = path;
+            entry.modified_ = modified;
+            entry.size_ = size;
+
+            QByteArray data = file.readAll();
+            entry.hash_ = QCryptographicHash::hash(data, QCryptographicHash::Md5);
+
+            // Touched but unchanged content keeps its parsed parameters
+            if (knownIt != known.end() && entries_[knownIt.value()].hash_ == entry.hash_) {
+                entry.params_ = entries_[knownIt.value()].params_;
+            } else {
+                if (!ReadParams(data, entry.params_))
+                    continue;
+                ++parsed;
+            }
+
+            entry.cost_ = EstimateEffectCost(entry.params_);
+            entries.push_back(entry);
+        }
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const EffectLibraryEntry& lhs, const EffectLibraryEntry& rhs) {
+        return lhs.path_ < rhs.path_;
+    });
+    entries.erase(std::unique(entries.begin(), entries.end(), [](const EffectLibraryEntry& lhs, const EffectLibraryEntry& rhs) {
+        return lhs.path_ == rhs.path_;
+    }), entries.end());
+
+    entries_.swap(entries);
+    return parsed;
+}
+
+void EffectLibrary::Filter(const EffectLibraryFilter& filter, std::vector<unsigned>& result) const
+{
+    result.clear();
+    result.reserve(entries_.size());
+
+    const int maxParticles = filter.maxParticles_ < 0 ? M_MAX_INT : filter.maxParticles_;
+    const QByteArray texture = filter.texture_.toUtf8();
+
+    for (unsigned i = 0; i < entries_.size(); ++i) {
+        const EffectParams& params = entries_[i].params_;
+
+        int particles = (int)params.Get(PARAM_MAX_PARTICLES);
+        if (particles < filter.minParticles_ || particles > maxParticles)
+            continue;
+        if (filter.blendMode_ >= 0 && (int)params.Get(PARAM_BLEND_MODE) != filter.blendMode_)
+            continue;
+        if (filter.emitterType_ >= 0 && (int)params.Get(PARAM_EMITTER_TYPE) != filter.emitterType_)
+            continue;
+        if (!texture.isEmpty() && !params.texture_.Contains(texture.constData(), false))
+            continue;
+
+        result.push_back(i);
+    }
+}
+
+bool EffectLibrary::ReadParams(const QByteArray& data, EffectParams& params)
+{
+    PexParser parser;
+    return parser.Parse(data.constData(), data.size(), params);
+}
+
+}
@@ -0,0 +1,95 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "EffectParams.h"
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+
+#include <vector>
+
+
+namespace Urho3D
+{
+
+/// Indexed .pex file.
+struct EffectLibraryEntry
+{
+    /// Absolute file path.
+    QString path_;
+    /// Last modification time in ms since epoch.
+    qint64 modified_ = 0;
+    /// File size in bytes.
+    qint64 size_ = 0;
+    /// MD5 of the file content.
+    QByteArray hash_;
+    /// Parsed parameters.
+    EffectParams params_;
+    /// Estimated fill cost, see EstimateEffectCost.
+    float cost_ = 0.0f;
+};
+
+/// Library query. Negative values mean "any".
+struct EffectLibraryFilter
+{
+    /// Case insensitive texture name substring.
+    QString texture_;
+    /// Blend mode.
+    int blendMode_ = -1;
+    /// Emitter type.
+    int emitterType_ = -1;
+    /// Min max particles, inclusive.
+    int minParticles_ = 0;
+    /// Max max particles, inclusive.
+    int maxParticles_ = -1;
+};
+
+/// Index of every .pex file under a set of root folders, persisted to disk between sessions.
+class EffectLibrary
+{
+public:
+    /// Load index file. Return false if missing or of another version.
+    bool Load(const QString& indexPath);
+    /// Save index file.
+    bool Save(const QString& indexPath) const;
+    /// Rescan roots, parsing only files whose size or time changed. Return number of parsed files.
+    unsigned Refresh(const QStringList& roots);
+    /// Collect indices of entries matching the filter.
+    void Filter(const EffectLibraryFilter& filter, std::vector<unsigned>& result) const;
+
+    /// Return number of entries.
+    unsigned GetNumEntries() const { return entries_.size(); }
+    /// Return entry.
+    const EffectLibraryEntry& GetEntry(unsigned index) const { return entries_[index]; }
+
+    /// Parse .pex parameters from file contents.
+    static bool ReadParams(const QByteArray& data, EffectParams& params);
+
+private:
+    /// Entries sorted by path.
+    std::vector<EffectLibraryEntry> entries_;
+};
+
+}
@@ -0,0 +1,311 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "EffectLibraryWidget.h"
+#include "PreviewCache.h"
+
+#include <Urho3D/Urho2D/ParticleEffect2D.h>
+
+#include <QAbstractListModel>
+#include <QApplication>
+#include <QComboBox>
+#include <QDir>
+#include <QFileDialog>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QLineEdit>
+#include <QListView>
+#include <QPushButton>
+#include <QSettings>
+#include <QSpinBox>
+#include <QStandardPaths>
+#include <QThreadPool>
+#include <QVBoxLayout>
+
+namespace {
+const QString LIBRARY_ROOTS("libraryRoots");
+}
+
+namespace Urho3D
+{
+
+/// List model over the filtered library entries.
+class EffectLibraryModel : public QAbstractListModel
+{
+public:
+    EffectLibraryModel(const EffectLibrary& library, QObject* parent) :
+        QAbstractListModel(parent),
+        library_(library),
+        previewCache_(nullptr)
+    {
+    }
+
+    void SetPreviewCache(PreviewCache* previewCache) { previewCache_ = previewCache; }
+
+    void SetRows(std::vector<unsigned>& rows)
+    {
+        beginResetModel();
+        rows_.swap(rows);
+        endResetModel();
+    }
+
+    const EffectLibraryEntry& GetEntry(int row) const { return library_.GetEntry(rows_[row]); }
+
+    virtual int rowCount(const QModelIndex& parent = QModelIndex()) const
+    {
+        return parent.isValid() ? 0 : (int)rows_.size();
+    }
+
+    virtual QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const
+    {
+        if (!index.isValid() || index.row() >= (int)rows_.size())
+            return QVariant();
+
+        const EffectLibraryEntry& entry = GetEntry(index.row());
+        const EffectParams& params = entry.params_;
+        if (role == Qt::DisplayRole) {
+            // The index file is not trusted to hold a valid blend mode
+            const int blendMode = (int)params.Get(PARAM_BLEND_MODE);
+            return QString("%1  [%2, %3, %4]")
+                .arg(entry.path_.mid(entry.path_.lastIndexOf('/') + 1))
+                .arg((int)params.Get(PARAM_MAX_PARTICLES))
+                .arg(blendMode >= 0 && blendMode < MAX_BLENDMODES ? BLEND_MODE_NAMES[blendMode] : "?")
+                .arg(params.texture_.CString());
+        }
+        if (role == Qt::DecorationRole && previewCache_) {
+            // Only visible rows are asked for decoration, so only they get rendered
+            QPixmap frame = previewCache_->GetFrame(entry.path_);
+            if (frame.isNull())
+                previewCache_->Request(entry.path_);
+            return frame;
+        }
+        if (role == Qt::ToolTipRole) {
+            return QString("%1\nemitter: %2\nlife span: %3\nestimated cost: %4 px/frame")
+                .arg(entry.path_)
+                .arg(params.Get(PARAM_EMITTER_TYPE) == EMITTER_TYPE_GRAVITY ? "gravity" : "radial")
+                .arg(params.Get(PARAM_PARTICLE_LIFESPAN))
+                .arg((qint64)entry.cost_);
+        }
+        return QVariant();
+    }
+
+private:
+    const EffectLibrary& library_;
+    std::vector<unsigned> rows_;
+    PreviewCache* previewCache_;
+};
+
+EffectLibraryScanner::EffectLibraryScanner(const EffectLibrary& library, const QStringList& roots) :
+    library_(library),
+    roots_(roots),
+    numParsed_(0)
+{
+    setAutoDelete(false);
+}
+
+void EffectLibraryScanner::run()
+{
+    numParsed_ = library_.Refresh(roots_);
+    emit finished();
+}
+
+EffectLibraryWidget::EffectLibraryWidget(QWidget* parent) :
+    QWidget(parent),
+    scanning_(false),
+    rescanPending_(false)
+{
+    // One scan at a time, the next one waits for HandleScanFinished
+    pool_.setMaxThreadCount(1);
+
+    QVBoxLayout* vBoxLayout = new QVBoxLayout();
+    setLayout(vBoxLayout);
+
+    QHBoxLayout* filterLayout = new QHBoxLayout();
+    vBoxLayout->addLayout(filterLayout);
+
+    textureEditor_ = new QLineEdit();
+    textureEditor_->setPlaceholderText(tr("Texture"));
+    filterLayout->addWidget(textureEditor_, 1);
+
+    blendModeEditor_ = new QComboBox();
+    blendModeEditor_->addItem(tr("Any blend"), -1);
+    for (int i = 0; i < MAX_BLENDMODES; ++i)
+        blendModeEditor_->addItem(BLEND_MODE_NAMES[i], i);
+    filterLayout->addWidget(blendModeEditor_);
+
+    emitterTypeEditor_ = new QComboBox();
+    emitterTypeEditor_->addItem(tr("Any emitter"), -1);
+    emitterTypeEditor_->addItem(tr("Gravity"), (int)EMITTER_TYPE_GRAVITY);
+    emitterTypeEditor_->addItem(tr("Radial"), (int)EMITTER_TYPE_RADIAL);
+    filterLayout->addWidget(emitterTypeEditor_);
+
+    QHBoxLayout* rangeLayout = new QHBoxLayout();
+    vBoxLayout->addLayout(rangeLayout);
+
+    rangeLayout->addWidget(new QLabel(tr("MaxParticles")));
+    minParticlesEditor_ = new QSpinBox();
+    minParticlesEditor_->setRange(0, 100000);
+    rangeLayout->addWidget(minParticlesEditor_);
+    rangeLayout->addWidget(new QLabel("-"));
+    maxParticlesEditor_ = new QSpinBox();
+    maxParticlesEditor_->setRange(0, 100000);
+    maxParticlesEditor_->setValue(100000);
+    rangeLayout->addWidget(maxParticlesEditor_);
+
+    QPushButton* addRootPushButton = new QPushButton(tr("Add folder..."));
+    rangeLayout->addWidget(addRootPushButton);
+    QPushButton* rescanPushButton = new QPushButton(tr("Rescan"));
+    rangeLayout->addWidget(rescanPushButton);
+
+    model_ = new EffectLibraryModel(library_, this);
+    listView_ = new QListView();
+    listView_->setUniformItemSizes(true);
+    listView_->setModel(model_);
+    vBoxLayout->addWidget(listView_, 1);
+
+    statusLabel_ = new QLabel();
+    vBoxLayout->addWidget(statusLabel_);
+
+    connect(textureEditor_, SIGNAL(textChanged(const QString&)), this, SLOT(HandleFilterChanged()));
+    connect(blendModeEditor_, SIGNAL(currentIndexChanged(int)), this, SLOT(HandleFilterChanged()));
+    connect(emitterTypeEditor_, SIGNAL(currentIndexChanged(int)), this, SLOT(HandleFilterChanged()));
+    connect(minParticlesEditor_, SIGNAL(valueChanged(int)), this, SLOT(HandleFilterChanged()));
+    connect(maxParticlesEditor_, SIGNAL(valueChanged(int)), this, SLOT(HandleFilterChanged()));
+    connect(listView_, SIGNAL(activated(const QModelIndex&)), this, SLOT(HandleActivated(const QModelIndex&)));
+    connect(addRootPushButton, SIGNAL(clicked(bool)), this, SLOT(HandleAddRootClicked()));
+    connect(rescanPushButton, &QPushButton::clicked, this, [this]() {
+        Refresh();
+    });
+}
+
+EffectLibraryWidget::~EffectLibraryWidget()
+{
+    // Scanners hold their own copy of the index, only wait so they don't signal a dead widget
+    pool_.waitForDone();
+}
+
+void EffectLibraryWidget::Refresh()
+{
+    if (scanning_) {
+        rescanPending_ = true;
+        return;
+    }
+
+    if (library_.GetNumEntries() == 0 && library_.Load(GetIndexPath()))
+        HandleFilterChanged();
+
+    scanning_ = true;
+    statusLabel_->setText(tr("Scanning..."));
+
+    EffectLibraryScanner* scanner = new EffectLibraryScanner(library_, GetRoots());
+    connect(scanner, SIGNAL(finished()), this, SLOT(HandleScanFinished()));
+    pool_.start(scanner);
+}
+
+void EffectLibraryWidget::SetPreviewCache(PreviewCache* previewCache)
+{
+    model_->SetPreviewCache(previewCache);
+    listView_->setIconSize(QSize(PreviewCache::GetSize(), PreviewCache::GetSize()));
+
+    connect(previewCache, &PreviewCache::frameChanged, this, [this]() {
+        listView_->viewport()->update();
+    });
+}
+
+void EffectLibraryWidget::HandleScanFinished()
+{
+    EffectLibraryScanner* scanner = qobject_cast<EffectLibraryScanner*>(sender());
+    if (!scanner)
+        return;
+
+    library_ = scanner->GetLibrary();
+    unsigned numParsed = scanner->GetNumParsed();
+    scanner->deleteLater();
+    scanning_ = false;
+
+    if (numParsed > 0)
+        library_.Save(GetIndexPath());
+
+    HandleFilterChanged();
+
+    if (rescanPending_) {
+        rescanPending_ = false;
+        Refresh();
+    }
+}
+
+void EffectLibraryWidget::HandleFilterChanged()
+{
+    EffectLibraryFilter filter;
+    filter.texture_ = textureEditor_->text();
+    filter.blendMode_ = blendModeEditor_->currentData().toInt();
+    filter.emitterType_ = emitterTypeEditor_->currentData().toInt();
+    filter.minParticles_ = minParticlesEditor_->value();
+    filter.maxParticles_ = maxParticlesEditor_->value();
+
+    std::vector<unsigned> rows;
+    library_.Filter(filter, rows);
+    unsigned numRows = rows.size();
+    model_->SetRows(rows);
+
+    statusLabel_->setText(tr("%1 of %2 effects").arg(numRows).arg(library_.GetNumEntries()));
+}
+
+void EffectLibraryWidget::HandleAddRootClicked()
+{
+    QString root = QFileDialog::getExistingDirectory(this, tr("Add library folder"), QApplication::applicationDirPath());
+    if (root.isEmpty())
+        return;
+
+    QStringList roots = GetRoots();
+    if (roots.contains(root))
+        return;
+
+    roots << root;
+    QSettings settings;
+    settings.setValue(LIBRARY_ROOTS, roots);
+    Refresh();
+}
+
+void EffectLibraryWidget::HandleActivated(const QModelIndex& index)
+{
+    if (!index.isValid())
+        return;
+
+    emit openRequested(model_->GetEntry(index.row()).path_);
+}
+
+QString EffectLibraryWidget::GetIndexPath() const
+{
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    QDir().mkpath(dir);
+    return dir + "/library.idx";
+}
+
+QStringList EffectLibraryWidget::GetRoots() const
+{
+    QSettings settings;
+    QStringList defaultRoots(QApplication::applicationDirPath() + "/Data/Urho2D");
+    return settings.value(LIBRARY_ROOTS, defaultRoots).toStringList();
+}
+
+}
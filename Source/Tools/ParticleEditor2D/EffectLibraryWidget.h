@@ -0,0 +1,117 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "EffectLibrary.h"
+
+#include <QObject>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QWidget>
+
+class QComboBox;
+class QLabel;
+class QLineEdit;
+class QListView;
+class QModelIndex;
+class QSpinBox;
+
+namespace Urho3D
+{
+
+class EffectLibraryModel;
+class PreviewCache;
+
+/// Background rescan of the library roots.
+class EffectLibraryScanner : public QObject, public QRunnable
+{
+    Q_OBJECT
+
+public:
+    EffectLibraryScanner(const EffectLibrary& library, const QStringList& roots);
+
+    /// Run in worker thread.
+    virtual void run();
+
+    /// Return refreshed library.
+    EffectLibrary& GetLibrary() { return library_; }
+    /// Return number of parsed files.
+    unsigned GetNumParsed() const { return numParsed_; }
+
+signals:
+    void finished();
+
+private:
+    EffectLibrary library_;
+    QStringList roots_;
+    unsigned numParsed_;
+};
+
+/// Searchable list of all effects under the library roots.
+class EffectLibraryWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    EffectLibraryWidget(QWidget* parent = nullptr);
+    virtual ~EffectLibraryWidget();
+
+    /// Load cached index and rescan roots in background.
+    void Refresh();
+    /// Set preview source for list icons.
+    void SetPreviewCache(PreviewCache* previewCache);
+
+signals:
+    void openRequested(const QString&);
+
+private slots:
+    void HandleFilterChanged();
+    void HandleScanFinished();
+    void HandleAddRootClicked();
+    void HandleActivated(const QModelIndex& index);
+
+private:
+    QString GetIndexPath() const;
+    QStringList GetRoots() const;
+
+    /// Effect index.
+    EffectLibrary library_;
+    /// Filtered entries model.
+    EffectLibraryModel* model_;
+    /// Is scan in progress.
+    bool scanning_;
+    /// Rescan once current scan is done.
+    bool rescanPending_;
+    /// Runs the scanners, waited for on destruction without blocking on unrelated work.
+    QThreadPool pool_;
+
+    QLineEdit* textureEditor_;
+    QComboBox* blendModeEditor_;
+    QComboBox* emitterTypeEditor_;
+    QSpinBox* minParticlesEditor_;
+    QSpinBox* maxParticlesEditor_;
+    QListView* listView_;
+    QLabel* statusLabel_;
+};
+
+}
@@ -0,0 +1,54 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "EffectMemory.h"
+
+#include <Urho3D/Urho2D/Drawable2D.h>
+#include <Urho3D/Urho2D/ParticleEffect2D.h>
+#include <Urho3D/Urho2D/ParticleEmitter2D.h>
+
+namespace Urho3D
+{
+
+EffectMemory EstimateEffectMemory(unsigned maxParticles, unsigned textureBytes)
+{
+    EffectMemory memory;
+    memory.particles_ = GetParticleArrayMemory(maxParticles);
+    // One quad per particle
+    memory.vertices_ = GetVertexArrayMemory(maxParticles * 4);
+    memory.emitter_ = sizeof(ParticleEmitter2D);
+    memory.effect_ = sizeof(ParticleEffect2D);
+    memory.texture_ = textureBytes;
+    return memory;
+}
+
+unsigned GetParticleArrayMemory(unsigned maxParticles)
+{
+    return maxParticles * sizeof(Particle2D);
+}
+
+unsigned GetVertexArrayMemory(unsigned vertices)
+{
+    return vertices * sizeof(Vertex2D);
+}
+
+}
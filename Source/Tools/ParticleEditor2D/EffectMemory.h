@@ -0,0 +1,53 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+namespace Urho3D
+{
+
+/// Bytes attributed to one layer. Resources shared between layers are split evenly among them.
+struct EffectMemory
+{
+    /// Particle array, sized by the particle limit.
+    unsigned particles_ = 0;
+    /// Vertex array the emitter builds for rendering.
+    unsigned vertices_ = 0;
+    /// Emitter component.
+    unsigned emitter_ = 0;
+    /// Share of the ParticleEffect2D resource.
+    unsigned effect_ = 0;
+    /// Share of the sprite texture, mips included.
+    unsigned texture_ = 0;
+
+    /// Return total bytes.
+    unsigned GetTotal() const { return particles_ + vertices_ + emitter_ + effect_ + texture_; }
+};
+
+/// Return memory of a layer that owns its effect and texture, with vertices for every particle.
+EffectMemory EstimateEffectMemory(unsigned maxParticles, unsigned textureBytes);
+/// Return bytes of particle array.
+unsigned GetParticleArrayMemory(unsigned maxParticles);
+/// Return bytes of vertex array for number of vertices.
+unsigned GetVertexArrayMemory(unsigned vertices);
+
+}
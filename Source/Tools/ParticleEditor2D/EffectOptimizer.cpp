@@ -0,0 +1,232 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "EffectOptimizer.h"
+#include "ParticleRasterizer.h"
+#include "ParticleSimulator.h"
+
+#include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/Math/MathDefs.h>
+
+#include <cmath>
+#include <cstdio>
+
+namespace Urho3D
+{
+
+/// Longest simulated time before the compared frames.
+static const float MAX_WARMUP = 5.0f;
+/// First scale step of the search; steps get finer until they pass this limit.
+static const float FIRST_STEP = 0.75f;
+static const float LAST_STEP = 0.97f;
+
+/// Return mean absolute color difference of two images, in [0, 1].
+static float GetImageDifference(const std::vector<Color>& lhs, const std::vector<Color>& rhs)
+{
+    if (lhs.size() != rhs.size() || lhs.empty())
+        return 1.0f;
+
+    float sum = 0.0f;
+    for (unsigned i = 0; i < lhs.size(); ++i)
+        sum += Abs(lhs[i].r_ - rhs[i].r_) + Abs(lhs[i].g_ - rhs[i].g_) + Abs(lhs[i].b_ - rhs[i].b_);
+    return sum / (lhs.size() * 3);
+}
+
+EffectOptimizer::EffectOptimizer(const EffectParams& params, const QImage& sprite, const EffectOptimizerSettings& settings) :
+    params_(params),
+    sprite_(sprite),
+    settings_(settings),
+    hasView_(false),
+    noise_(0.0f),
+    evaluations_(0)
+{
+}
+
+EffectOptimizerResult EffectOptimizer::Optimize()
+{
+    EffectOptimizerResult result;
+    result.params_ = params_;
+    result.originalCost_ = result.cost_ = EstimateEffectCost(params_);
+
+    // Two seeds of the original tell how much of the difference is just particle placement
+    std::vector<Color> other;
+    Render(params_, 1, reference_);
+    Render(params_, 2, other);
+    noise_ = GetImageDifference(reference_, other);
+    result.noise_ = noise_;
+    result.difference_ = noise_;
+    const float limit = noise_ + settings_.threshold_;
+
+    // Greedy descent: take the cheapest accepted single-axis step, refine the step once none is accepted
+    EffectScales best;
+    float step = FIRST_STEP;
+    while (step < LAST_STEP)
+    {
+        bool moved = false;
+        EffectScales bestMove;
+        for (unsigned axis = 0; axis < 3; ++axis)
+        {
+            EffectScales candidate = best;
+            float& scale = axis == 0 ? candidate.rate_ : (axis == 1 ? candidate.lifespan_ : candidate.size_);
+            scale *= step;
+
+            const EffectParams params = ScaleEffectParams(params_, candidate);
+            const float cost = EstimateEffectCost(params);
+            if (cost >= result.cost_ || (moved && cost >= EstimateEffectCost(ScaleEffectParams(params_, bestMove))))
+                continue;
+
+            const float difference = GetDifference(params);
+            if (difference > limit)
+                continue;
+
+            bestMove = candidate;
+            result.difference_ = difference;
+            moved = true;
+        }
+
+        if (moved)
+        {
+            best = bestMove;
+            result.params_ = ScaleEffectParams(params_, best);
+            result.cost_ = EstimateEffectCost(result.params_);
+        }
+        else
+            step = sqrtf(step);
+    }
+
+    result.scales_ = best;
+    result.evaluations_ = evaluations_;
+    return result;
+}
+
+float EffectOptimizer::GetDifference(const EffectParams& params)
+{
+    if (reference_.empty())
+        Render(params_, 1, reference_);
+
+    std::vector<Color> average;
+    Render(params, 1, average);
+    return GetImageDifference(reference_, average);
+}
+
+PODVector<EffectParam> EffectOptimizer::GetChangedParams(const EffectParams& original, const EffectParams& proposal)
+{
+    PODVector<EffectParam> changed;
+    for (unsigned i = 0; i < MAX_EFFECT_PARAMS; ++i)
+    {
+        if (original.Get((EffectParam)i) != proposal.Get((EffectParam)i))
+            changed.Push((EffectParam)i);
+    }
+    return changed;
+}
+
+QImage LoadEffectSprite(const String& effectFileName, const EffectParams& params)
+{
+    if (params.texture_.Empty())
+        return QImage();
+    return QImage(QString::fromUtf8((GetPath(effectFileName) + params.texture_).CString()));
+}
+
+String EffectOptimizer::GetSummary(const EffectParams& original, const EffectOptimizerResult& result)
+{
+    String summary;
+    char line[128];
+    for (EffectParam param: GetChangedParams(original, result.params_))
+    {
+        snprintf(line, sizeof line, "%s: %g -> %g\n", GetEffectParamName(param), original.Get(param), result.params_.Get(param));
+        summary += line;
+    }
+
+    const float saved = result.originalCost_ > 0.0f ? 100.0f * (1.0f - result.cost_ / result.originalCost_) : 0.0f;
+    snprintf(line, sizeof line, "Fill cost -%.0f%%, difference %.2f%% (noise %.2f%%), %u candidates", saved,
+        result.difference_ * 100.0f, result.noise_ * 100.0f, result.evaluations_);
+    summary += line;
+    return summary;
+}
+
+void EffectOptimizer::Render(const EffectParams& params, unsigned seed, std::vector<Color>& average)
+{
+    ++evaluations_;
+
+    // Endless effects are compared at steady state, effects with a duration from their start. The schedule of the
+    // original is used for every candidate.
+    const float timeStep = settings_.timeStep_;
+    const float warmup = params_.Get(PARAM_DURATION) > 0.0f ? 0.0f : Min(params_.Get(PARAM_PARTICLE_LIFESPAN) +
+        params_.Get(PARAM_PARTICLE_LIFESPAN_VARIANCE), MAX_WARMUP);
+    const int warmupSteps = (int)(warmup / timeStep);
+    const int frames = Max(settings_.frames_, 1);
+    const int stepsPerFrame = Max((int)(settings_.duration_ / frames / timeStep), 1);
+
+    ParticleSimulator simulator(params, seed);
+
+    // The original decides the view once, so every candidate is compared in the same frame
+    if (!hasView_)
+    {
+        for (int i = 0; i < warmupSteps; ++i)
+            simulator.Update(timeStep);
+
+        viewMin_ = Vector2(M_INFINITY, M_INFINITY);
+        viewMax_ = Vector2(-M_INFINITY, -M_INFINITY);
+        for (int i = 0; i < frames * stepsPerFrame; ++i)
+        {
+            simulator.Update(timeStep);
+            Vector2 frameMin, frameMax;
+            simulator.GetBounds(frameMin, frameMax);
+            viewMin_ = Vector2(Min(viewMin_.x_, frameMin.x_), Min(viewMin_.y_, frameMin.y_));
+            viewMax_ = Vector2(Max(viewMax_.x_, frameMax.x_), Max(viewMax_.y_, frameMax.y_));
+        }
+        if (viewMin_.x_ > viewMax_.x_)
+            viewMin_ = viewMax_ = Vector2::ZERO;
+        hasView_ = true;
+        simulator.Reset();
+    }
+
+    ParticleRasterizer rasterizer(settings_.imageSize_, settings_.imageSize_);
+    rasterizer.SetSprite(sprite_);
+    rasterizer.FitView(viewMin_, viewMax_);
+
+    average.assign(settings_.imageSize_ * settings_.imageSize_, Color(0.0f, 0.0f, 0.0f, 0.0f));
+    const float weight = 1.0f / frames;
+
+    for (int i = 0; i < warmupSteps; ++i)
+        simulator.Update(timeStep);
+
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        for (int i = 0; i < stepsPerFrame; ++i)
+            simulator.Update(timeStep);
+
+        rasterizer.Clear();
+        rasterizer.Draw(simulator);
+
+        const std::vector<Color>& pixels = rasterizer.GetPixels();
+        for (unsigned i = 0; i < pixels.size(); ++i)
+        {
+            average[i].r_ += Clamp(pixels[i].r_, 0.0f, 1.0f) * weight;
+            average[i].g_ += Clamp(pixels[i].g_, 0.0f, 1.0f) * weight;
+            average[i].b_ += Clamp(pixels[i].b_, 0.0f, 1.0f) * weight;
+        }
+    }
+}
+
+}
@@ -0,0 +1,123 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "EffectParams.h"
+
+#include <Urho3D/Container/Vector.h>
+
+#include <QImage>
+
+#include <vector>
+
+namespace Urho3D
+{
+
+class ParticleSimulator;
+
+/// Effect optimizer settings.
+struct EffectOptimizerSettings
+{
+    /// Largest accepted look difference beyond the noise between two runs of the original, in [0, 1].
+    float threshold_ = 0.01f;
+    /// Side of the compared images in pixels.
+    int imageSize_ = 96;
+    /// Simulated time that is compared, after the effect reaches steady state.
+    float duration_ = 2.0f;
+    /// Frames averaged over the compared time.
+    int frames_ = 16;
+    /// Simulation time step.
+    float timeStep_ = 1.0f / 60.0f;
+};
+
+/// Optimizer proposal.
+struct EffectOptimizerResult
+{
+    /// Proposed parameters.
+    EffectParams params_;
+    /// Scales that produced them.
+    EffectScales scales_;
+    /// Look difference to the original, noise included.
+    float difference_ = 0.0f;
+    /// Difference between two runs of the original with different seeds.
+    float noise_ = 0.0f;
+    /// Estimated fill cost of the original.
+    float originalCost_ = 0.0f;
+    /// Estimated fill cost of the proposal.
+    float cost_ = 0.0f;
+    /// Number of simulated candidates.
+    unsigned evaluations_ = 0;
+
+    /// Return whether the proposal is cheaper than the original.
+    bool IsImproved() const { return cost_ < originalCost_; }
+};
+
+/// Searches emission rate, lifespan and particle size for the cheapest parameters whose look stays within a threshold
+/// of the original. Looks are compared as the average of several CPU rasterized frames, so the random placement of
+/// single particles does not count as a difference; what is left between two seeds of the original is measured once
+/// and allowed on top of the threshold. Cost is EstimateEffectCost. Needs no engine, so it runs headless as well.
+class EffectOptimizer
+{
+public:
+    /// Construct with the original parameters and sprite. A null sprite compares solid squares.
+    EffectOptimizer(const EffectParams& params, const QImage& sprite, const EffectOptimizerSettings& settings =
+        EffectOptimizerSettings());
+
+    /// Search and return the cheapest accepted parameters, the original if nothing cheaper is accepted.
+    EffectOptimizerResult Optimize();
+    /// Return look difference of parameters to the original.
+    float GetDifference(const EffectParams& params);
+
+    /// Return the parameters of a proposal that differ from the original.
+    static PODVector<EffectParam> GetChangedParams(const EffectParams& original, const EffectParams& proposal);
+    /// Return changed parameters, cost and difference of a proposal, one per line.
+    static String GetSummary(const EffectParams& original, const EffectOptimizerResult& result);
+
+private:
+    /// Render the average of the compared frames. Sets the view from the bounds on the first call.
+    void Render(const EffectParams& params, unsigned seed, std::vector<Color>& average);
+
+    /// Original parameters.
+    EffectParams params_;
+    /// Sprite.
+    QImage sprite_;
+    /// Settings.
+    EffectOptimizerSettings settings_;
+    /// Average frame of the original.
+    std::vector<Color> reference_;
+    /// View fitted to the original.
+    Vector2 viewMin_;
+    Vector2 viewMax_;
+    /// View was fitted.
+    bool hasView_;
+    /// Difference between two seeds of the original.
+    float noise_;
+    /// Number of rendered candidates.
+    unsigned evaluations_;
+};
+
+/// Load the sprite of an effect file as an image for CPU rasterization. Return a null image on failure.
+QImage LoadEffectSprite(const String& effectFileName, const EffectParams& params);
+
+}
@@ -0,0 +1,483 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "EffectParams.h"
+
+#include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/Math/MathDefs.h>
+#include <Urho3D/Urho2D/ParticleEffect2D.h>
+#include <Urho3D/Urho2D/Sprite2D.h>
+
+#include <QByteArray>
+
+#include <cmath>
+
+namespace Urho3D
+{
+
+const PexAttribute PEX_ATTRIBUTES[] =
+{
+    { "maxParticles", "value", PARAM_MAX_PARTICLES },
+    { "duration", "value", PARAM_DURATION },
+    { "emitterType", "value", PARAM_EMITTER_TYPE },
+    { "sourcePositionVariance", "x", PARAM_SOURCE_POSITION_VARIANCE_X },
+    { "sourcePositionVariance", "y", PARAM_SOURCE_POSITION_VARIANCE_Y },
+    { "speed", "value", PARAM_SPEED },
+    { "speedVariance", "value", PARAM_SPEED_VARIANCE },
+    { "particleLifeSpan", "value", PARAM_PARTICLE_LIFESPAN },
+    { "particleLifespanVariance", "value", PARAM_PARTICLE_LIFESPAN_VARIANCE },
+    { "angle", "value", PARAM_ANGLE },
+    { "angleVariance", "value", PARAM_ANGLE_VARIANCE },
+    { "gravity", "x", PARAM_GRAVITY_X },
+    { "gravity", "y", PARAM_GRAVITY_Y },
+    { "radialAcceleration", "value", PARAM_RADIAL_ACCELERATION },
+    { "radialAccelVariance", "value", PARAM_RADIAL_ACCEL_VARIANCE },
+    { "tangentialAcceleration", "value", PARAM_TANGENTIAL_ACCELERATION },
+    { "tangentialAccelVariance", "value", PARAM_TANGENTIAL_ACCEL_VARIANCE },
+    { "maxRadius", "value", PARAM_MAX_RADIUS },
+    { "maxRadiusVariance", "value", PARAM_MAX_RADIUS_VARIANCE },
+    { "minRadius", "value", PARAM_MIN_RADIUS },
+    { "minRadiusVariance", "value", PARAM_MIN_RADIUS_VARIANCE },
+    { "rotatePerSecond", "value", PARAM_ROTATE_PER_SECOND },
+    { "rotatePerSecondVariance", "value", PARAM_ROTATE_PER_SECOND_VARIANCE },
+    { "startColor", "red", PARAM_START_COLOR_R },
+    { "startColor", "green", PARAM_START_COLOR_G },
+    { "startColor", "blue", PARAM_START_COLOR_B },
+    { "startColor", "alpha", PARAM_START_COLOR_A },
+    { "startColorVariance", "red", PARAM_START_COLOR_VARIANCE_R },
+    { "startColorVariance", "green", PARAM_START_COLOR_VARIANCE_G },
+    { "startColorVariance", "blue", PARAM_START_COLOR_VARIANCE_B },
+    { "startColorVariance", "alpha", PARAM_START_COLOR_VARIANCE_A },
+    { "finishColor", "red", PARAM_FINISH_COLOR_R },
+    { "finishColor", "green", PARAM_FINISH_COLOR_G },
+    { "finishColor", "blue", PARAM_FINISH_COLOR_B },
+    { "finishColor", "alpha", PARAM_FINISH_COLOR_A },
+    { "finishColorVariance", "red", PARAM_FINISH_COLOR_VARIANCE_R },
+    { "finishColorVariance", "green", PARAM_FINISH_COLOR_VARIANCE_G },
+    { "finishColorVariance", "blue", PARAM_FINISH_COLOR_VARIANCE_B },
+    { "finishColorVariance", "alpha", PARAM_FINISH_COLOR_VARIANCE_A },
+    { "startParticleSize", "value", PARAM_START_PARTICLE_SIZE },
+    { "startParticleSizeVariance", "value", PARAM_START_PARTICLE_SIZE_VARIANCE },
+    { "finishParticleSize", "value", PARAM_FINISH_PARTICLE_SIZE },
+    // Particle Designer writes this one capitalized, Urho3D reads and writes it the same way
+    { "FinishParticleSizeVariance", "value", PARAM_FINISH_PARTICLE_SIZE_VARIANCE },
+    { "rotationStart", "value", PARAM_ROTATION_START },
+    { "rotationStartVariance", "value", PARAM_ROTATION_START_VARIANCE },
+    { "rotationEnd", "value", PARAM_ROTATION_END },
+    { "rotationEndVariance", "value", PARAM_ROTATION_END_VARIANCE },
+};
+
+const unsigned NUM_PEX_ATTRIBUTES = sizeof(PEX_ATTRIBUTES) / sizeof(PEX_ATTRIBUTES[0]);
+
+const char* BLEND_MODE_NAMES[] =
+{
+    "replace",
+    "add",
+    "multiply",
+    "alpha",
+    "addalpha",
+    "premulalpha",
+    "invdestalpha",
+    "subtract",
+    "subtractalpha",
+    0
+};
+
+static const char* paramNames[] =
+{
+    "MaxParticles",
+    "Duration",
+    "EmitterType",
+    "BlendMode",
+    "SourcePositionVarianceX",
+    "SourcePositionVarianceY",
+    "Speed",
+    "SpeedVariance",
+    "ParticleLifeSpan",
+    "ParticleLifespanVariance",
+    "Angle",
+    "AngleVariance",
+    "GravityX",
+    "GravityY",
+    "RadialAcceleration",
+    "RadialAccelVariance",
+    "TangentialAcceleration",
+    "TangentialAccelVariance",
+    "MaxRadius",
+    "MaxRadiusVariance",
+    "MinRadius",
+    "MinRadiusVariance",
+    "RotatePerSecond",
+    "RotatePerSecondVariance",
+    "StartColorR",
+    "StartColorG",
+    "StartColorB",
+    "StartColorA",
+    "StartColorVarianceR",
+    "StartColorVarianceG",
+    "StartColorVarianceB",
+    "StartColorVarianceA",
+    "FinishColorR",
+    "FinishColorG",
+    "FinishColorB",
+    "FinishColorA",
+    "FinishColorVarianceR",
+    "FinishColorVarianceG",
+    "FinishColorVarianceB",
+    "FinishColorVarianceA",
+    "StartParticleSize",
+    "StartParticleSizeVariance",
+    "FinishParticleSize",
+    "FinishParticleSizeVariance",
+    "RotationStart",
+    "RotationStartVariance",
+    "RotationEnd",
+    "RotationEndVariance",
+    0
+};
+
+// OpenGL blend functions per BlendMode, the same tables ParticleEffect2D uses to load and save
+static const int srcBlendFuncs[] =
+{
+    1,      // GL_ONE
+    1,      // GL_ONE
+    0x0306, // GL_DST_COLOR
+    0x0302, // GL_SRC_ALPHA
+    0x0302, // GL_SRC_ALPHA
+    1,      // GL_ONE
+    0x0305, // GL_ONE_MINUS_DST_ALPHA
+    1,      // GL_ONE
+    0x0302, // GL_SRC_ALPHA
+};
+
+static const int destBlendFuncs[] =
+{
+    0,      // GL_ZERO
+    1,      // GL_ONE
+    0,      // GL_ZERO
+    0x0303, // GL_ONE_MINUS_SRC_ALPHA
+    1,      // GL_ONE
+    0x0303, // GL_ONE_MINUS_SRC_ALPHA
+    0x0304, // GL_DST_ALPHA
+    1,      // GL_ONE
+    1,      // GL_ONE
+};
+
+EffectParams::EffectParams()
+{
+    values_[PARAM_MAX_PARTICLES] = 32.0f;
+    values_[PARAM_DURATION] = -1.0f;
+    values_[PARAM_EMITTER_TYPE] = (float)EMITTER_TYPE_GRAVITY;
+    values_[PARAM_BLEND_MODE] = (float)BLEND_ALPHA;
+    SetVector2(PARAM_SOURCE_POSITION_VARIANCE_X, Vector2(7.0f, 7.0f));
+    values_[PARAM_SPEED] = 260.0f;
+    values_[PARAM_SPEED_VARIANCE] = 10.0f;
+    values_[PARAM_PARTICLE_LIFESPAN] = 1.0f;
+    values_[PARAM_PARTICLE_LIFESPAN_VARIANCE] = 0.7f;
+    values_[PARAM_ANGLE] = 0.0f;
+    values_[PARAM_ANGLE_VARIANCE] = 360.0f;
+    SetVector2(PARAM_GRAVITY_X, Vector2::ZERO);
+    values_[PARAM_RADIAL_ACCELERATION] = -380.0f;
+    values_[PARAM_RADIAL_ACCEL_VARIANCE] = 0.0f;
+    values_[PARAM_TANGENTIAL_ACCELERATION] = -140.0f;
+    values_[PARAM_TANGENTIAL_ACCEL_VARIANCE] = 0.0f;
+    values_[PARAM_MAX_RADIUS] = 100.0f;
+    values_[PARAM_MAX_RADIUS_VARIANCE] = 0.0f;
+    values_[PARAM_MIN_RADIUS] = 0.0f;
+    values_[PARAM_MIN_RADIUS_VARIANCE] = 0.0f;
+    values_[PARAM_ROTATE_PER_SECOND] = 0.0f;
+    values_[PARAM_ROTATE_PER_SECOND_VARIANCE] = 0.0f;
+    SetColor(PARAM_START_COLOR_R, Color(1.0f, 0.0f, 0.0f, 1.0f));
+    SetColor(PARAM_START_COLOR_VARIANCE_R, Color(0.0f, 0.0f, 0.0f, 0.0f));
+    SetColor(PARAM_FINISH_COLOR_R, Color(1.0f, 1.0f, 0.0f, 1.0f));
+    SetColor(PARAM_FINISH_COLOR_VARIANCE_R, Color(0.0f, 0.0f, 0.0f, 0.0f));
+    values_[PARAM_START_PARTICLE_SIZE] = 60.0f;
+    values_[PARAM_START_PARTICLE_SIZE_VARIANCE] = 40.0f;
+    values_[PARAM_FINISH_PARTICLE_SIZE] = 5.0f;
+    values_[PARAM_FINISH_PARTICLE_SIZE_VARIANCE] = 5.0f;
+    values_[PARAM_ROTATION_START] = 0.0f;
+    values_[PARAM_ROTATION_START_VARIANCE] = 0.0f;
+    values_[PARAM_ROTATION_END] = 0.0f;
+    values_[PARAM_ROTATION_END_VARIANCE] = 0.0f;
+}
+
+void EffectParams::SetVector2(EffectParam x, const Vector2& value)
+{
+    values_[x] = value.x_;
+    values_[x + 1] = value.y_;
+}
+
+void EffectParams::SetColor(EffectParam r, const Color& value)
+{
+    values_[r] = value.r_;
+    values_[r + 1] = value.g_;
+    values_[r + 2] = value.b_;
+    values_[r + 3] = value.a_;
+}
+
+unsigned EffectParams::ToHash() const
+{
+    unsigned hash = texture_.ToHash();
+    const unsigned char* data = reinterpret_cast<const unsigned char*>(values_);
+    for (unsigned i = 0; i < sizeof(values_); ++i)
+        hash = SDBMHash(hash, data[i]);
+    return hash;
+}
+
+bool EffectParams::operator ==(const EffectParams& rhs) const
+{
+    for (unsigned i = 0; i < MAX_EFFECT_PARAMS; ++i)
+    {
+        if (values_[i] != rhs.values_[i])
+            return false;
+    }
+    return texture_ == rhs.texture_;
+}
+
+const char* GetEffectParamName(EffectParam param)
+{
+    return paramNames[param];
+}
+
+float GetEffectParam(const ParticleEffect2D* effect, EffectParam param)
+{
+    switch (param)
+    {
+    case PARAM_MAX_PARTICLES: return (float)effect->GetMaxParticles();
+    case PARAM_DURATION: return effect->GetDuration();
+    case PARAM_EMITTER_TYPE: return (float)effect->GetEmitterType();
+    case PARAM_BLEND_MODE: return (float)effect->GetBlendMode();
+    case PARAM_SOURCE_POSITION_VARIANCE_X: return effect->GetSourcePositionVariance().x_;
+    case PARAM_SOURCE_POSITION_VARIANCE_Y: return effect->GetSourcePositionVariance().y_;
+    case PARAM_SPEED: return effect->GetSpeed();
+    case PARAM_SPEED_VARIANCE: return effect->GetSpeedVariance();
+    case PARAM_PARTICLE_LIFESPAN: return effect->GetParticleLifeSpan();
+    case PARAM_PARTICLE_LIFESPAN_VARIANCE: return effect->GetParticleLifespanVariance();
+    case PARAM_ANGLE: return effect->GetAngle();
+    case PARAM_ANGLE_VARIANCE: return effect->GetAngleVariance();
+    case PARAM_GRAVITY_X: return effect->GetGravity().x_;
+    case PARAM_GRAVITY_Y: return effect->GetGravity().y_;
+    case PARAM_RADIAL_ACCELERATION: return effect->GetRadialAcceleration();
+    case PARAM_RADIAL_ACCEL_VARIANCE: return effect->GetRadialAccelVariance();
+    case PARAM_TANGENTIAL_ACCELERATION: return effect->GetTangentialAcceleration();
+    case PARAM_TANGENTIAL_ACCEL_VARIANCE: return effect->GetTangentialAccelVariance();
+    case PARAM_MAX_RADIUS: return effect->GetMaxRadius();
+    case PARAM_MAX_RADIUS_VARIANCE: return effect->GetMaxRadiusVariance();
+    case PARAM_MIN_RADIUS: return effect->GetMinRadius();
+    case PARAM_MIN_RADIUS_VARIANCE: return effect->GetMinRadiusVariance();
+    case PARAM_ROTATE_PER_SECOND: return effect->GetRotatePerSecond();
+    case PARAM_ROTATE_PER_SECOND_VARIANCE: return effect->GetRotatePerSecondVariance();
+    case PARAM_START_COLOR_R: return effect->GetStartColor().r_;
+    case PARAM_START_COLOR_G: return effect->GetStartColor().g_;
+    case PARAM_START_COLOR_B: return effect->GetStartColor().b_;
+    case PARAM_START_COLOR_A: return effect->GetStartColor().a_;
+    case PARAM_START_COLOR_VARIANCE_R: return effect->GetStartColorVariance().r_;
+    case PARAM_START_COLOR_VARIANCE_G: return effect->GetStartColorVariance().g_;
+    case PARAM_START_COLOR_VARIANCE_B: return effect->GetStartColorVariance().b_;
+    case PARAM_START_COLOR_VARIANCE_A: return effect->GetStartColorVariance().a_;
+    case PARAM_FINISH_COLOR_R: return effect->GetFinishColor().r_;
+    case PARAM_FINISH_COLOR_G: return effect->GetFinishColor().g_;
+    case PARAM_FINISH_COLOR_B: return effect->GetFinishColor().b_;
+    case PARAM_FINISH_COLOR_A: return effect->GetFinishColor().a_;
+    case PARAM_FINISH_COLOR_VARIANCE_R: return effect->GetFinishColorVariance().r_;
+    case PARAM_FINISH_COLOR_VARIANCE_G: return effect->GetFinishColorVariance().g_;
+    case PARAM_FINISH_COLOR_VARIANCE_B: return effect->GetFinishColorVariance().b_;
+    case PARAM_FINISH_COLOR_VARIANCE_A: return effect->GetFinishColorVariance().a_;
+    case PARAM_START_PARTICLE_SIZE: return effect->GetStartParticleSize();
+    case PARAM_START_PARTICLE_SIZE_VARIANCE: return effect->GetStartParticleSizeVariance();
+    case PARAM_FINISH_PARTICLE_SIZE: return effect->GetFinishParticleSize();
+    case PARAM_FINISH_PARTICLE_SIZE_VARIANCE: return effect->GetFinishParticleSizeVariance();
+    case PARAM_ROTATION_START: return effect->GetRotationStart();
+    case PARAM_ROTATION_START_VARIANCE: return effect->GetRotationStartVariance();
+    case PARAM_ROTATION_END: return effect->GetRotationEnd();
+    case PARAM_ROTATION_END_VARIANCE: return effect->GetRotationEndVariance();
+    default: return 0.0f;
+    }
+}
+
+void SetEffectParam(ParticleEffect2D* effect, EffectParam param, float value)
+{
+    switch (param)
+    {
+    case PARAM_MAX_PARTICLES: effect->SetMaxParticles((int)value); break;
+    case PARAM_DURATION: effect->SetDuration(value); break;
+    case PARAM_EMITTER_TYPE: effect->SetEmitterType((EmitterType2D)(int)value); break;
+    case PARAM_BLEND_MODE: effect->SetBlendMode((BlendMode)(int)value); break;
+    case PARAM_SOURCE_POSITION_VARIANCE_X:
+        effect->SetSourcePositionVariance(Vector2(value, effect->GetSourcePositionVariance().y_));
+        break;
+    case PARAM_SOURCE_POSITION_VARIANCE_Y:
+        effect->SetSourcePositionVariance(Vector2(effect->GetSourcePositionVariance().x_, value));
+        break;
+    case PARAM_SPEED: effect->SetSpeed(value); break;
+    case PARAM_SPEED_VARIANCE: effect->SetSpeedVariance(value); break;
+    case PARAM_PARTICLE_LIFESPAN: effect->SetParticleLifeSpan(value); break;
+    case PARAM_PARTICLE_LIFESPAN_VARIANCE: effect->SetParticleLifespanVariance(value); break;
+    case PARAM_ANGLE: effect->SetAngle(value); break;
+    case PARAM_ANGLE_VARIANCE: effect->SetAngleVariance(value); break;
+    case PARAM_GRAVITY_X: effect->SetGravity(Vector2(value, effect->GetGravity().y_)); break;
+    case PARAM_GRAVITY_Y: effect->SetGravity(Vector2(effect->GetGravity().x_, value)); break;
+    case PARAM_RADIAL_ACCELERATION: effect->SetRadialAcceleration(value); break;
+    case PARAM_RADIAL_ACCEL_VARIANCE: effect->SetRadialAccelVariance(value); break;
+    case PARAM_TANGENTIAL_ACCELERATION: effect->SetTangentialAcceleration(value); break;
+    case PARAM_TANGENTIAL_ACCEL_VARIANCE: effect->SetTangentialAccelVariance(value); break;
+    case PARAM_MAX_RADIUS: effect->SetMaxRadius(value); break;
+    case PARAM_MAX_RADIUS_VARIANCE: effect->SetMaxRadiusVariance(value); break;
+    case PARAM_MIN_RADIUS: effect->SetMinRadius(value); break;
+    case PARAM_MIN_RADIUS_VARIANCE: effect->SetMinRadiusVariance(value); break;
+    case PARAM_ROTATE_PER_SECOND: effect->SetRotatePerSecond(value); break;
+    case PARAM_ROTATE_PER_SECOND_VARIANCE: effect->SetRotatePerSecondVariance(value); break;
+    case PARAM_START_PARTICLE_SIZE: effect->SetStartParticleSize(value); break;
+    case PARAM_START_PARTICLE_SIZE_VARIANCE: effect->SetStartParticleSizeVariance(value); break;
+    case PARAM_FINISH_PARTICLE_SIZE: effect->SetFinishParticleSize(value); break;
+    case PARAM_FINISH_PARTICLE_SIZE_VARIANCE: effect->SetFinishParticleSizeVariance(value); break;
+    case PARAM_ROTATION_START: effect->SetRotationStart(value); break;
+    case PARAM_ROTATION_START_VARIANCE: effect->SetRotationStartVariance(value); break;
+    case PARAM_ROTATION_END: effect->SetRotationEnd(value); break;
+    case PARAM_ROTATION_END_VARIANCE: effect->SetRotationEndVariance(value); break;
+
+    default:
+        if (param >= PARAM_START_COLOR_R && param < PARAM_START_PARTICLE_SIZE)
+        {
+            // Color components, rebuild the whole color from the current one
+            int group = (param - PARAM_START_COLOR_R) / 4;
+            int channel = (param - PARAM_START_COLOR_R) % 4;
+            Color color;
+            switch (group)
+            {
+            case 0: color = effect->GetStartColor(); break;
+            case 1: color = effect->GetStartColorVariance(); break;
+            case 2: color = effect->GetFinishColor(); break;
+            default: color = effect->GetFinishColorVariance(); break;
+            }
+            (&color.r_)[channel] = value;
+            switch (group)
+            {
+            case 0: effect->SetStartColor(color); break;
+            case 1: effect->SetStartColorVariance(color); break;
+            case 2: effect->SetFinishColor(color); break;
+            default: effect->SetFinishColorVariance(color); break;
+            }
+        }
+        break;
+    }
+}
+
+void ReadEffectParams(const ParticleEffect2D* effect, EffectParams& params)
+{
+    Sprite2D* sprite = effect->GetSprite();
+    params.texture_ = sprite ? GetFileNameAndExtension(sprite->GetName()) : String::EMPTY;
+
+    for (unsigned i = 0; i < MAX_EFFECT_PARAMS; ++i)
+        params.values_[i] = GetEffectParam(effect, (EffectParam)i);
+}
+
+void ApplyEffectParams(ParticleEffect2D* effect, const EffectParams& params)
+{
+    effect->SetMaxParticles((int)params.Get(PARAM_MAX_PARTICLES));
+    effect->SetDuration(params.Get(PARAM_DURATION));
+    effect->SetEmitterType((EmitterType2D)(int)params.Get(PARAM_EMITTER_TYPE));
+    effect->SetBlendMode((BlendMode)(int)params.Get(PARAM_BLEND_MODE));
+    effect->SetSourcePositionVariance(params.GetVector2(PARAM_SOURCE_POSITION_VARIANCE_X));
+    effect->SetSpeed(params.Get(PARAM_SPEED));
+    effect->SetSpeedVariance(params.Get(PARAM_SPEED_VARIANCE));
+    effect->SetParticleLifeSpan(params.Get(PARAM_PARTICLE_LIFESPAN));
+    effect->SetParticleLifespanVariance(params.Get(PARAM_PARTICLE_LIFESPAN_VARIANCE));
+    effect->SetAngle(params.Get(PARAM_ANGLE));
+    effect->SetAngleVariance(params.Get(PARAM_ANGLE_VARIANCE));
+    effect->SetGravity(params.GetVector2(PARAM_GRAVITY_X));
+    effect->SetRadialAcceleration(params.Get(PARAM_RADIAL_ACCELERATION));
+    effect->SetRadialAccelVariance(params.Get(PARAM_RADIAL_ACCEL_VARIANCE));
+    effect->SetTangentialAcceleration(params.Get(PARAM_TANGENTIAL_ACCELERATION));
+    effect->SetTangentialAccelVariance(params.Get(PARAM_TANGENTIAL_ACCEL_VARIANCE));
+    effect->SetMaxRadius(params.Get(PARAM_MAX_RADIUS));
+    effect->SetMaxRadiusVariance(params.Get(PARAM_MAX_RADIUS_VARIANCE));
+    effect->SetMinRadius(params.Get(PARAM_MIN_RADIUS));
+    effect->SetMinRadiusVariance(params.Get(PARAM_MIN_RADIUS_VARIANCE));
+    effect->SetRotatePerSecond(params.Get(PARAM_ROTATE_PER_SECOND));
+    effect->SetRotatePerSecondVariance(params.Get(PARAM_ROTATE_PER_SECOND_VARIANCE));
+    effect->SetStartColor(params.GetColor(PARAM_START_COLOR_R));
+    effect->SetStartColorVariance(params.GetColor(PARAM_START_COLOR_VARIANCE_R));
+    effect->SetFinishColor(params.GetColor(PARAM_FINISH_COLOR_R));
+    effect->SetFinishColorVariance(params.GetColor(PARAM_FINISH_COLOR_VARIANCE_R));
+    effect->SetStartParticleSize(params.Get(PARAM_START_PARTICLE_SIZE));
+    effect->SetStartParticleSizeVariance(params.Get(PARAM_START_PARTICLE_SIZE_VARIANCE));
+    effect->SetFinishParticleSize(params.Get(PARAM_FINISH_PARTICLE_SIZE));
+    effect->SetFinishParticleSizeVariance(params.Get(PARAM_FINISH_PARTICLE_SIZE_VARIANCE));
+    effect->SetRotationStart(params.Get(PARAM_ROTATION_START));
+    effect->SetRotationStartVariance(params.Get(PARAM_ROTATION_START_VARIANCE));
+    effect->SetRotationEnd(params.Get(PARAM_ROTATION_END));
+    effect->SetRotationEndVariance(params.Get(PARAM_ROTATION_END_VARIANCE));
+}
+
+BlendMode GetBlendModeFromFuncs(int source, int destination)
+{
+    for (int i = 0; i < MAX_BLENDMODES; ++i)
+    {
+        if (source == srcBlendFuncs[i] && destination == destBlendFuncs[i])
+            return (BlendMode)i;
+    }
+    return BLEND_ALPHA;
+}
+
+float EstimateEffectCost(const EffectParams& params)
+{
+    // ParticleEmitter2D emits maxParticles / lifespan per second, so the steady state keeps the pool full
+    float particles = params.Get(PARAM_MAX_PARTICLES);
+    float size = (params.Get(PARAM_START_PARTICLE_SIZE) + params.Get(PARAM_FINISH_PARTICLE_SIZE)) * 0.5f;
+    return particles * size * size;
+}
+
+EffectParams ScaleEffectParams(const EffectParams& params, const EffectScales& scales)
+{
+    EffectParams scaled = params;
+
+    // Emission rate is tied to the pool size as above, so the pool follows rate times lifespan
+    const float maxParticles = params.Get(PARAM_MAX_PARTICLES) * scales.rate_ * scales.lifespan_;
+    scaled.Set(PARAM_MAX_PARTICLES, Max(1.0f, floorf(maxParticles + 0.5f)));
+    scaled.Set(PARAM_PARTICLE_LIFESPAN, params.Get(PARAM_PARTICLE_LIFESPAN) * scales.lifespan_);
+    scaled.Set(PARAM_PARTICLE_LIFESPAN_VARIANCE, params.Get(PARAM_PARTICLE_LIFESPAN_VARIANCE) * scales.lifespan_);
+
+    const EffectParam sizes[] = { PARAM_START_PARTICLE_SIZE, PARAM_START_PARTICLE_SIZE_VARIANCE, PARAM_FINISH_PARTICLE_SIZE,
+        PARAM_FINISH_PARTICLE_SIZE_VARIANCE };
+    for (EffectParam param: sizes)
+        scaled.Set(param, params.Get(param) * scales.size_);
+
+    return scaled;
+}
+
+// QApplication sets the process locale, so printf and strtod would write and expect decimal commas in some locales.
+// QByteArray always uses the C locale.
+String FormatNumber(double value, char format, int precision)
+{
+    return String(QByteArray::number(value, format, precision).constData());
+}
+
+bool ParseNumber(const char* text, unsigned length, double& result)
+{
+    // fromRawData does not copy, the conversion stays within the given length
+    bool ok = false;
+    result = length ? QByteArray::fromRawData(text, (int)length).toDouble(&ok) : 0.0;
+    return ok;
+}
+
+}
@@ -0,0 +1,172 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include <Urho3D/Container/Str.h>
+#include <Urho3D/Graphics/GraphicsDefs.h>
+#include <Urho3D/Math/Color.h>
+#include <Urho3D/Math/Vector2.h>
+
+namespace Urho3D
+{
+
+class ParticleEffect2D;
+
+/// Scalar parameters of a Particle Designer effect. Vectors and colors are stored per component.
+enum EffectParam
+{
+    PARAM_MAX_PARTICLES = 0,
+    PARAM_DURATION,
+    PARAM_EMITTER_TYPE,
+    PARAM_BLEND_MODE,
+    PARAM_SOURCE_POSITION_VARIANCE_X,
+    PARAM_SOURCE_POSITION_VARIANCE_Y,
+    PARAM_SPEED,
+    PARAM_SPEED_VARIANCE,
+    PARAM_PARTICLE_LIFESPAN,
+    PARAM_PARTICLE_LIFESPAN_VARIANCE,
+    PARAM_ANGLE,
+    PARAM_ANGLE_VARIANCE,
+    PARAM_GRAVITY_X,
+    PARAM_GRAVITY_Y,
+    PARAM_RADIAL_ACCELERATION,
+    PARAM_RADIAL_ACCEL_VARIANCE,
+    PARAM_TANGENTIAL_ACCELERATION,
+    PARAM_TANGENTIAL_ACCEL_VARIANCE,
+    PARAM_MAX_RADIUS,
+    PARAM_MAX_RADIUS_VARIANCE,
+    PARAM_MIN_RADIUS,
+    PARAM_MIN_RADIUS_VARIANCE,
+    PARAM_ROTATE_PER_SECOND,
+    PARAM_ROTATE_PER_SECOND_VARIANCE,
+    PARAM_START_COLOR_R,
+    PARAM_START_COLOR_G,
+    PARAM_START_COLOR_B,
+    PARAM_START_COLOR_A,
+    PARAM_START_COLOR_VARIANCE_R,
+    PARAM_START_COLOR_VARIANCE_G,
+    PARAM_START_COLOR_VARIANCE_B,
+    PARAM_START_COLOR_VARIANCE_A,
+    PARAM_FINISH_COLOR_R,
+    PARAM_FINISH_COLOR_G,
+    PARAM_FINISH_COLOR_B,
+    PARAM_FINISH_COLOR_A,
+    PARAM_FINISH_COLOR_VARIANCE_R,
+    PARAM_FINISH_COLOR_VARIANCE_G,
+    PARAM_FINISH_COLOR_VARIANCE_B,
+    PARAM_FINISH_COLOR_VARIANCE_A,
+    PARAM_START_PARTICLE_SIZE,
+    PARAM_START_PARTICLE_SIZE_VARIANCE,
+    PARAM_FINISH_PARTICLE_SIZE,
+    PARAM_FINISH_PARTICLE_SIZE_VARIANCE,
+    PARAM_ROTATION_START,
+    PARAM_ROTATION_START_VARIANCE,
+    PARAM_ROTATION_END,
+    PARAM_ROTATION_END_VARIANCE,
+    MAX_EFFECT_PARAMS
+};
+
+/// Mapping of a .pex element attribute to an effect parameter.
+struct PexAttribute
+{
+    /// Element name.
+    const char* element_;
+    /// Attribute name.
+    const char* attribute_;
+    /// Parameter.
+    EffectParam param_;
+};
+
+/// All .pex element attributes that map directly to a parameter.
+extern const PexAttribute PEX_ATTRIBUTES[];
+/// Number of entries in PEX_ATTRIBUTES.
+extern const unsigned NUM_PEX_ATTRIBUTES;
+/// Blend mode names, indexed by BlendMode.
+extern const char* BLEND_MODE_NAMES[];
+
+/// Flat copy of every ParticleEffect2D parameter, cheap to copy, compare and hash.
+struct EffectParams
+{
+    /// Construct with ParticleEffect2D defaults.
+    EffectParams();
+
+    /// Return parameter.
+    float Get(EffectParam param) const { return values_[param]; }
+    /// Set parameter.
+    void Set(EffectParam param, float value) { values_[param] = value; }
+    /// Return two consecutive parameters as vector.
+    Vector2 GetVector2(EffectParam x) const { return Vector2(values_[x], values_[x + 1]); }
+    /// Set two consecutive parameters from vector.
+    void SetVector2(EffectParam x, const Vector2& value);
+    /// Return four consecutive parameters as color.
+    Color GetColor(EffectParam r) const { return Color(values_[r], values_[r + 1], values_[r + 2], values_[r + 3]); }
+    /// Set four consecutive parameters from color.
+    void SetColor(EffectParam r, const Color& value);
+
+    /// Return hash of texture and parameters.
+    unsigned ToHash() const;
+
+    bool operator ==(const EffectParams& rhs) const;
+    bool operator !=(const EffectParams& rhs) const { return !(*this == rhs); }
+
+    /// Texture name relative to the effect file.
+    String texture_;
+    /// Parameter values.
+    float values_[MAX_EFFECT_PARAMS];
+};
+
+/// Coherent scales of the parameters that decide particle cost.
+struct EffectScales
+{
+    /// Emission rate.
+    float rate_ = 1.0f;
+    /// Lifespan and its variance.
+    float lifespan_ = 1.0f;
+    /// Start and finish size and their variances.
+    float size_ = 1.0f;
+};
+
+/// Return parameter display name.
+const char* GetEffectParamName(EffectParam param);
+/// Return parameter from effect.
+float GetEffectParam(const ParticleEffect2D* effect, EffectParam param);
+/// Set parameter to effect.
+void SetEffectParam(ParticleEffect2D* effect, EffectParam param, float value);
+/// Copy all parameters from effect.
+void ReadEffectParams(const ParticleEffect2D* effect, EffectParams& params);
+/// Apply all parameters to effect. The sprite is left untouched.
+void ApplyEffectParams(ParticleEffect2D* effect, const EffectParams& params);
+
+/// Return blend mode from OpenGL blend functions as written by Particle Designer.
+BlendMode GetBlendModeFromFuncs(int source, int destination);
+/// Return estimated fill cost in pixels per frame: live particles times average quad area.
+float EstimateEffectCost(const EffectParams& params);
+/// Return parameters with emission rate, lifespan and size scaled. The particle limit follows rate times lifespan.
+EffectParams ScaleEffectParams(const EffectParams& params, const EffectScales& scales);
+
+/// Format number in the C locale, with a printf format character 'f', 'e' or 'g' and precision.
+String FormatNumber(double value, char format, int precision);
+/// Parse number in the C locale. Return false unless the whole text is a number.
+bool ParseNumber(const char* text, unsigned length, double& result);
+
+}
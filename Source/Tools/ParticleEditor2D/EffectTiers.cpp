@@ -0,0 +1,95 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "EffectTiers.h"
+
+#include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/Math/MathDefs.h>
+
+#include <cmath>
+
+namespace Urho3D
+{
+
+const char* EFFECT_TIER_NAMES[] = { "low", "medium", "high" };
+const float EFFECT_TIER_FRACTIONS[] = { 0.25f, 0.5f, 1.0f };
+
+/// Share of a fill reduction taken by the particle count, the rest shrinks the particles.
+static const float FILL_COUNT_SHARE = 0.6f;
+/// Share of a count reduction taken by the lifespan, the rest lowers the emission rate.
+static const float COUNT_LIFESPAN_SHARE = 0.25f;
+/// Smallest scale, keeps at least a trace of the effect.
+static const float MIN_SCALE = 0.01f;
+
+EffectBudget GetEffectBudget(const EffectParams& params)
+{
+    EffectBudget budget;
+    budget.peakParticles_ = params.Get(PARAM_MAX_PARTICLES);
+    budget.fillArea_ = EstimateEffectCost(params);
+    budget.vertices_ = budget.peakParticles_ * 4.0f;
+    return budget;
+}
+
+EffectBudget GetTierBudget(const EffectBudget& budget, EffectTier tier)
+{
+    const float fraction = EFFECT_TIER_FRACTIONS[tier];
+    EffectBudget tierBudget;
+    tierBudget.peakParticles_ = budget.peakParticles_ * fraction;
+    tierBudget.fillArea_ = budget.fillArea_ * fraction;
+    tierBudget.vertices_ = budget.vertices_ * fraction;
+    return tierBudget;
+}
+
+EffectScales GetTierScales(const EffectParams& params, const EffectBudget& budget)
+{
+    const EffectBudget cost = GetEffectBudget(params);
+
+    // Particle and vertex limits only leave fewer particles
+    float count = 1.0f;
+    if (cost.peakParticles_ > 0.0f)
+        count = Min(count, Min(budget.peakParticles_ / cost.peakParticles_, budget.vertices_ / cost.vertices_));
+
+    // Fill is count times size squared. Splitting a fill cut between both keeps the look closer than cutting only one
+    const float fill = cost.fillArea_ > 0.0f ? Min(1.0f, budget.fillArea_ / cost.fillArea_) : 1.0f;
+    count = Clamp(Min(count, powf(fill, FILL_COUNT_SHARE)), MIN_SCALE, 1.0f);
+
+    EffectScales scales;
+    scales.size_ = Clamp(sqrtf(fill / count), MIN_SCALE, 1.0f);
+
+    // Count follows rate times lifespan. Shorter lives change the shape of the effect, so the rate takes most of it
+    scales.lifespan_ = powf(count, COUNT_LIFESPAN_SHARE);
+    scales.rate_ = count / scales.lifespan_;
+    return scales;
+}
+
+EffectParams GetTierParams(const EffectParams& params, const EffectBudget& budget, EffectTier tier)
+{
+    return ScaleEffectParams(params, GetTierScales(params, GetTierBudget(budget, tier)));
+}
+
+String GetTierFileName(const String& fileName, EffectTier tier)
+{
+    return GetPath(fileName) + GetFileName(fileName) + "_" + EFFECT_TIER_NAMES[tier] + GetExtension(fileName);
+}
+
+}
@@ -0,0 +1,68 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "EffectParams.h"
+
+namespace Urho3D
+{
+
+/// Quality tier of an effect variant.
+enum EffectTier
+{
+    TIER_LOW = 0,
+    TIER_MEDIUM,
+    TIER_HIGH,
+    MAX_EFFECT_TIERS
+};
+
+/// Tier names, used as file name suffixes.
+extern const char* EFFECT_TIER_NAMES[];
+/// Share of the budget each tier may use.
+extern const float EFFECT_TIER_FRACTIONS[];
+
+/// Per-effect cost limits.
+struct EffectBudget
+{
+    /// Live particles at the peak.
+    float peakParticles_ = 0.0f;
+    /// Pixels filled per frame, as estimated by EstimateEffectCost.
+    float fillArea_ = 0.0f;
+    /// Vertices per frame, four per particle.
+    float vertices_ = 0.0f;
+};
+
+/// Return cost of parameters in budget terms.
+EffectBudget GetEffectBudget(const EffectParams& params);
+/// Return budget of tier, a fraction of the high tier budget.
+EffectBudget GetTierBudget(const EffectBudget& budget, EffectTier tier);
+/// Return emission, lifespan and size scales that fit parameters into budget. Nothing is scaled up. Closed form, so
+/// cheap enough to call on every budget change.
+EffectScales GetTierScales(const EffectParams& params, const EffectBudget& budget);
+/// Return parameters of tier for the high tier budget.
+EffectParams GetTierParams(const EffectParams& params, const EffectBudget& budget, EffectTier tier);
+/// Return file name of tier variant saved alongside the effect, e.g. fire_low.pex.
+String GetTierFileName(const String& fileName, EffectTier tier);
+
+}
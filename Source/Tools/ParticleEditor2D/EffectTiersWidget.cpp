@@ -0,0 +1,284 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "EditQueue.h"
+#include "EffectTiersWidget.h"
+#include "ParticleEditor.h"
+
+#include <Urho3D/IO/FileSystem.h>
+
+#include <QFormLayout>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPushButton>
+#include <QSpinBox>
+#include <QTableWidget>
+#include <QVBoxLayout>
+
+#include <cmath>
+
+namespace Urho3D
+{
+
+enum EffectTiersColumn
+{
+    COLUMN_TIER = 0,
+    COLUMN_PARTICLES,
+    COLUMN_VERTICES,
+    COLUMN_FILL,
+    COLUMN_RATE,
+    COLUMN_LIFESPAN,
+    COLUMN_SIZE,
+    NUM_COLUMNS
+};
+
+/// Horizontal distance between variants in the scene, as between a layer and its clone.
+static const float VARIANT_SPACING = 2.0f;
+
+static QSpinBox* CreateBudgetEditor(int minimum, int maximum)
+{
+    QSpinBox* spinBox = new QSpinBox();
+    spinBox->setRange(minimum, maximum);
+    spinBox->setKeyboardTracking(false);
+    return spinBox;
+}
+
+EffectTiersWidget::EffectTiersWidget(QWidget* parent) :
+    QWidget(parent),
+    sourceLayer_(INVALID_LAYER)
+{
+    QVBoxLayout* vBoxLayout = new QVBoxLayout(this);
+
+    QHBoxLayout* sourceLayout = new QHBoxLayout();
+    vBoxLayout->addLayout(sourceLayout);
+    sourceLabel_ = new QLabel(tr("No effect"));
+    sourceLayout->addWidget(sourceLabel_, 1);
+    QPushButton* useSelectedPushButton = new QPushButton(tr("Use Selected"));
+    sourceLayout->addWidget(useSelectedPushButton);
+
+    QFormLayout* budgetLayout = new QFormLayout();
+    vBoxLayout->addLayout(budgetLayout);
+    peakParticlesEditor_ = CreateBudgetEditor(1, 100000);
+    budgetLayout->addRow(tr("Peak particles"), peakParticlesEditor_);
+    fillAreaEditor_ = CreateBudgetEditor(1, 100000000);
+    fillAreaEditor_->setSuffix(tr(" px"));
+    budgetLayout->addRow(tr("Fill area"), fillAreaEditor_);
+    verticesEditor_ = CreateBudgetEditor(4, 400000);
+    budgetLayout->addRow(tr("Vertices"), verticesEditor_);
+
+    tableWidget_ = new QTableWidget(MAX_EFFECT_TIERS, NUM_COLUMNS);
+    tableWidget_->setHorizontalHeaderLabels(QStringList() << tr("Tier") << tr("Particles") << tr("Vertices")
+        << tr("Fill") << tr("Rate") << tr("Lifespan") << tr("Size"));
+    tableWidget_->verticalHeader()->hide();
+    tableWidget_->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    tableWidget_->setSelectionMode(QAbstractItemView::NoSelection);
+    vBoxLayout->addWidget(tableWidget_, 1);
+
+    QHBoxLayout* buttonLayout = new QHBoxLayout();
+    vBoxLayout->addLayout(buttonLayout);
+    buttonLayout->addStretch(1);
+    QPushButton* previewPushButton = new QPushButton(tr("Preview"));
+    buttonLayout->addWidget(previewPushButton);
+    QPushButton* savePushButton = new QPushButton(tr("Save Variants"));
+    buttonLayout->addWidget(savePushButton);
+
+    connect(useSelectedPushButton, SIGNAL(clicked(bool)), this, SLOT(HandleUseSelectedClicked()));
+    connect(peakParticlesEditor_, SIGNAL(valueChanged(int)), this, SLOT(HandleBudgetChanged()));
+    connect(fillAreaEditor_, SIGNAL(valueChanged(int)), this, SLOT(HandleBudgetChanged()));
+    connect(verticesEditor_, SIGNAL(valueChanged(int)), this, SLOT(HandleBudgetChanged()));
+    connect(previewPushButton, SIGNAL(clicked(bool)), this, SLOT(HandlePreviewClicked()));
+    connect(savePushButton, SIGNAL(clicked(bool)), this, SLOT(HandleSaveClicked()));
+    connect(ParticleEditor::Get()->GetEditQueue(), SIGNAL(applied(const QVector<unsigned>&)), this,
+        SLOT(HandleApplied(const QVector<unsigned>&)));
+
+    UpdateTable();
+}
+
+EffectTiersWidget::~EffectTiersWidget()
+{
+}
+
+void EffectTiersWidget::SetSourceLayer(LayerHandle layer)
+{
+    sourceLayer_ = layer;
+
+    EffectParams params;
+    if (!GetSourceParams(params)) {
+        sourceLabel_->setText(tr("No effect"));
+        UpdateTable();
+        return;
+    }
+
+    const String& fileName = ParticleEditor::Get()->GetFileName(layer);
+    sourceLabel_->setText((GetFileName(fileName) + GetExtension(fileName)).CString());
+
+    // One update for all three values
+    const EffectBudget budget = GetEffectBudget(params);
+    peakParticlesEditor_->blockSignals(true);
+    fillAreaEditor_->blockSignals(true);
+    verticesEditor_->blockSignals(true);
+    peakParticlesEditor_->setValue((int)budget.peakParticles_);
+    fillAreaEditor_->setValue((int)ceilf(budget.fillArea_));
+    verticesEditor_->setValue((int)budget.vertices_);
+    peakParticlesEditor_->blockSignals(false);
+    fillAreaEditor_->blockSignals(false);
+    verticesEditor_->blockSignals(false);
+
+    HandleBudgetChanged();
+}
+
+void EffectTiersWidget::HandleUseSelectedClicked()
+{
+    SetSourceLayer(ParticleEditor::Get()->GetSelectedLayer());
+}
+
+void EffectTiersWidget::HandleBudgetChanged()
+{
+    UpdateTable();
+    UpdateVariants(false);
+}
+
+void EffectTiersWidget::HandlePreviewClicked()
+{
+    UpdateVariants(true);
+}
+
+void EffectTiersWidget::HandleSaveClicked()
+{
+    for (unsigned i = 0; i < MAX_EFFECT_TIERS; ++i) {
+        LayerHandle layer = GetVariantLayer((EffectTier)i);
+        if (layer != INVALID_LAYER)
+            emit saveRequested(layer);
+    }
+}
+
+void EffectTiersWidget::HandleApplied(const QVector<unsigned>& layers)
+{
+    // Edits of the source carry over to the variants. Variant updates never list the source, so this does not recurse
+    if (!layers.contains(sourceLayer_))
+        return;
+    UpdateTable();
+    UpdateVariants(false);
+}
+
+bool EffectTiersWidget::GetSourceParams(EffectParams& params) const
+{
+    ParticleEffect2D* effect = sourceLayer_ != INVALID_LAYER ? ParticleEditor::Get()->GetEffect(sourceLayer_) : nullptr;
+    if (!effect)
+        return false;
+    ReadEffectParams(effect, params);
+    return true;
+}
+
+EffectBudget EffectTiersWidget::GetBudget() const
+{
+    EffectBudget budget;
+    budget.peakParticles_ = (float)peakParticlesEditor_->value();
+    budget.fillArea_ = (float)fillAreaEditor_->value();
+    budget.vertices_ = (float)verticesEditor_->value();
+    return budget;
+}
+
+LayerHandle EffectTiersWidget::GetVariantLayer(EffectTier tier) const
+{
+    ParticleEditor* editor = ParticleEditor::Get();
+    const String& fileName = editor->GetFileName(sourceLayer_);
+    if (sourceLayer_ == INVALID_LAYER || fileName.Empty())
+        return INVALID_LAYER;
+    return editor->FindLayer(GetTierFileName(fileName, tier));
+}
+
+void EffectTiersWidget::UpdateTable()
+{
+    EffectParams params;
+    const bool hasSource = GetSourceParams(params);
+    const EffectBudget budget = GetBudget();
+
+    for (unsigned i = 0; i < MAX_EFFECT_TIERS; ++i) {
+        const EffectTier tier = (EffectTier)i;
+        tableWidget_->setItem(i, COLUMN_TIER, new QTableWidgetItem(EFFECT_TIER_NAMES[i]));
+        if (!hasSource) {
+            for (int column = COLUMN_PARTICLES; column < NUM_COLUMNS; ++column)
+                tableWidget_->setItem(i, column, new QTableWidgetItem());
+            continue;
+        }
+
+        const EffectScales scales = GetTierScales(params, GetTierBudget(budget, tier));
+        const EffectBudget cost = GetEffectBudget(ScaleEffectParams(params, scales));
+        tableWidget_->setItem(i, COLUMN_PARTICLES, new QTableWidgetItem(QString::number(cost.peakParticles_, 'f', 0)));
+        tableWidget_->setItem(i, COLUMN_VERTICES, new QTableWidgetItem(QString::number(cost.vertices_, 'f', 0)));
+        tableWidget_->setItem(i, COLUMN_FILL, new QTableWidgetItem(QString::number(cost.fillArea_, 'f', 0)));
+        tableWidget_->setItem(i, COLUMN_RATE, new QTableWidgetItem(QString("x%1").arg(scales.rate_, 0, 'f', 2)));
+        tableWidget_->setItem(i, COLUMN_LIFESPAN, new QTableWidgetItem(QString("x%1").arg(scales.lifespan_, 0, 'f', 2)));
+        tableWidget_->setItem(i, COLUMN_SIZE, new QTableWidgetItem(QString("x%1").arg(scales.size_, 0, 'f', 2)));
+    }
+}
+
+void EffectTiersWidget::UpdateVariants(bool create)
+{
+    EffectParams params;
+    if (!GetSourceParams(params))
+        return;
+
+    ParticleEditor* editor = ParticleEditor::Get();
+    const String& fileName = editor->GetFileName(sourceLayer_);
+    const Vector2 position = editor->GetParticleNodePosition(sourceLayer_);
+    const EffectBudget budget = GetBudget();
+
+    QVector<unsigned> changedLayers;
+    for (unsigned i = 0; i < MAX_EFFECT_TIERS; ++i) {
+        const EffectTier tier = (EffectTier)i;
+        LayerHandle layer = GetVariantLayer(tier);
+        if (layer == INVALID_LAYER) {
+            if (!create)
+                continue;
+
+            // A clone until the first differing parameter splits it off, so an unchanged tier costs no simulation
+            layer = editor->CloneLayer(sourceLayer_, GetTierFileName(fileName, tier));
+            if (layer == INVALID_LAYER)
+                continue;
+            const Vector2 variantPosition = position + Vector2(VARIANT_SPACING * (i + 1), 0.0f);
+            editor->SetParticleNodePosition(layer, (int)variantPosition.x_, (int)variantPosition.y_);
+            emit layerCreated(layer);
+        }
+
+        // Every differing parameter, so edits of the source that are not scaled carry over too
+        const EffectParams tierParams = GetTierParams(params, budget, tier);
+        EffectParams current;
+        ReadEffectParams(editor->GetEffect(layer), current);
+        unsigned long long mask = 0;
+        for (unsigned j = 0; j < MAX_EFFECT_PARAMS; ++j) {
+            if (current.values_[j] != tierParams.values_[j])
+                mask |= 1ULL << j;
+        }
+
+        // Variants are derived, not edited, so they stay out of the undo history
+        if (mask && editor->GetEditQueue()->Apply(layer, mask, tierParams.values_))
+            changedLayers << layer;
+    }
+
+    editor->GetEditQueue()->NotifyApplied(changedLayers);
+}
+
+}
@@ -0,0 +1,88 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "EffectParams.h"
+#include "EffectTiers.h"
+#include "LayerTable.h"
+
+#include <QVector>
+#include <QWidget>
+
+class QLabel;
+class QSpinBox;
+class QTableWidget;
+
+namespace Urho3D
+{
+
+/// Derives low, medium and high variants of an effect from a budget and previews them as layers beside it. Variants
+/// are found by their file names, so they survive a restart like any other layer.
+class EffectTiersWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    EffectTiersWidget(QWidget* parent = nullptr);
+    virtual ~EffectTiersWidget();
+
+    /// Set layer to derive variants from. The budget starts at its current cost.
+    void SetSourceLayer(LayerHandle layer);
+
+signals:
+    /// Emitted when a variant layer was added to the scene.
+    void layerCreated(unsigned layer);
+    /// Emitted for every previewed variant to save.
+    void saveRequested(unsigned layer);
+
+private slots:
+    void HandleUseSelectedClicked();
+    void HandleBudgetChanged();
+    void HandlePreviewClicked();
+    void HandleSaveClicked();
+    void HandleApplied(const QVector<unsigned>& layers);
+
+private:
+    /// Read source parameters. Return false if there is no source.
+    bool GetSourceParams(EffectParams& params) const;
+    /// Return budget of the high tier.
+    EffectBudget GetBudget() const;
+    /// Return variant layer of tier, or invalid if it is not previewed.
+    LayerHandle GetVariantLayer(EffectTier tier) const;
+    /// Fill the tier table.
+    void UpdateTable();
+    /// Apply tier parameters to the variant layers, creating missing ones if create is set.
+    void UpdateVariants(bool create);
+
+    /// Layer variants are derived from.
+    LayerHandle sourceLayer_;
+
+    QLabel* sourceLabel_;
+    QSpinBox* peakParticlesEditor_;
+    QSpinBox* fillAreaEditor_;
+    QSpinBox* verticesEditor_;
+    QTableWidget* tableWidget_;
+};
+
+}
@@ -20,14 +20,17 @@
 // THE SOFTWARE.
 //
 
+#include "EditQueue.h"
+#include "EffectParams.h"
 #include "EmitterAttributeEditor.h"
 #include "FloatEditor.h"
 #include "IntEditor.h"
+#include "ParticleEditor.h"
+#include "TraceRecorder.h"
 #include "ValueVarianceEditor.h"
 #include "Vector2Editor.h"
 
 #include <Urho3D/Core/Context.h>
-#include <Urho3D/Core/CoreEvents.h>
 #include <Urho3D/Resource/ResourceCache.h>
 #include <Urho3D/Graphics/Texture2D.h>
 #include <Urho3D/Urho2D/ParticleEffect2D.h>
@@ -44,8 +47,7 @@
 namespace Urho3D
 {
 EmitterAttributeEditor::EmitterAttributeEditor(Context* context) :
-    ParticleEffectEditor(context),
-    maxParticlesChanged_(false)
+    ParticleEffectEditor(context)
 {
     CreateMaxParticlesEditor();
     CreateDurationEditor();
@@ -67,8 +69,6 @@ EmitterAttributeEditor::EmitterAttributeEditor(Context* context) :
     CreateRadialTypeEditor();
 
     vBoxLayout_->addStretch(1);
-
-    SubscribeToEvent(E_POSTUPDATE, URHO3D_HANDLER(EmitterAttributeEditor, HandlePostUpdate));
 }
 
 EmitterAttributeEditor::~EmitterAttributeEditor()
@@ -80,9 +80,7 @@ void EmitterAttributeEditor::HandleMaxParticlesEditorValueChanged(int value)
     if (updatingWidget_)
         return;
 
-    maxParticlesChanged_ = true;
-
-    emit changed( GetSelectedKey().CString() );
+    QueueEdit(PARAM_MAX_PARTICLES, (float)value);
 }
 
 void EmitterAttributeEditor::HandleDurationEditorValueChanged(float value)
@@ -90,11 +88,7 @@ void EmitterAttributeEditor::HandleDurationEditorValueChanged(float value)
     if (updatingWidget_)
         return;
 
-    if (ParticleEffect2D* effect = GetEffect( GetSelectedKey() )) {
-        effect->SetDuration(value);
-    }
-
-    emit changed( GetSelectedKey().CString() );
+    QueueEdit(PARAM_DURATION, value);
 }
 
 void EmitterAttributeEditor::HandleTexturePushButtonClicked()
@@ -109,6 +103,8 @@ void EmitterAttributeEditor::HandleTexturePushButtonClicked()
 
     fileName = fileName.right(fileName.length() - dataPath.length());
 
+    EDITOR_TRACE("EmitterAttributeEditor::SetTexture");
+
     ResourceCache* cache = GetSubsystem<ResourceCache>();
     Sprite2D* sprite = cache->GetResource<Sprite2D>(fileName.toLatin1().data());
     if (!sprite)
@@ -116,14 +112,20 @@ void EmitterAttributeEditor::HandleTexturePushButtonClicked()
 
     textureEditor_->setText(fileName);
 
-    if (ParticleEffect2D* effect = GetEffect( GetSelectedKey() )) {
-        effect->SetSprite(sprite);
-    }
-    if (ParticleEmitter2D* emitter =  GetEmitter( GetSelectedKey() )) {
-        emitter->SetSprite(sprite);
-    }
+    PODVector<LayerHandle> layers = ParticleEditor::Get()->GetSelectedLayers();
+    if (!layers.Contains(GetSelectedLayer()))
+        layers.Push(GetSelectedLayer());
 
-    emit changed( GetSelectedKey().CString() );
+    for (unsigned i = 0; i < layers.Size(); ++i) {
+        if (ParticleEffect2D* effect = GetEffectForEdit( layers[i] )) {
+            effect->SetSprite(sprite);
+        }
+        if (ParticleEmitter2D* emitter =  GetEmitter( layers[i] )) {
+            emitter->SetSprite(sprite);
+        }
+
+        ParticleEditor::Get()->GetEditQueue()->MarkChanged(layers[i]);
+    }
 }
 
 void EmitterAttributeEditor::HandleBlendModeEditorChanged(int index)
@@ -131,14 +133,7 @@ void EmitterAttributeEditor::HandleBlendModeEditorChanged(int index)
     if (updatingWidget_)
         return;
 
-    if (ParticleEffect2D* effect = GetEffect( GetSelectedKey() )) {
-        effect->SetBlendMode((BlendMode)index);
-    }
-    if (ParticleEmitter2D* emitter =  GetEmitter( GetSelectedKey() )) {
-        emitter->SetBlendMode((BlendMode)index);
-    }
-
-    emit changed( GetSelectedKey().CString() );
+    QueueEdit(PARAM_BLEND_MODE, (float)index);
 }
 
 void EmitterAttributeEditor::HandleEmitterTypeEditorChanged(int index)
@@ -150,11 +145,7 @@ void EmitterAttributeEditor::HandleEmitterTypeEditorChanged(int index)
     if (updatingWidget_)
         return;
 
-    if (ParticleEffect2D* effect = GetEffect( GetSelectedKey() )) {
-        effect->SetEmitterType(emitterType);
-    }
-
-    emit changed( GetSelectedKey().CString() );
+    QueueEdit(PARAM_EMITTER_TYPE, (float)emitterType);
 }
 
 void EmitterAttributeEditor::HandleSourcePositionVarianceEditorValueChanged(const Vector2& value)
@@ -162,11 +153,7 @@ void EmitterAttributeEditor::HandleSourcePositionVarianceEditorValueChanged(cons
     if (updatingWidget_)
         return;
 
-    if (ParticleEffect2D* effect = GetEffect( GetSelectedKey() )) {
-        effect->SetSourcePositionVariance(value);
-    }
-
-    emit changed( GetSelectedKey().CString() );
+    QueueEdit(PARAM_SOURCE_POSITION_VARIANCE_X, value);
 }
 
 void EmitterAttributeEditor::HandleGravityEditorValueChanged(const Vector2& value)
@@ -174,11 +161,7 @@ void EmitterAttributeEditor::HandleGravityEditorValueChanged(const Vector2& valu
     if (updatingWidget_)
         return;
 
-    if (ParticleEffect2D* effect = GetEffect( GetSelectedKey() )) {
-        effect->SetGravity(value);
-    }
-
-    emit changed( GetSelectedKey().CString() );
+    QueueEdit(PARAM_GRAVITY_X, value);
 }
 
 void EmitterAttributeEditor::HandleValueVarianceEditorValueChanged(float average, float variance)
@@ -187,55 +170,48 @@ void EmitterAttributeEditor::HandleValueVarianceEditorValueChanged(float average
         return;
 
     QObject* s = sender();
-    ParticleEffect2D* effect = GetEffect( GetSelectedKey() );
-    if (!effect) {
-        return;
-    }
-
     if (s == speedEditor_)
     {
-        effect->SetSpeed(speedEditor_->value());
-        effect->SetSpeedVariance(speedEditor_->variance());
+        QueueEdit(PARAM_SPEED, average);
+        QueueEdit(PARAM_SPEED_VARIANCE, variance);
     }
     else if (s == angleEditor_)
     {
-        effect->SetAngle(angleEditor_->value());
-        effect->SetAngleVariance(angleEditor_->variance());
+        QueueEdit(PARAM_ANGLE, average);
+        QueueEdit(PARAM_ANGLE_VARIANCE, variance);
     }
     else if (s == radialAccelerationEditor_)
     {
-        effect->SetRadialAcceleration(radialAccelerationEditor_->value());
-        effect->SetRadialAccelVariance(radialAccelerationEditor_->variance());
-
+        QueueEdit(PARAM_RADIAL_ACCELERATION, average);
+        QueueEdit(PARAM_RADIAL_ACCEL_VARIANCE, variance);
     }
     else if (s == tangentialAccelerationEditor_)
     {
-        effect->SetTangentialAcceleration(tangentialAccelerationEditor_->value());
-        effect->SetTangentialAccelVariance(tangentialAccelerationEditor_->variance());
+        QueueEdit(PARAM_TANGENTIAL_ACCELERATION, average);
+        QueueEdit(PARAM_TANGENTIAL_ACCEL_VARIANCE, variance);
     }
     else if (s == maxRadiusEditor_)
     {
-        effect->SetMaxRadius(maxRadiusEditor_->value());
-        effect->SetMaxRadiusVariance(maxRadiusEditor_->variance());
-
+        QueueEdit(PARAM_MAX_RADIUS, average);
+        QueueEdit(PARAM_MAX_RADIUS_VARIANCE, variance);
     }
     else if (s == minRadiusEditor_)
     {
-        effect->SetMinRadius(minRadiusEditor_->value());
-        effect->SetMinRadiusVariance(minRadiusEditor_->variance());
+        QueueEdit(PARAM_MIN_RADIUS, average);
+        QueueEdit(PARAM_MIN_RADIUS_VARIANCE, variance);
     }
     else if (s == rotatePerSecondEditor_)
     {
-        effect->SetRotatePerSecond(rotatePerSecondEditor_->value());
-        effect->SetRotatePerSecondVariance(rotatePerSecondEditor_->variance());
+        QueueEdit(PARAM_ROTATE_PER_SECOND, average);
+        QueueEdit(PARAM_ROTATE_PER_SECOND_VARIANCE, variance);
     }
-
-    emit changed( GetSelectedKey().CString() );
 }
 
 void EmitterAttributeEditor::HandleUpdateWidget()
 {
-    ParticleEffect2D* effect_ = GetEffect( GetSelectedKey() );
+    EDITOR_TRACE("EmitterAttributeEditor::HandleUpdateWidget");
+
+    ParticleEffect2D* effect_ = GetEffect( GetSelectedLayer() );
     if (!effect_) {
         return;
     }
@@ -307,22 +283,8 @@ void EmitterAttributeEditor::CreateBlendModeEditor()
     blendModeEditor_ = new QComboBox();
     hBoxLayout->addWidget(blendModeEditor_, 1);
 
-    const char* blendModeNames[] =
-    {
-        "replace",
-        "add",
-        "multiply",
-        "alpha",
-        "addalpha",
-        "premulalpha",
-        "invdestalpha",
-        "subtract",
-        "subtractalpha",
-        0
-    };
-
     for (unsigned i = 0; i < MAX_BLENDMODES; ++i)
-        blendModeEditor_->addItem(blendModeNames[i], i);
+        blendModeEditor_->addItem(BLEND_MODE_NAMES[i], i);
 
     connect(blendModeEditor_,SIGNAL(currentIndexChanged(int)),this,SLOT(HandleBlendModeEditorChanged(int)));
 }
@@ -396,19 +358,4 @@ ValueVarianceEditor* EmitterAttributeEditor::CreateValueVarianceEditor(const QSt
     return editor;
 }
 
-void EmitterAttributeEditor::HandlePostUpdate(StringHash eventType, VariantMap& eventData)
-{
-    if (!maxParticlesChanged_)
-        return;
-
-    maxParticlesChanged_ = false;
-
-    if (ParticleEffect2D* effect = GetEffect( GetSelectedKey() )) {
-        effect->SetMaxParticles(maxParticlesEditor_->value());
-    }
-    if (ParticleEmitter2D* emitter = GetEmitter( GetSelectedKey() )) {
-        emitter->SetMaxParticles(maxParticlesEditor_->value());
-    }
-}
-
 } // namespace Urho3D
@@ -45,9 +45,6 @@ public:
     EmitterAttributeEditor(Context* context);
     virtual ~EmitterAttributeEditor();
 
-signals:
-    void changed(QString);
-
 private slots:
     void HandleMaxParticlesEditorValueChanged(int value);
     void HandleDurationEditorValueChanged(float value);    
@@ -75,12 +72,8 @@ private:
     void ShowGravityTypeEditor(bool visible);
     ValueVarianceEditor* CreateValueVarianceEditor(const QString& name, float min, float max);
 
-    void HandlePostUpdate(StringHash eventType, VariantMap& eventData);
-
     /// Max particle editor.
     IntEditor* maxParticlesEditor_;
-    /// Is max particles changed.
-    bool maxParticlesChanged_;
     /// Duration editor.
     FloatEditor* durationEditor_;
     /// Texture editor.
@@ -0,0 +1,89 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "FrameTimings.h"
+
+#include <cstdio>
+
+namespace Urho3D
+{
+
+float FrameTimings::Resolution::GetMSecPerMegapixel() const
+{
+    const float megapixels = size_.x_ * size_.y_ / 1000000.0f;
+    return megapixels > 0.0f ? GetAverageMSec() / megapixels : 0.0f;
+}
+
+FrameTimings::FrameTimings() :
+    current_(0)
+{
+}
+
+void FrameTimings::AddFrame(const IntVector2& size, long long usec)
+{
+    // The size rarely changes, so the last resolution is checked first
+    if (current_ >= resolutions_.Size() || resolutions_[current_].size_ != size)
+    {
+        current_ = 0;
+        while (current_ < resolutions_.Size() && resolutions_[current_].size_ != size)
+            ++current_;
+
+        if (current_ == resolutions_.Size())
+        {
+            Resolution resolution;
+            resolution.size_ = size;
+            resolution.frames_ = 0;
+            resolution.totalUSec_ = 0;
+            resolution.maxUSec_ = 0;
+            resolutions_.Push(resolution);
+        }
+    }
+
+    Resolution& resolution = resolutions_[current_];
+    ++resolution.frames_;
+    resolution.totalUSec_ += usec;
+    if (usec > resolution.maxUSec_)
+        resolution.maxUSec_ = usec;
+}
+
+void FrameTimings::Clear()
+{
+    resolutions_.Clear();
+    current_ = 0;
+}
+
+String FrameTimings::GetReport() const
+{
+    String report;
+    char line[128];
+    for (unsigned i = 0; i < resolutions_.Size(); ++i)
+    {
+        const Resolution& resolution = resolutions_[i];
+        snprintf(line, sizeof line, "%dx%d: %u frames, avg %.2f ms, max %.2f ms, %.2f ms/Mpx\n", resolution.size_.x_,
+            resolution.size_.y_, resolution.frames_, resolution.GetAverageMSec(), resolution.maxUSec_ / 1000.0f,
+            resolution.GetMSecPerMegapixel());
+        report += line;
+    }
+    return report;
+}
+
+}
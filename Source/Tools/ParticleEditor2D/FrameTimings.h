@@ -0,0 +1,73 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include <Urho3D/Container/Str.h>
+#include <Urho3D/Container/Vector.h>
+#include <Urho3D/Math/Vector2.h>
+
+namespace Urho3D
+{
+
+/// Frame time statistics per backbuffer resolution, to compare fill-rate cost across monitors.
+class FrameTimings
+{
+public:
+    /// Statistics of one resolution.
+    struct Resolution
+    {
+        /// Backbuffer size.
+        IntVector2 size_;
+        /// Number of frames.
+        unsigned frames_;
+        /// Sum of frame times in microseconds.
+        long long totalUSec_;
+        /// Longest frame time in microseconds.
+        long long maxUSec_;
+
+        /// Return average frame time in milliseconds.
+        float GetAverageMSec() const { return frames_ ? totalUSec_ / 1000.0f / frames_ : 0.0f; }
+        /// Return average frame time per megapixel in milliseconds.
+        float GetMSecPerMegapixel() const;
+    };
+
+    /// Construct.
+    FrameTimings();
+
+    /// Add frame rendered at size.
+    void AddFrame(const IntVector2& size, long long usec);
+    /// Remove all statistics.
+    void Clear();
+    /// Return statistics, in order of first use.
+    const PODVector<Resolution>& GetResolutions() const { return resolutions_; }
+    /// Return one line per resolution.
+    String GetReport() const;
+
+private:
+    /// Statistics per resolution.
+    PODVector<Resolution> resolutions_;
+    /// Index of the resolution of the last frame.
+    unsigned current_;
+};
+
+}
@@ -0,0 +1,260 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "LayerStats.h"
+#include "ParticleEditor.h"
+
+#include <Urho3D/Container/HashMap.h>
+#include <Urho3D/Core/CoreEvents.h>
+#include <Urho3D/Graphics/Camera.h>
+#include <Urho3D/Graphics/Graphics.h>
+#include <Urho3D/Graphics/GraphicsEvents.h>
+#include <Urho3D/Graphics/Texture2D.h>
+#include <Urho3D/Scene/Scene.h>
+#include <Urho3D/Scene/SceneEvents.h>
+#include <Urho3D/Urho2D/Drawable2D.h>
+#include <Urho3D/Urho2D/ParticleEffect2D.h>
+#include <Urho3D/Urho2D/ParticleEmitter2D.h>
+#include <Urho3D/Urho2D/Sprite2D.h>
+
+namespace Urho3D
+{
+
+/// Sample interval in milliseconds.
+static const unsigned SAMPLE_INTERVAL_MS = 250;
+
+LayerStats::LayerStats(Context* context) :
+    Object(context),
+    timing_(false),
+    intervalUSec_(0),
+    intervalFrames_(0),
+    frameUSec_(0),
+    countPending_(false),
+    sceneUpdateUSec_(0.0f),
+    totalMemory_(0),
+    peakTotalMemory_(0)
+{
+    SubscribeToEvent(E_POSTUPDATE, URHO3D_HANDLER(LayerStats, HandlePostUpdate));
+    SubscribeToEvent(E_ENDRENDERING, URHO3D_HANDLER(LayerStats, HandleEndRendering));
+}
+
+void LayerStats::SetScene(Scene* scene)
+{
+    SubscribeToEvent(scene, E_SCENEUPDATE, URHO3D_HANDLER(LayerStats, HandleSceneUpdate));
+}
+
+void LayerStats::HandleSceneUpdate(StringHash eventType, VariantMap& eventData)
+{
+    // Emitters update later in the same scene update, on E_SCENEPOSTUPDATE
+    updateTimer_.Reset();
+    timing_ = true;
+}
+
+void LayerStats::HandlePostUpdate(StringHash eventType, VariantMap& eventData)
+{
+    if (!timing_)
+        return;
+    timing_ = false;
+
+    frameUSec_ = updateTimer_.GetUSec(false);
+    intervalUSec_ += frameUSec_;
+    ++intervalFrames_;
+    countPending_ = true;
+}
+
+void LayerStats::HandleEndRendering(StringHash eventType, VariantMap& eventData)
+{
+    if (!countPending_)
+        return;
+    countPending_ = false;
+
+    ParticleEditor* editor = ParticleEditor::Get();
+    const QList<LayerHandle> layers = editor->GetLayers();
+    unsigned totalParticles = 0;
+
+    for (LayerHandle layer: layers)
+    {
+        LayerStatsEntry* entry = entries_.Get(layer);
+        if (!entry)
+        {
+            entries_.InsertAt(layer, LayerStatsEntry());
+            entry = entries_.Get(layer);
+        }
+
+        entry->particles_ = 0;
+        entry->vertices_ = 0;
+        entry->batches_ = 0;
+
+        ParticleEmitter2D* emitter = editor->GetEmitter(layer);
+        if (!emitter)
+            continue;
+        entry->maxParticles_ = emitter->GetMaxParticles();
+
+        // Renderer2D built the vertices of drawn emitters this frame, so reading them costs nothing extra. Asking
+        // any other emitter would build vertices nobody draws.
+        if (!emitter->IsEnabledEffective() || !emitter->IsInView())
+            continue;
+        const Vector<SourceBatch2D>& batches = emitter->GetSourceBatches();
+        entry->memory_.vertices_ = 0;
+        for (unsigned i = 0; i < batches.Size(); ++i)
+        {
+            entry->memory_.vertices_ += GetVertexArrayMemory(batches[i].vertices_.Capacity());
+            if (batches[i].vertices_.Empty())
+                continue;
+            entry->vertices_ += batches[i].vertices_.Size();
+            ++entry->batches_;
+        }
+
+        // One quad per visible particle
+        entry->particles_ = entry->vertices_ / 4;
+        entry->peakParticles_ = Max(entry->peakParticles_, entry->particles_);
+        totalParticles += entry->particles_;
+    }
+
+    for (LayerHandle layer: layers)
+    {
+        LayerStatsEntry* entry = entries_.Get(layer);
+        if (totalParticles)
+            entry->intervalUSec_ += (float)frameUSec_ * entry->particles_ / totalParticles;
+        ++entry->intervalFrames_;
+    }
+
+    if (sampleTimer_.GetMSec(false) >= SAMPLE_INTERVAL_MS)
+    {
+        sampleTimer_.Reset();
+        Sample();
+    }
+}
+
+void LayerStats::Sample()
+{
+    ParticleEditor* editor = ParticleEditor::Get();
+    Graphics* graphics = GetSubsystem<Graphics>();
+    Camera* camera = editor->GetCamera();
+
+    // World area to screen fraction: the ortho size maps the screen height to world units
+    float areaScale = 0.0f;
+    if (camera && graphics && graphics->GetHeight())
+    {
+        const float pixelsPerUnit = graphics->GetHeight() * camera->GetZoom() / camera->GetOrthoSize();
+        areaScale = pixelsPerUnit * pixelsPerUnit / ((float)graphics->GetWidth() * graphics->GetHeight());
+    }
+
+    const QList<LayerHandle> layers = editor->GetLayers();
+    for (LayerHandle layer: layers)
+    {
+        LayerStatsEntry* entry = entries_.Get(layer);
+        if (!entry)
+            continue;
+
+        entry->updateUSec_ = entry->intervalFrames_ ? entry->intervalUSec_ / entry->intervalFrames_ : 0.0f;
+        entry->intervalUSec_ = 0.0f;
+        entry->intervalFrames_ = 0;
+
+        entry->history_[entry->historyPos_] = (unsigned short)Min(entry->particles_, 65535U);
+        entry->historyPos_ = (entry->historyPos_ + 1) % LAYER_STATS_HISTORY;
+
+        // Quads are parallelograms, their area is the cross product of two edges. Off-screen parts count too.
+        // Vertices were only counted if the emitter was drawn this frame, so they are built already.
+        float area = 0.0f;
+        ParticleEmitter2D* emitter = editor->GetEmitter(layer);
+        if (emitter && entry->vertices_)
+        {
+            const Vector<SourceBatch2D>& batches = emitter->GetSourceBatches();
+            for (unsigned i = 0; i < batches.Size(); ++i)
+            {
+                const Vector<Vertex2D>& vertices = batches[i].vertices_;
+                for (unsigned j = 0; j + 3 < vertices.Size(); j += 4)
+                {
+                    const Vector3& v0 = vertices[j].position_;
+                    const Vector3 a = vertices[j + 1].position_ - v0;
+                    const Vector3 b = vertices[j + 3].position_ - v0;
+                    area += Abs(a.x_ * b.y_ - a.y_ * b.x_);
+                }
+            }
+        }
+        entry->overdraw_ = area * areaScale;
+    }
+
+    sceneUpdateUSec_ = intervalFrames_ ? (float)intervalUSec_ / intervalFrames_ : 0.0f;
+    intervalUSec_ = 0;
+    intervalFrames_ = 0;
+
+    SampleMemory();
+
+    emit sampled();
+}
+
+void LayerStats::SampleMemory()
+{
+    ParticleEditor* editor = ParticleEditor::Get();
+    const QList<LayerHandle> layers = editor->GetLayers();
+
+    // Count users first so shared effects and textures can be split between them
+    HashMap<const ParticleEffect2D*, unsigned> effectUsers;
+    HashMap<const Texture2D*, unsigned> textureUsers;
+    for (LayerHandle layer: layers)
+    {
+        const ParticleEffect2D* effect = editor->GetEffect(layer);
+        if (!effect)
+            continue;
+        ++effectUsers[effect];
+        if (const Sprite2D* sprite = effect->GetSprite())
+        {
+            if (const Texture2D* texture = sprite->GetTexture())
+                ++textureUsers[texture];
+        }
+    }
+
+    totalMemory_ = 0;
+    for (LayerHandle layer: layers)
+    {
+        LayerStatsEntry* entry = entries_.Get(layer);
+        ParticleEmitter2D* emitter = editor->GetEmitter(layer);
+        if (!entry || !emitter)
+            continue;
+
+        // The vertex array keeps its largest size, as last seen when the emitter was drawn
+        EffectMemory& memory = entry->memory_;
+        const unsigned vertices = memory.vertices_;
+        memory = EffectMemory();
+        memory.particles_ = GetParticleArrayMemory(emitter->GetMaxParticles());
+        memory.vertices_ = vertices;
+        memory.emitter_ = sizeof(ParticleEmitter2D);
+
+        if (const ParticleEffect2D* effect = emitter->GetEffect())
+        {
+            memory.effect_ = sizeof(ParticleEffect2D) / effectUsers[effect];
+            const Sprite2D* sprite = effect->GetSprite();
+            const Texture2D* texture = sprite ? sprite->GetTexture() : nullptr;
+            if (texture)
+                memory.texture_ = texture->GetMemoryUse() / textureUsers[texture];
+        }
+
+        entry->peakMemory_ = Max(entry->peakMemory_, memory.GetTotal());
+        totalMemory_ += memory.GetTotal();
+    }
+
+    peakTotalMemory_ = Max(peakTotalMemory_, totalMemory_);
+}
+
+}
@@ -0,0 +1,140 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "EffectMemory.h"
+#include "LayerTable.h"
+
+#include <Urho3D/Core/Object.h>
+#include <Urho3D/Core/Timer.h>
+
+#include <QObject>
+
+namespace Urho3D
+{
+
+class Scene;
+
+/// Number of samples kept per layer for the history sparkline.
+static const unsigned LAYER_STATS_HISTORY = 64;
+
+/// Runtime cost of one layer.
+struct LayerStatsEntry
+{
+    /// Live particles in the last frame, zero if the layer was not drawn.
+    unsigned particles_ = 0;
+    /// Most live particles since the layer was added.
+    unsigned peakParticles_ = 0;
+    /// Particle limit of the emitter.
+    unsigned maxParticles_ = 0;
+    /// Update time in microseconds, averaged over the last sample interval.
+    float updateUSec_ = 0.0f;
+    /// Vertices generated in the last frame.
+    unsigned vertices_ = 0;
+    /// Source batches submitted in the last frame.
+    unsigned batches_ = 0;
+    /// Covered screen area divided by screen size, from the last sample.
+    float overdraw_ = 0.0f;
+    /// Live particles per sample, oldest at historyPos_.
+    unsigned short history_[LAYER_STATS_HISTORY] = {};
+    /// Next history slot to write.
+    unsigned historyPos_ = 0;
+    /// Attributed memory, from the last sample.
+    EffectMemory memory_;
+    /// Most attributed memory since the layer was added.
+    unsigned peakMemory_ = 0;
+
+    /// Sum of apportioned update times in the current interval.
+    float intervalUSec_ = 0.0f;
+    /// Frames in the current interval.
+    unsigned intervalFrames_ = 0;
+};
+
+/// Collects per-layer particle counts, update cost, geometry, overdraw and memory. Counts come from the vertices
+/// Renderer2D built for drawn emitters and are read once per frame after rendering; overdraw walks the same vertices
+/// only a few times per second, so the collector can stay on. Layers that are hidden or off-screen count no particles.
+/// Emitters update inside the scene update, which is timed as a whole and shared out by live particles.
+class LayerStats : public QObject, public Object
+{
+    Q_OBJECT
+    URHO3D_OBJECT(LayerStats, Object)
+
+public:
+    /// Construct.
+    LayerStats(Context* context);
+
+    /// Set scene whose update is timed.
+    void SetScene(Scene* scene);
+    /// Forget layer.
+    void Remove(LayerHandle layer) { entries_.Remove(layer); }
+
+    /// Return statistics of layer, or null if not collected yet.
+    const LayerStatsEntry* Get(LayerHandle layer) const { return entries_.Get(layer); }
+    /// Return scene update time of the last sample interval in microseconds.
+    float GetSceneUpdateUSec() const { return sceneUpdateUSec_; }
+    /// Return memory attributed to all layers, from the last sample.
+    unsigned GetTotalMemory() const { return totalMemory_; }
+    /// Return most memory attributed to all layers during the session.
+    unsigned GetPeakTotalMemory() const { return peakTotalMemory_; }
+
+signals:
+    /// Emitted after every sample interval.
+    void sampled();
+
+private:
+    /// Handle scene update, start of the timed section.
+    void HandleSceneUpdate(StringHash eventType, VariantMap& eventData);
+    /// Handle post update, end of the timed section.
+    void HandlePostUpdate(StringHash eventType, VariantMap& eventData);
+    /// Handle end of rendering, count what was drawn.
+    void HandleEndRendering(StringHash eventType, VariantMap& eventData);
+    /// Finish sample interval.
+    void Sample();
+    /// Attribute memory to every layer.
+    void SampleMemory();
+
+    /// Statistics by layer.
+    LayerTable<LayerStatsEntry> entries_;
+    /// Times the scene update.
+    HiresTimer updateTimer_;
+    /// Scene update is being timed.
+    bool timing_;
+    /// Time since the last sample.
+    Timer sampleTimer_;
+    /// Sum of scene update times in the current interval.
+    long long intervalUSec_;
+    /// Frames in the current interval.
+    unsigned intervalFrames_;
+    /// Scene update time of the last frame.
+    long long frameUSec_;
+    /// The last scene update is not counted yet.
+    bool countPending_;
+    /// Scene update time of the last interval.
+    float sceneUpdateUSec_;
+    /// Memory of all layers.
+    unsigned totalMemory_;
+    /// Session high-water mark of totalMemory_.
+    unsigned peakTotalMemory_;
+};
+
+}
@@ -0,0 +1,278 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "LayerStats.h"
+#include "LayerStatsWidget.h"
+#include "ParticleEditor.h"
+
+#include <Urho3D/Math/MathDefs.h>
+
+#include <QAbstractTableModel>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPainter>
+#include <QSortFilterProxyModel>
+#include <QStyledItemDelegate>
+#include <QTableView>
+#include <QVBoxLayout>
+
+namespace Urho3D
+{
+
+enum LayerStatsColumn
+{
+    COLUMN_LAYER = 0,
+    COLUMN_PARTICLES,
+    COLUMN_PEAK,
+    COLUMN_UPDATE,
+    COLUMN_VERTICES,
+    COLUMN_BATCHES,
+    COLUMN_OVERDRAW,
+    COLUMN_MEMORY,
+    COLUMN_PEAK_MEMORY,
+    COLUMN_HISTORY,
+    NUM_COLUMNS
+};
+
+/// Role of the numeric value columns are sorted by.
+static const int SORT_ROLE = Qt::UserRole;
+
+static QString FormatKB(unsigned bytes)
+{
+    return QString::number(bytes / 1024.0, 'f', 1);
+}
+
+/// Layers and their statistics. Values are read from LayerStats on demand, so a refresh only marks rows changed.
+class LayerStatsModel : public QAbstractTableModel
+{
+public:
+    LayerStatsModel(QObject* parent) :
+        QAbstractTableModel(parent),
+        layerStats_(nullptr)
+    {
+    }
+
+    void SetLayerStats(LayerStats* layerStats) { layerStats_ = layerStats; }
+
+    void Refresh()
+    {
+        QList<LayerHandle> layers = ParticleEditor::Get()->GetLayers();
+        if (layers != layers_) {
+            beginResetModel();
+            layers_.swap(layers);
+            endResetModel();
+        }
+        else if (!layers_.isEmpty()) {
+            emit dataChanged(index(0, 0), index(layers_.size() - 1, NUM_COLUMNS - 1));
+        }
+    }
+
+    const LayerStatsEntry* GetEntry(int row) const
+    {
+        return layerStats_ && row < layers_.size() ? layerStats_->Get(layers_[row]) : nullptr;
+    }
+
+    virtual int rowCount(const QModelIndex& parent = QModelIndex()) const
+    {
+        return parent.isValid() ? 0 : layers_.size();
+    }
+
+    virtual int columnCount(const QModelIndex& parent = QModelIndex()) const
+    {
+        return parent.isValid() ? 0 : NUM_COLUMNS;
+    }
+
+    virtual QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const
+    {
+        static const char* names[] = { "Layer", "Particles", "Peak / Max", "Update us", "Vertices", "Batches",
+            "Overdraw", "KB", "Peak KB", "History" };
+
+        if (orientation != Qt::Horizontal || role != Qt::DisplayRole || section >= NUM_COLUMNS)
+            return QVariant();
+        return QString(names[section]);
+    }
+
+    virtual QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const
+    {
+        if (!index.isValid() || index.row() >= layers_.size())
+            return QVariant();
+
+        const int column = index.column();
+        if (column == COLUMN_LAYER && (role == Qt::DisplayRole || role == SORT_ROLE)) {
+            QString fileName(ParticleEditor::Get()->GetFileName(layers_[index.row()]).CString());
+            return fileName.mid(fileName.lastIndexOf('/') + 1);
+        }
+
+        const LayerStatsEntry* entry = GetEntry(index.row());
+        if (!entry)
+            return QVariant();
+
+        if (role == Qt::DisplayRole) {
+            switch (column) {
+            case COLUMN_PARTICLES: return entry->particles_;
+            case COLUMN_PEAK: return QString("%1 / %2").arg(entry->peakParticles_).arg(entry->maxParticles_);
+            case COLUMN_UPDATE: return QString::number(entry->updateUSec_, 'f', 1);
+            case COLUMN_VERTICES: return entry->vertices_;
+            case COLUMN_BATCHES: return entry->batches_;
+            case COLUMN_OVERDRAW: return QString::number(entry->overdraw_, 'f', 2);
+            case COLUMN_MEMORY: return FormatKB(entry->memory_.GetTotal());
+            case COLUMN_PEAK_MEMORY: return FormatKB(entry->peakMemory_);
+            default: return QVariant();
+            }
+        }
+        if (role == SORT_ROLE) {
+            switch (column) {
+            case COLUMN_PARTICLES: return entry->particles_;
+            case COLUMN_PEAK: return entry->maxParticles_ ? (double)entry->peakParticles_ / entry->maxParticles_ : 0.0;
+            case COLUMN_UPDATE: return entry->updateUSec_;
+            case COLUMN_VERTICES: return entry->vertices_;
+            case COLUMN_BATCHES: return entry->batches_;
+            case COLUMN_OVERDRAW: return entry->overdraw_;
+            case COLUMN_MEMORY: return entry->memory_.GetTotal();
+            case COLUMN_PEAK_MEMORY: return entry->peakMemory_;
+            case COLUMN_HISTORY: return entry->peakParticles_;
+            default: return QVariant();
+            }
+        }
+        if (role == Qt::TextAlignmentRole && column != COLUMN_LAYER)
+            return int(Qt::AlignRight | Qt::AlignVCenter);
+        if (role == Qt::ToolTipRole && column == COLUMN_OVERDRAW)
+            return tr("Particle area divided by screen area, off-screen parts included");
+        if (role == Qt::ToolTipRole && column == COLUMN_UPDATE)
+            return tr("Scene update time shared out by live particles");
+        if (role == Qt::ToolTipRole && column == COLUMN_MEMORY) {
+            const EffectMemory& memory = entry->memory_;
+            return tr("particles %1 KB\nvertices %2 KB\nemitter %3 KB\neffect %4 KB\ntexture %5 KB\n"
+                "shared effects and textures are split between their layers")
+                .arg(FormatKB(memory.particles_)).arg(FormatKB(memory.vertices_)).arg(FormatKB(memory.emitter_))
+                .arg(FormatKB(memory.effect_)).arg(FormatKB(memory.texture_));
+        }
+        return QVariant();
+    }
+
+private:
+    LayerStats* layerStats_;
+    QList<LayerHandle> layers_;
+};
+
+/// Paints the particle count history as a line scaled to the layer limit.
+class SparklineDelegate : public QStyledItemDelegate
+{
+public:
+    SparklineDelegate(LayerStatsModel* model, QSortFilterProxyModel* proxyModel, QObject* parent) :
+        QStyledItemDelegate(parent),
+        model_(model),
+        proxyModel_(proxyModel)
+    {
+    }
+
+    virtual void paint(QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index) const
+    {
+        QStyledItemDelegate::paint(painter, option, index);
+
+        const LayerStatsEntry* entry = model_->GetEntry(proxyModel_->mapToSource(index).row());
+        if (!entry)
+            return;
+
+        const float top = (float)Max(Max(entry->maxParticles_, entry->peakParticles_), 1U);
+        const QRectF rect = QRectF(option.rect).adjusted(2.0, 2.0, -2.0, -2.0);
+        const qreal step = rect.width() / (LAYER_STATS_HISTORY - 1);
+
+        QPointF points[LAYER_STATS_HISTORY];
+        for (unsigned i = 0; i < LAYER_STATS_HISTORY; ++i) {
+            const unsigned value = entry->history_[(entry->historyPos_ + i) % LAYER_STATS_HISTORY];
+            points[i] = QPointF(rect.left() + i * step, rect.bottom() - rect.height() * value / top);
+        }
+
+        static const QPen pen(QColor(80, 200, 120), 1.0);
+        painter->save();
+        painter->setRenderHint(QPainter::Antialiasing);
+        painter->setPen(pen);
+        painter->drawPolyline(points, LAYER_STATS_HISTORY);
+        painter->restore();
+    }
+
+private:
+    LayerStatsModel* model_;
+    QSortFilterProxyModel* proxyModel_;
+};
+
+LayerStatsWidget::LayerStatsWidget(QWidget* parent) :
+    QWidget(parent),
+    layerStats_(nullptr)
+{
+    QVBoxLayout* vBoxLayout = new QVBoxLayout();
+    setLayout(vBoxLayout);
+
+    model_ = new LayerStatsModel(this);
+    proxyModel_ = new QSortFilterProxyModel(this);
+    proxyModel_->setSourceModel(model_);
+    proxyModel_->setSortRole(SORT_ROLE);
+    proxyModel_->setDynamicSortFilter(true);
+
+    tableView_ = new QTableView();
+    tableView_->setModel(proxyModel_);
+    tableView_->setItemDelegateForColumn(COLUMN_HISTORY, new SparklineDelegate(model_, proxyModel_, this));
+    tableView_->setSortingEnabled(true);
+    tableView_->sortByColumn(COLUMN_UPDATE, Qt::DescendingOrder);
+    tableView_->setSelectionBehavior(QAbstractItemView::SelectRows);
+    tableView_->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    tableView_->verticalHeader()->hide();
+    tableView_->verticalHeader()->setDefaultSectionSize(tableView_->fontMetrics().height() + 6);
+    tableView_->horizontalHeader()->setSectionResizeMode(COLUMN_LAYER, QHeaderView::Stretch);
+    tableView_->horizontalHeader()->resizeSection(COLUMN_HISTORY, LAYER_STATS_HISTORY * 2);
+    vBoxLayout->addWidget(tableView_, 1);
+
+    statusLabel_ = new QLabel();
+    vBoxLayout->addWidget(statusLabel_);
+}
+
+LayerStatsWidget::~LayerStatsWidget()
+{
+}
+
+void LayerStatsWidget::SetLayerStats(LayerStats* layerStats)
+{
+    if (layerStats_)
+        disconnect(layerStats_, nullptr, this, nullptr);
+
+    layerStats_ = layerStats;
+    model_->SetLayerStats(layerStats);
+
+    if (layerStats_)
+        connect(layerStats_, SIGNAL(sampled()), this, SLOT(HandleSampled()));
+}
+
+void LayerStatsWidget::HandleSampled()
+{
+    // Collection runs regardless, the table only follows while it can be seen
+    if (!isVisible())
+        return;
+
+    model_->Refresh();
+    statusLabel_->setText(tr("Scene update %1 us, memory %2 KB, peak %3 KB")
+        .arg(layerStats_->GetSceneUpdateUSec(), 0, 'f', 1)
+        .arg(FormatKB(layerStats_->GetTotalMemory()))
+        .arg(FormatKB(layerStats_->GetPeakTotalMemory())));
+}
+
+}
@@ -0,0 +1,64 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include <QWidget>
+
+class QLabel;
+class QSortFilterProxyModel;
+class QTableView;
+
+namespace Urho3D
+{
+
+class LayerStats;
+class LayerStatsModel;
+
+/// Live per-layer cost table, sortable by any column, with a particle count sparkline per layer.
+class LayerStatsWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    LayerStatsWidget(QWidget* parent = nullptr);
+    virtual ~LayerStatsWidget();
+
+    /// Set statistics source.
+    void SetLayerStats(LayerStats* layerStats);
+
+private slots:
+    void HandleSampled();
+
+private:
+    /// Statistics source.
+    LayerStats* layerStats_;
+    /// Table model.
+    LayerStatsModel* model_;
+    /// Sorting model.
+    QSortFilterProxyModel* proxyModel_;
+
+    QTableView* tableView_;
+    QLabel* statusLabel_;
+};
+
+}
@@ -0,0 +1,172 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include <vector>
+
+namespace Urho3D
+{
+
+/// Stable layer identifier issued when a layer is added. The low bits select a slot, the high bits count slot reuse
+/// so handles of removed layers never resolve to a newer layer. Zero is never issued.
+typedef unsigned LayerHandle;
+
+/// Invalid layer handle.
+static const LayerHandle INVALID_LAYER = 0;
+/// Number of handle bits used for the slot index.
+static const unsigned LAYER_SLOT_BITS = 16;
+/// Mask of the slot index bits.
+static const unsigned LAYER_SLOT_MASK = (1u << LAYER_SLOT_BITS) - 1;
+
+/// Return slot index of handle.
+inline unsigned GetLayerSlot(LayerHandle handle) { return handle & LAYER_SLOT_MASK; }
+
+/// Dense table of values addressed by LayerHandle, with constant time lookup and reuse of freed slots.
+template <class T> class LayerTable
+{
+public:
+    /// Insert value and return its new handle, or an invalid handle if all slot indices are in use.
+    LayerHandle Insert(const T& value)
+    {
+        unsigned slot;
+        if (!freeSlots_.empty())
+        {
+            slot = freeSlots_.back();
+            freeSlots_.pop_back();
+        }
+        else
+        {
+            // The slot index must fit its handle bits
+            if (slots_.size() > LAYER_SLOT_MASK)
+                return INVALID_LAYER;
+            slot = (unsigned)slots_.size();
+            slots_.push_back(Slot());
+        }
+
+        Slot& entry = slots_[slot];
+        // Skip generations that would wrap to the invalid handle
+        if (((++entry.generation_ << LAYER_SLOT_BITS) | slot) == INVALID_LAYER)
+            ++entry.generation_;
+        entry.handle_ = (entry.generation_ << LAYER_SLOT_BITS) | slot;
+        entry.value_ = value;
+        ++size_;
+        return entry.handle_;
+    }
+
+    /// Insert value at a handle issued by another table, e.g. to keep widgets beside the layers they show.
+    void InsertAt(LayerHandle handle, const T& value)
+    {
+        unsigned slot = GetLayerSlot(handle);
+        if (slot >= slots_.size())
+            slots_.resize(slot + 1);
+
+        Slot& entry = slots_[slot];
+        if (entry.handle_ == INVALID_LAYER)
+            ++size_;
+        entry.handle_ = handle;
+        entry.value_ = value;
+    }
+
+    /// Remove value. Return true if the handle was valid.
+    bool Remove(LayerHandle handle)
+    {
+        Slot* entry = Find(handle);
+        if (!entry)
+            return false;
+
+        entry->handle_ = INVALID_LAYER;
+        entry->value_ = T();
+        freeSlots_.push_back(GetLayerSlot(handle));
+        --size_;
+        return true;
+    }
+
+    /// Return value or null if the handle is not valid.
+    T* Get(LayerHandle handle)
+    {
+        Slot* entry = Find(handle);
+        return entry ? &entry->value_ : nullptr;
+    }
+
+    /// Return value or null if the handle is not valid.
+    const T* Get(LayerHandle handle) const
+    {
+        const Slot* entry = const_cast<LayerTable*>(this)->Find(handle);
+        return entry ? &entry->value_ : nullptr;
+    }
+
+    /// Return whether the handle is valid.
+    bool Contains(LayerHandle handle) const { return Get(handle) != nullptr; }
+    /// Return number of values.
+    unsigned Size() const { return size_; }
+
+    /// Call function with handle and value of every entry in slot order.
+    template <class F> void ForEach(F function)
+    {
+        for (Slot& entry: slots_)
+        {
+            if (entry.handle_ != INVALID_LAYER)
+                function(entry.handle_, entry.value_);
+        }
+    }
+
+    /// Call function with handle and value of every entry in slot order.
+    template <class F> void ForEach(F function) const
+    {
+        for (const Slot& entry: slots_)
+        {
+            if (entry.handle_ != INVALID_LAYER)
+                function(entry.handle_, entry.value_);
+        }
+    }
+
+private:
+    /// Table slot.
+    struct Slot
+    {
+        /// Handle of the current value, or invalid if free.
+        LayerHandle handle_ = INVALID_LAYER;
+        /// Times the slot has been used.
+        unsigned generation_ = 0;
+        /// Value.
+        T value_ = T();
+    };
+
+    /// Return slot of a valid handle.
+    Slot* Find(LayerHandle handle)
+    {
+        unsigned slot = GetLayerSlot(handle);
+        if (handle == INVALID_LAYER || slot >= slots_.size() || slots_[slot].handle_ != handle)
+            return nullptr;
+        return &slots_[slot];
+    }
+
+    /// Slots.
+    std::vector<Slot> slots_;
+    /// Free slot indices.
+    std::vector<unsigned> freeSlots_;
+    /// Number of values.
+    unsigned size_ = 0;
+};
+
+}
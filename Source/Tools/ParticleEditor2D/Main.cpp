@@ -21,6 +21,8 @@
 //
 
 #include <Urho3D/Engine/Application.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include "BatchTool.h"
 #include "ParticleEditor.h"
 #include <QFile>
 
@@ -29,6 +31,13 @@ int Main()
     int argc = 0;
     char** argv = 0;
     Urho3D::SharedPtr<Urho3D::Context> context(new Urho3D::Context());
+
+    const Urho3D::Vector<Urho3D::String>& arguments = Urho3D::GetArguments();
+    if (Urho3D::BatchTool::IsBatchCommand(arguments)) {
+        Urho3D::SharedPtr<Urho3D::BatchTool> tool(new Urho3D::BatchTool(context));
+        return tool->Run(arguments);
+    }
+
     Urho3D::ParticleEditor editor(argc, argv, context);
 
     QFile file(":/qdarkstyle/style.qss");
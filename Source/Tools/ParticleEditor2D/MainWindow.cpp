@@ -20,26 +20,47 @@
 // THE SOFTWARE.
 //
 
+#include "EditHistory.h"
+#include "EffectHeaderExporter.h"
+#include "EffectLibraryWidget.h"
+#include "EffectOptimizer.h"
+#include "EffectTiersWidget.h"
 #include "EmitterAttributeEditor.h"
+#include "FrameTimings.h"
+#include "LayerStatsWidget.h"
 #include "MainWindow.h"
 #include "ParticleAttributeEditor.h"
 #include "ParticleEditor.h"
+#include "ParticleRecorder.h"
+#include "RestartScheduler.h"
 #include "NodeManagerWidget.h"
-#include "NodeItemWidget.h"
 #include "PathUtils.h"
+#include "PreviewCache.h"
+#include "RenderWidget.h"
+#include "SpritePreprocessor.h"
+#include "StressGrid.h"
+#include "TraceRecorder.h"
 
 #include <Urho3D/Graphics/Camera.h>
 #include <Urho3D/Core/Context.h>
 #include <Urho3D/Graphics/Renderer.h>
 #include <Urho3D/Graphics/Zone.h>
+#include <Urho3D/IO/FileSystem.h>
 
 #include <QSettings>
 #include <QAction>
 #include <QColorDialog>
+#include <QDialog>
+#include <QDialogButtonBox>
 #include <QDockWidget>
+#include <QDoubleSpinBox>
 #include <QFileDialog>
+#include <QFormLayout>
+#include <QInputDialog>
 #include <QMenu>
 #include <QMenuBar>
+#include <QProgressDialog>
+#include <QSpinBox>
 #include <QToolBar>
 #include <QDebug>
 #include <QResizeEvent>
@@ -48,6 +69,10 @@
 namespace {
 const QString LAST_PATH("lastPath");
 const QString LAST_PS("lastPs");
+const QString DOWNSCALE_SPRITES("downscaleSprites");
+const QString PREMULTIPLY_SPRITES("premultiplySprites");
+const QString RELATIVE_BATCH_EDITS("relativeBatchEdits");
+const QString PROGRESSIVE_STARTUP("progressiveStartup");
 }
 
 namespace Urho3D
@@ -61,12 +86,9 @@ MainWindow::MainWindow(Context* context) :
 {
     setWindowIcon(QIcon(":/Images/Icon.png"));
 
-    QWidget* widget = new QWidget();
-    setCentralWidget(widget);
-    
-    widget->setFixedSize(1200, 700); // workaround, the SDL2_GetWindowSize(window, width, height) doesn't get actual window size when QWidget is actually resized
-    widget->setUpdatesEnabled(false);
-    widget->setFocusPolicy(Qt::StrongFocus);
+    // The engine follows the size of this widget, see ParticleEditor::HandleRenderResized
+    renderWidget_ = new RenderWidget();
+    setCentralWidget(renderWidget_);
 
     showMaximized();
 }
@@ -97,6 +119,10 @@ void MainWindow::CreateActions()
     openAction_->setShortcut(QKeySequence::fromString("Ctrl+O"));
     connect(openAction_, SIGNAL(triggered(bool)), this, SLOT(HandleOpenAction()));
 
+    importFolderAction_ = new QAction(tr("Import Folder ..."), this);
+    importFolderAction_->setShortcut(QKeySequence::fromString("Ctrl+Shift+O"));
+    connect(importFolderAction_, SIGNAL(triggered(bool)), this, SLOT(HandleImportFolderAction()));
+
     saveAction_= new QAction(QIcon(":/Images/Save.png"), tr("Save ..."), this);
     saveAction_->setShortcut(QKeySequence::fromString("Ctrl+S"));
     connect(saveAction_, SIGNAL(triggered(bool)), this, SLOT(HandleSaveAction()));
@@ -105,6 +131,78 @@ void MainWindow::CreateActions()
     saveAsAction_->setShortcut(QKeySequence::fromString("Ctrl+Shift+S"));
     connect(saveAsAction_, SIGNAL(triggered(bool)), this, SLOT(HandleSaveAsAction()));
 
+    // Undo restores parameters in place, emitters are not recreated
+    EditHistory* history = ParticleEditor::Get()->GetEditHistory();
+
+    undoAction_ = new QAction(tr("Undo"), this);
+    undoAction_->setShortcut(QKeySequence::Undo);
+    undoAction_->setEnabled(false);
+    connect(undoAction_, &QAction::triggered, this, [history](bool) {
+        history->Undo();
+    });
+
+    redoAction_ = new QAction(tr("Redo"), this);
+    redoAction_->setShortcut(QKeySequence::Redo);
+    redoAction_->setEnabled(false);
+    connect(redoAction_, &QAction::triggered, this, [history](bool) {
+        history->Redo();
+    });
+
+    connect(history, &EditHistory::changed, this, [this, history]() {
+        undoAction_->setEnabled(history->CanUndo());
+        redoAction_->setEnabled(history->CanRedo());
+    });
+    connect(history, &EditHistory::restored, this, [this](const QVector<unsigned>& layers) {
+        if (layers.contains(GetSelectedLayer()))
+            HandleUpdateWidget();
+    });
+
+    exportHeaderAction_ = new QAction(tr("Export C++ Header ..."), this);
+    connect(exportHeaderAction_, SIGNAL(triggered(bool)), this, SLOT(HandleExportHeaderAction()));
+
+    // Texture processing applies to effects opened from now on
+    QSettings settings;
+    SpritePreprocessor* spritePreprocessor = ParticleEditor::Get()->GetSpritePreprocessor();
+
+    downscaleSpritesAction_ = new QAction(tr("Downscale Sprites On Open"), this);
+    downscaleSpritesAction_->setCheckable(true);
+    downscaleSpritesAction_->setChecked(settings.value(DOWNSCALE_SPRITES, true).toBool());
+    spritePreprocessor->SetEnabled(downscaleSpritesAction_->isChecked());
+    connect(downscaleSpritesAction_, &QAction::toggled, this, [spritePreprocessor](bool checked) {
+        spritePreprocessor->SetEnabled(checked);
+        QSettings().setValue(DOWNSCALE_SPRITES, checked);
+    });
+
+    premultiplySpritesAction_ = new QAction(tr("Premultiply Alpha For Premulalpha Effects"), this);
+    premultiplySpritesAction_->setCheckable(true);
+    premultiplySpritesAction_->setChecked(settings.value(PREMULTIPLY_SPRITES, false).toBool());
+    spritePreprocessor->SetPremultiply(premultiplySpritesAction_->isChecked());
+    connect(premultiplySpritesAction_, &QAction::toggled, this, [spritePreprocessor](bool checked) {
+        spritePreprocessor->SetPremultiply(checked);
+        QSettings().setValue(PREMULTIPLY_SPRITES, checked);
+    });
+
+    relativeBatchEditsAction_ = new QAction(tr("Relative Multi-Layer Edits"), this);
+    relativeBatchEditsAction_->setCheckable(true);
+    relativeBatchEditsAction_->setChecked(settings.value(RELATIVE_BATCH_EDITS, false).toBool());
+    ParticleEditor::Get()->SetRelativeBatchEdits(relativeBatchEditsAction_->isChecked());
+    connect(relativeBatchEditsAction_, &QAction::toggled, this, [](bool checked) {
+        ParticleEditor::Get()->SetRelativeBatchEdits(checked);
+        QSettings().setValue(RELATIVE_BATCH_EDITS, checked);
+    });
+
+    progressiveStartupAction_ = new QAction(tr("Open Workspace Layers After Showing Window"), this);
+    progressiveStartupAction_->setCheckable(true);
+    progressiveStartupAction_->setChecked(settings.value(PROGRESSIVE_STARTUP, true).toBool());
+    ParticleEditor::Get()->SetProgressiveStartup(progressiveStartupAction_->isChecked());
+    connect(progressiveStartupAction_, &QAction::toggled, this, [](bool checked) {
+        ParticleEditor::Get()->SetProgressiveStartup(checked);
+        QSettings().setValue(PROGRESSIVE_STARTUP, checked);
+    });
+
+    optimizeAction_ = new QAction(tr("Optimize Effect ..."), this);
+    connect(optimizeAction_, SIGNAL(triggered(bool)), this, SLOT(HandleOptimizeAction()));
+
     exitAction_ = new QAction(tr("Exit"), this);
     exitAction_->setShortcut(QKeySequence::fromString("Alt+F4"));
     connect(exitAction_, &QAction::triggered, this, [this](bool){
@@ -128,10 +226,22 @@ void MainWindow::CreateActions()
     backgroundAction_ = new QAction(tr("Background"), this);
     backgroundAction_->setShortcut(QKeySequence::fromString("Ctrl+B"));
     connect(backgroundAction_, SIGNAL(triggered(bool)), this, SLOT(HandleBackgroundAction()));
+
+    frameTimingsAction_ = new QAction(tr("Frame Timings"), this);
+    connect(frameTimingsAction_, SIGNAL(triggered(bool)), this, SLOT(HandleFrameTimingsAction()));
+
+    saveTraceAction_ = new QAction(tr("Save Trace ..."), this);
+    saveTraceAction_->setShortcut(QKeySequence::fromString("Ctrl+Shift+T"));
+    connect(saveTraceAction_, SIGNAL(triggered(bool)), this, SLOT(HandleSaveTraceAction()));
+
+    recordAction_ = new QAction(tr("Record Simulation ..."), this);
+    recordAction_->setCheckable(true);
+    recordAction_->setShortcut(QKeySequence::fromString("Ctrl+Shift+R"));
+    connect(recordAction_, SIGNAL(toggled(bool)), this, SLOT(HandleRecordAction(bool)));
 }
 
 bool MainWindow::CheckClosePermition() const {
-    if (nodeManagerWidget_->hasUnsaved()) {
+    if (ParticleEditor::Get()->HasUnsaved()) {
         if (QMessageBox::Ok != showQuestionMessageBox("There are some unsaved configurations. Still want to exit and lost data?")) {
             return false;
         }
@@ -164,13 +274,31 @@ void MainWindow::CreateMenuBar()
 
     fileMenu_->addAction(newAction_);
     fileMenu_->addAction(openAction_);
+    fileMenu_->addAction(importFolderAction_);
     fileMenu_->addAction(saveAction_);
     fileMenu_->addAction(saveAsAction_);
+    fileMenu_->addAction(exportHeaderAction_);
+
+    fileMenu_->addSeparator();
+
+    fileMenu_->addAction(downscaleSpritesAction_);
+    fileMenu_->addAction(premultiplySpritesAction_);
 
     fileMenu_->addSeparator();
     
     fileMenu_->addAction(exitAction_);
 
+    editMenu_ = menuBar()->addMenu(tr("&Edit"));
+
+    editMenu_->addAction(undoAction_);
+    editMenu_->addAction(redoAction_);
+
+    editMenu_->addSeparator();
+
+    editMenu_->addAction(relativeBatchEditsAction_);
+    editMenu_->addSeparator();
+    editMenu_->addAction(optimizeAction_);
+
     viewMenu_ = menuBar()->addMenu(tr("&View"));
 
     viewMenu_->addAction(zoomInAction_);
@@ -180,6 +308,10 @@ void MainWindow::CreateMenuBar()
     viewMenu_->addSeparator();
 
     viewMenu_->addAction(backgroundAction_);
+    viewMenu_->addAction(frameTimingsAction_);
+    viewMenu_->addAction(saveTraceAction_);
+    viewMenu_->addAction(recordAction_);
+    viewMenu_->addAction(progressiveStartupAction_);
 }
 
 void MainWindow::CreateToolBar()
@@ -200,57 +332,85 @@ void MainWindow::CreateToolBar()
 
 void MainWindow::CreateDockWidgets()
 {
+    previewCache_ = new PreviewCache(this);
+
     nodeManagerWidget_ = new NodeManagerWidget(this);
+    nodeManagerWidget_->setPreviewCache(previewCache_);
     QDockWidget* topDockWidget = new QDockWidget(tr("Layers"));
     addDockWidget(Qt::TopDockWidgetArea, topDockWidget);
     topDockWidget->setWidget(nodeManagerWidget_);
 
-    connect(ParticleEditor::Get(), &ParticleEditor::NewParticleNodeAdded, this, [this](QString key) {
-        NodeItemWidget* nodeItemWIdget = new NodeItemWidget(nodeManagerWidget_, key);
-        nodeManagerWidget_->add(nodeItemWIdget);
+    connect(ParticleEditor::Get(), &ParticleEditor::NewParticleNodeAdded, this, [this](unsigned layer) {
+        nodeManagerWidget_->add(layer, ParticleEditor::Get()->GetFileName(layer).CString());
+    });
+
+    connect(ParticleEditor::Get(), &ParticleEditor::LayerRestored, this, [this](unsigned layer) {
+        SyncLayerRow(layer);
+    });
+
+    connect(ParticleEditor::Get(), &ParticleEditor::SharedResourcesChanged, this, [this]() {
+        nodeManagerWidget_->setSharedMemory(ParticleEditor::Get()->GetSharedMemorySavings());
     });
 
-    connect(nodeManagerWidget_, &NodeManagerWidget::visibleChanged, this, [this](const QString& key, bool visible) {
-        assert(ParticleEditor::Get()->SetVisible(String(key.toStdString().c_str()), visible));
+    connect(nodeManagerWidget_, &NodeManagerWidget::visibleChanged, this, [this](unsigned layer, bool visible) {
+        assert(ParticleEditor::Get()->SetVisible(layer, visible));
     });
-    connect(nodeManagerWidget_, &NodeManagerWidget::deleteRequested, this, [this](QString key) {
-        assert(ParticleEditor::Get()->RemoveParticleNode(String(key.toStdString().c_str())));
-        SaveOpenedPS();
+    connect(nodeManagerWidget_, &NodeManagerWidget::deleteRequested, this, [this](unsigned layer) {
+        assert(ParticleEditor::Get()->RemoveParticleNode(layer));
     });
-    connect(nodeManagerWidget_, &NodeManagerWidget::nodePositionChanged, this, [this](const QString& key, int x, int y) {
-        assert(ParticleEditor::Get()->SetParticleNodePosition(String(key.toStdString().c_str()), x, y));
+    connect(nodeManagerWidget_, &NodeManagerWidget::nodePositionChanged, this, [this](unsigned layer, int x, int y) {
+        assert(ParticleEditor::Get()->SetParticleNodePosition(layer, x, y));
     });
-    connect(nodeManagerWidget_, &NodeManagerWidget::acceptKeyChangeRequest, this, [this](QString key, QString newKey) {
-        assert(ParticleEditor::Get()->changeKey(String(key.toStdString().c_str()), String(newKey.toStdString().c_str())));
+    connect(nodeManagerWidget_, &NodeManagerWidget::cloneRequested, this, [this](unsigned layer) {
+        ParticleEditor* editor = ParticleEditor::Get();
+        LayerHandle clone = editor->CloneLayer(layer);
+        if (clone != INVALID_LAYER)
+            SyncLayerRow(clone);
+    });
+    connect(nodeManagerWidget_, &NodeManagerWidget::stressRequested, this, [this]() {
+        StartStressGrid();
+    });
+    connect(nodeManagerWidget_, &NodeManagerWidget::renameAccepted, this, [this](unsigned layer, QString fileName) {
+        ParticleEditor* editor = ParticleEditor::Get();
+        if (!editor->Rename(layer, String(fileName.toStdString().c_str()))) {
+            showInfoMessageBox(QString("Fail to rename %1 to %2").arg(editor->GetFileName(layer).CString()).arg(fileName));
+            nodeManagerWidget_->rename(layer, QString(editor->GetFileName(layer).CString()));
+        }
     });
-    connect(nodeManagerWidget_, &NodeManagerWidget::selected, this, [this](QString key) {
-        String key_(key.toStdString().c_str());
-        assert(ParticleEditor::Get()->select(key_));
-        SetSelectedKey(key_);
+    connect(nodeManagerWidget_, &NodeManagerWidget::selected, this, [this](unsigned layer) {
+        assert(ParticleEditor::Get()->select(layer));
+        SetSelectedLayer(layer);
         HandleUpdateWidget();
     });
-    connect(nodeManagerWidget_, &NodeManagerWidget::saveAllRequested, this, [this]() {
-        QList<QString> keys = nodeManagerWidget_->getDirtyKeys();
-        for (QString key: keys) {
-            if (ParticleEditor::Get()->Save(String(key.toStdString().c_str()))) {
-                nodeManagerWidget_->unmarkDirty(key);
-            }
+    connect(nodeManagerWidget_, &NodeManagerWidget::selectionChanged, this, [this](const QVector<unsigned>& layers) {
+        PODVector<LayerHandle> selection;
+        for (unsigned layer: layers) {
+            selection.Push(layer);
         }
+        ParticleEditor::Get()->SetSelectedLayers(selection);
     });
-    connect(nodeManagerWidget_, &NodeManagerWidget::saveRequested, this, [this](const QString& key) {
-        if (ParticleEditor::Get()->Save(String(key.toStdString().c_str()))) {
-            nodeManagerWidget_->unmarkDirty(key);
+    connect(nodeManagerWidget_, &NodeManagerWidget::saveAllRequested, this, [this]() {
+        QList<LayerHandle> layers = ParticleEditor::Get()->GetDirtyLayers();
+        for (LayerHandle layer: layers) {
+            SaveLayer(layer);
         }
     });
-    connect(nodeManagerWidget_, &NodeManagerWidget::restartEmiterRequest, this, [this](const QString& key) {
-        assert(ParticleEditor::Get()->restartEmiter(String(key.toStdString().c_str())));
+    connect(nodeManagerWidget_, &NodeManagerWidget::saveRequested, this, [this](unsigned layer) {
+        SaveLayer(layer);
+    });
+    connect(nodeManagerWidget_, &NodeManagerWidget::restartPeriodChanged, this, [this](unsigned layer, int periodMs) {
+        ParticleEditor::Get()->SetRestartPeriod(layer, periodMs > 0 ? periodMs : 0);
+    });
+    connect(nodeManagerWidget_, &NodeManagerWidget::alignRestartsRequested, this, [this]() {
+        ParticleEditor::Get()->GetRestartScheduler()->AlignPhases();
     });
 
-    emitterAttributeEditor_ = new EmitterAttributeEditor(context_);
-    connect(emitterAttributeEditor_, &EmitterAttributeEditor::changed, this, [this](QString key) {
-        nodeManagerWidget_->markDirty(key);
+    connect(ParticleEditor::Get(), &ParticleEditor::DirtyChanged, this, [this](unsigned layer, bool dirty) {
+        nodeManagerWidget_->setDirty(layer, dirty);
     });
 
+    emitterAttributeEditor_ = new EmitterAttributeEditor(context_);
+
     QDockWidget* eaDockWidget = new QDockWidget(tr("Emitter Attributes"));
     addDockWidget(Qt::LeftDockWidgetArea, eaDockWidget);
     eaDockWidget->setWidget(emitterAttributeEditor_);
@@ -262,9 +422,6 @@ void MainWindow::CreateDockWidgets()
     eaToggleViewAction->setShortcut(QKeySequence::fromString("Ctrl+E"));
 
     particleAttributeEditor_ = new ParticleAttributeEditor(context_);
-    connect(particleAttributeEditor_, &ParticleAttributeEditor::changed, this, [this](QString key) {
-        nodeManagerWidget_->markDirty(key);
-    });
 
     QDockWidget* paDockWidget = new QDockWidget(tr("Particle Attributes"));
     addDockWidget(Qt::RightDockWidgetArea, paDockWidget);
@@ -273,15 +430,80 @@ void MainWindow::CreateDockWidgets()
     QAction* paToggleViewAction = paDockWidget->toggleViewAction();
     viewMenu_->addAction(paToggleViewAction);
     paToggleViewAction->setShortcut(QKeySequence::fromString("Ctrl+P"));
+
+    effectLibraryWidget_ = new EffectLibraryWidget();
+    effectLibraryWidget_->SetPreviewCache(previewCache_);
+    connect(effectLibraryWidget_, &EffectLibraryWidget::openRequested, this, [](const QString& filepath) {
+        ParticleEditor::Get()->Open(filepath);
+    });
+
+    QDockWidget* libraryDockWidget = new QDockWidget(tr("Library"));
+    addDockWidget(Qt::RightDockWidgetArea, libraryDockWidget);
+    libraryDockWidget->setWidget(effectLibraryWidget_);
+    tabifyDockWidget(paDockWidget, libraryDockWidget);
+    paDockWidget->raise();
+
+    QAction* libraryToggleViewAction = libraryDockWidget->toggleViewAction();
+    viewMenu_->addAction(libraryToggleViewAction);
+    libraryToggleViewAction->setShortcut(QKeySequence::fromString("Ctrl+L"));
+
+    effectLibraryWidget_->Refresh();
+
+    LayerStatsWidget* layerStatsWidget = new LayerStatsWidget();
+    layerStatsWidget->SetLayerStats(ParticleEditor::Get()->GetLayerStats());
+
+    QDockWidget* statsDockWidget = new QDockWidget(tr("Layer Performance"));
+    addDockWidget(Qt::BottomDockWidgetArea, statsDockWidget);
+    statsDockWidget->setWidget(layerStatsWidget);
+
+    QAction* statsToggleViewAction = statsDockWidget->toggleViewAction();
+    viewMenu_->addAction(statsToggleViewAction);
+    statsToggleViewAction->setShortcut(QKeySequence::fromString("Ctrl+Shift+P"));
+
+    EffectTiersWidget* effectTiersWidget = new EffectTiersWidget();
+    connect(effectTiersWidget, &EffectTiersWidget::layerCreated, this, [this](unsigned layer) {
+        SyncLayerRow(layer);
+    });
+    connect(effectTiersWidget, &EffectTiersWidget::saveRequested, this, [this](unsigned layer) {
+        SaveLayer(layer);
+    });
+
+    QDockWidget* tiersDockWidget = new QDockWidget(tr("Quality Tiers"));
+    addDockWidget(Qt::BottomDockWidgetArea, tiersDockWidget);
+    tiersDockWidget->setWidget(effectTiersWidget);
+    tabifyDockWidget(statsDockWidget, tiersDockWidget);
+    statsDockWidget->raise();
+
+    QAction* tiersToggleViewAction = tiersDockWidget->toggleViewAction();
+    viewMenu_->addAction(tiersToggleViewAction);
+    tiersToggleViewAction->setShortcut(QKeySequence::fromString("Ctrl+Shift+Q"));
 }
 
-void MainWindow::SetSelectedKey(String key)
+void MainWindow::SetSelectedLayer(LayerHandle layer)
 {
-    ParticleEffectEditor::SetSelectedKey(key);
+    ParticleEffectEditor::SetSelectedLayer(layer);
     if (emitterAttributeEditor_)
-        emitterAttributeEditor_->SetSelectedKey(key);
+        emitterAttributeEditor_->SetSelectedLayer(layer);
     if (particleAttributeEditor_)
-        particleAttributeEditor_->SetSelectedKey(key);
+        particleAttributeEditor_->SetSelectedLayer(layer);
+}
+
+void MainWindow::SyncLayerRow(LayerHandle layer)
+{
+    ParticleEditor* editor = ParticleEditor::Get();
+    Vector2 position = editor->GetParticleNodePosition(layer);
+    nodeManagerWidget_->setLayerState(layer, editor->IsVisible(layer),
+        editor->GetRestartScheduler()->GetPeriod(layer), (int)position.x_, (int)position.y_);
+}
+
+void MainWindow::SaveLayer(LayerHandle layer)
+{
+    if (!ParticleEditor::Get()->Save(layer))
+        return;
+
+    QString fileName(ParticleEditor::Get()->GetFileName(layer).CString());
+    previewCache_->Invalidate(fileName);
+    previewCache_->Request(fileName);
 }
 
 void MainWindow::HandleNewAction()
@@ -304,39 +526,121 @@ void MainWindow::HandleOpenAction()
     path = QFileInfo(filepath).absolutePath();
     settings.setValue(LAST_PATH, path);
 
-    bool result = ParticleEditor::Get()->Open(filepath.toLatin1().data());
-    if (result) {
-        SaveOpenedPS();
-    }
+    ParticleEditor::Get()->Open(filepath.toLatin1().data());
 }
 
-void MainWindow::SaveOpenedPS() const
+void MainWindow::HandleImportFolderAction()
 {
     QSettings settings;
-    QList<QString> keys = ParticleEditor::Get()->GetKeys();
-    QString data = keys.join(";");
-    settings.setValue(LAST_PS, data);
+    QString path = settings.value(LAST_PATH, "").toString();
+    if (!QFileInfo(path).exists()) {
+        path = QApplication::applicationDirPath() +"/Data/Urho2D";
+    }
+
+    path = QFileDialog::getExistingDirectory(0, tr("Import folder"), path);
+    if (path.isEmpty())
+        return;
+
+    settings.setValue(LAST_PATH, path);
+
+    ParticleEditor::Get()->ImportFolder(path);
+}
+
+void MainWindow::HandleOptimizeAction()
+{
+    ParticleEditor* editor = ParticleEditor::Get();
+    LayerHandle layer = editor->GetSelectedLayer();
+    if (layer == INVALID_LAYER)
+        return;
+
+    bool ok = false;
+    EffectOptimizerSettings settings;
+    double threshold = QInputDialog::getDouble(this, tr("Optimize Effect"), tr("Allowed look difference (%)"),
+        settings.threshold_ * 100.0, 0.1, 20.0, 1, &ok);
+    if (!ok)
+        return;
+    settings.threshold_ = (float)threshold / 100.0f;
+
+    // Include edits made since the last frame
+    editor->GetEditQueue()->Flush();
+    EffectParams params;
+    ReadEffectParams(editor->GetEffect(layer), params);
+
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    EffectOptimizer optimizer(params, LoadEffectSprite(editor->GetFileName(layer), params), settings);
+    EffectOptimizerResult result = optimizer.Optimize();
+    QApplication::restoreOverrideCursor();
+
+    if (!result.IsImproved()) {
+        showInfoMessageBox(tr("No cheaper parameters stay within the allowed difference."));
+        return;
+    }
+
+    String summary = EffectOptimizer::GetSummary(params, result);
+    if (showQuestionMessageBox(QString("%1\n\nApply?").arg(summary.CString())) != QMessageBox::Ok)
+        return;
+
+    // Queued like any other edit, so one undo restores the original
+    for (EffectParam param: EffectOptimizer::GetChangedParams(params, result.params_))
+        editor->GetEditQueue()->Set(layer, param, result.params_.Get(param));
+    editor->GetEditQueue()->Flush();
+    UpdateWidget();
+}
+
+void MainWindow::HandleExportHeaderAction()
+{
+    QList<LayerHandle> layers = ParticleEditor::Get()->GetLayers();
+    if (layers.isEmpty())
+        return;
+
+    QString fileName = QFileDialog::getSaveFileName(0, tr("Export C++ header"), "./", "*.h");
+    if (fileName.isEmpty())
+        return;
+
+    SharedPtr<EffectHeaderExporter> exporter(new EffectHeaderExporter(context_));
+    for (LayerHandle layer: layers) {
+        EffectParams params;
+        ReadEffectParams(ParticleEditor::Get()->GetEffect(layer), params);
+        String layerFileName = ParticleEditor::Get()->GetFileName(layer);
+        if (!exporter->AddEffect(GetFileName(layerFileName), GetFileNameAndExtension(layerFileName), params)) {
+            showInfoMessageBox(QString("%1 has an infinite or NaN parameter and cannot be exported").arg(layerFileName.CString()));
+            return;
+        }
+    }
+
+    String report;
+    if (!exporter->Verify(report)) {
+        showInfoMessageBox(QString("Exported values do not round-trip:\n%1").arg(report.CString()));
+        return;
+    }
+    if (!exporter->Save(fileName.toStdString().c_str(), "Effects"))
+        showInfoMessageBox(QString("Fail to write %1").arg(fileName));
 }
 
 void MainWindow::OpenPrevioslyOpenedPS() const
 {
-    QSettings settings;
-    QString data = settings.value(LAST_PS, "").toString();
-    QList<QString> keys = data.split(";");
-    for (QString key: keys) {
-        if (QFileInfo(key).exists()) {
-            ParticleEditor::Get()->Open(key);
+    ParticleEditor* editor = ParticleEditor::Get();
+    if (!editor->OpenWorkspace()) {
+        // Sessions before the workspace file only kept the file list, open it once and forget it
+        QSettings settings;
+        QString data = settings.value(LAST_PS, "").toString();
+        QList<QString> keys = data.split(";");
+        for (QString key: keys) {
+            if (QFileInfo(key).exists()) {
+                editor->Open(key);
+            }
         }
+        settings.remove(LAST_PS);
     }
 }
 
 void MainWindow::HandleSaveAction()
 {
-    const String& fileName = ParticleEditor::Get()->GetFileName();
-    if (fileName.Empty())
+    LayerHandle layer = ParticleEditor::Get()->GetSelectedLayer();
+    if (layer == INVALID_LAYER)
         HandleSaveAsAction();
     else
-        ParticleEditor::Get()->Save(fileName);
+        SaveLayer(layer);
 }
 
 void MainWindow::HandleSaveAsAction()
@@ -345,7 +649,7 @@ void MainWindow::HandleSaveAsAction()
     if (fileName.isEmpty())
         return;
 
-    ParticleEditor::Get()->Save(fileName.toLatin1().data());
+    ParticleEditor::Get()->Save(ParticleEditor::Get()->GetSelectedLayer(), fileName.toLatin1().data());
 }
 
 void MainWindow::HandleZoomAction()
@@ -354,11 +658,11 @@ void MainWindow::HandleZoomAction()
     
     QObject* s = sender();
     if (s == zoomInAction_)
-        camera->SetZoom(camera->GetZoom() * 1.25f);
+        ParticleEditor::Get()->SetZoom(camera->GetZoom() * 1.25f);
     else if (s == zoomOutAction_)
-        camera->SetZoom(camera->GetZoom() * 0.80f);
+        ParticleEditor::Get()->SetZoom(camera->GetZoom() * 0.80f);
     else if (s == zoomResetAction_)
-        camera->SetZoom(1.0f);
+        ParticleEditor::Get()->SetZoom(1.0f);
 }
 
 void MainWindow::HandleBackgroundAction()
@@ -368,9 +672,217 @@ void MainWindow::HandleBackgroundAction()
     
     QColor qColor = QColor::fromRgbF(color.r_, color.g_, color.b_);
     QColor newQcolor = QColorDialog::getColor(qColor, this);
+    if (!newQcolor.isValid())
+        return;
     
     Color newColor(newQcolor.redF(), newQcolor.greenF(), newQcolor.blueF());
-    renderer->GetDefaultZone()->SetFogColor(newColor);
+    ParticleEditor::Get()->SetBackgroundColor(newColor);
+}
+
+void MainWindow::HandleFrameTimingsAction()
+{
+    String report = ParticleEditor::Get()->GetFrameTimings().GetReport();
+    showInfoMessageBox(report.Empty() ? tr("No frames rendered yet.") : QString(report.CString()));
+}
+
+void MainWindow::HandleSaveTraceAction()
+{
+    // Take the frames before the dialogs opened
+    const long long end = TraceRecorder::Get().Now();
+    bool ok = false;
+    int seconds = QInputDialog::getInt(this, tr("Save Trace"), tr("Last seconds"), 10, 1, 600, 1, &ok);
+    if (!ok)
+        return;
+
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Save Trace"), "trace.json", tr("Chrome trace (*.json)"));
+    if (fileName.isEmpty())
+        return;
+
+    if (!TraceRecorder::Get().WriteChromeTrace(fileName.toStdString().c_str(), (float)seconds, end))
+        showInfoMessageBox(QString("Fail to write %1").arg(fileName));
+}
+
+/// Set action state without triggering its handler.
+static void SetCheckedSilently(QAction* action, bool checked)
+{
+    const bool blocked = action->blockSignals(true);
+    action->setChecked(checked);
+    action->blockSignals(blocked);
+}
+
+void MainWindow::HandleRecordAction(bool checked)
+{
+    ParticleRecorder* recorder = ParticleEditor::Get()->GetParticleRecorder();
+    if (!checked) {
+        recorder->Stop();
+        return;
+    }
+
+    // Unchecked again by HandleRecordingStopped, or right here if recording does not start
+    SetCheckedSilently(recordAction_, false);
+
+    LayerHandle layer = ParticleEditor::Get()->GetSelectedLayer();
+    if (recorder->IsRecording())
+        return;
+    if (!ParticleEditor::Get()->GetEffect(layer)) {
+        showInfoMessageBox(tr("Select the layer whose simulation should be recorded."));
+        return;
+    }
+
+    QDialog dialog(this);
+    dialog.setWindowTitle(tr("Record Simulation"));
+    QFormLayout* form = new QFormLayout(&dialog);
+
+    ParticleStreamSettings settings;
+    QSpinBox* frameStride = new QSpinBox(&dialog);
+    frameStride->setRange(1, 1000);
+    frameStride->setValue(settings.frameStride_);
+    form->addRow(tr("Write every Nth frame"), frameStride);
+    QSpinBox* particleStride = new QSpinBox(&dialog);
+    particleStride->setRange(1, 1000);
+    particleStride->setValue(settings.particleStride_);
+    form->addRow(tr("Write every Nth particle"), particleStride);
+
+    QDialogButtonBox* buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, &dialog);
+    connect(buttons, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+    connect(buttons, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+    form->addRow(buttons);
+    if (dialog.exec() != QDialog::Accepted)
+        return;
+
+    settings.frameStride_ = frameStride->value();
+    settings.particleStride_ = particleStride->value();
+
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Record Simulation"), "recording.pstream",
+        tr("Particle stream (*.pstream)"));
+    if (fileName.isEmpty())
+        return;
+
+    if (!recorder->Start(layer, String(fileName.toStdString().c_str()), settings)) {
+        showInfoMessageBox(QString("Fail to create %1").arg(fileName));
+        return;
+    }
+
+    connect(recorder, &ParticleRecorder::stopped, this, &MainWindow::HandleRecordingStopped, Qt::UniqueConnection);
+    SetCheckedSilently(recordAction_, true);
+}
+
+void MainWindow::HandleRecordingStopped(bool success)
+{
+    SetCheckedSilently(recordAction_, false);
+
+    ParticleRecorder* recorder = ParticleEditor::Get()->GetParticleRecorder();
+    const QString fileName(recorder->GetFileName().CString());
+    if (!success) {
+        showInfoMessageBox(QString("Fail to write %1").arg(fileName));
+        return;
+    }
+    QString message = tr("Recorded %1 frames, %2 MB to %3").arg(recorder->GetNumFrames())
+        .arg(recorder->GetSize() / (1024.0 * 1024.0), 0, 'f', 1).arg(fileName);
+    if (recorder->GetNumDroppedFrames())
+        message += tr("\n%1 frames were merged into the next one because writing fell behind").arg(recorder->GetNumDroppedFrames());
+    showInfoMessageBox(message);
+}
+
+void MainWindow::StartStressGrid()
+{
+    ParticleEditor* editor = ParticleEditor::Get();
+    StressGrid* stressGrid = editor->GetStressGrid();
+    ParticleEffect2D* effect = editor->GetEffect(editor->GetSelectedLayer());
+    if (stressGrid->IsRunning())
+        return;
+    if (!effect) {
+        showInfoMessageBox(tr("Select the layer whose effect should be measured."));
+        return;
+    }
+
+    QDialog dialog(this);
+    dialog.setWindowTitle(tr("Stress Grid"));
+    QFormLayout* form = new QFormLayout(&dialog);
+
+    StressGridSettings settings = stressGrid->GetSettings();
+    QSpinBox* columns = new QSpinBox(&dialog);
+    columns->setRange(1, 4096);
+    columns->setValue(settings.columns_);
+    form->addRow(tr("Columns"), columns);
+    QSpinBox* rows = new QSpinBox(&dialog);
+    rows->setRange(1, 4096);
+    rows->setValue(settings.rows_);
+    form->addRow(tr("Rows"), rows);
+    QDoubleSpinBox* spacing = new QDoubleSpinBox(&dialog);
+    spacing->setRange(0.0, 100.0);
+    spacing->setValue(settings.spacing_);
+    form->addRow(tr("Spacing"), spacing);
+    QSpinBox* steps = new QSpinBox(&dialog);
+    steps->setRange(1, 100);
+    steps->setValue(settings.steps_);
+    form->addRow(tr("Instance counts"), steps);
+    QSpinBox* warmupFrames = new QSpinBox(&dialog);
+    warmupFrames->setRange(0, 10000);
+    warmupFrames->setValue(settings.warmupFrames_);
+    form->addRow(tr("Warmup frames"), warmupFrames);
+    QSpinBox* measureFrames = new QSpinBox(&dialog);
+    measureFrames->setRange(1, 10000);
+    measureFrames->setValue(settings.measureFrames_);
+    form->addRow(tr("Measured frames"), measureFrames);
+
+    QDialogButtonBox* buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, &dialog);
+    connect(buttons, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+    connect(buttons, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+    form->addRow(buttons);
+    if (dialog.exec() != QDialog::Accepted)
+        return;
+
+    settings.columns_ = columns->value();
+    settings.rows_ = rows->value();
+    settings.spacing_ = (float)spacing->value();
+    settings.steps_ = steps->value();
+    settings.warmupFrames_ = warmupFrames->value();
+    settings.measureFrames_ = measureFrames->value();
+    if (!stressGrid->Start(effect, settings))
+        return;
+
+    // Frames keep running behind the progress dialog, so it must not block
+    stressProgress_ = new QProgressDialog(tr("Measuring instance counts ..."), tr("Stop"), 0,
+        stressGrid->GetSteps().Size(), this);
+    stressProgress_->setAttribute(Qt::WA_DeleteOnClose);
+    stressProgress_->setMinimumDuration(0);
+    stressProgress_->setAutoReset(false);
+    stressProgress_->setAutoClose(false);
+    stressProgress_->setValue(0);
+    connect(stressProgress_, &QProgressDialog::canceled, stressGrid, &StressGrid::Stop);
+    connect(stressGrid, &StressGrid::sampled, stressProgress_, [this, stressGrid]() {
+        const StressSample& sample = stressGrid->GetSamples().Back();
+        stressProgress_->setValue(stressGrid->GetSamples().Size());
+        stressProgress_->setLabelText(tr("%1 instances: %2 ms per frame, %3 batches").arg(sample.instances_)
+            .arg(sample.avgFrameMSec_, 0, 'f', 2).arg(sample.batches_, 0, 'f', 0));
+    });
+    connect(stressGrid, &StressGrid::finished, stressProgress_, [this, stressGrid]() {
+        disconnect(stressGrid, nullptr, stressProgress_, nullptr);
+        stressProgress_->close();
+        stressProgress_ = nullptr;
+        SaveStressGrid();
+    });
+    stressProgress_->show();
+}
+
+void MainWindow::SaveStressGrid()
+{
+    StressGrid* stressGrid = ParticleEditor::Get()->GetStressGrid();
+    if (stressGrid->GetSamples().Empty())
+        return;
+
+    QString selectedFilter;
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Save Stress Grid Results"), "stress.csv",
+        tr("CSV (*.csv);;JSON (*.json)"), &selectedFilter);
+    if (fileName.isEmpty())
+        return;
+
+    const bool json = fileName.endsWith(".json", Qt::CaseInsensitive) ||
+        (!fileName.endsWith(".csv", Qt::CaseInsensitive) && selectedFilter.contains("json"));
+    const String path(fileName.toStdString().c_str());
+    if (!(json ? stressGrid->SaveJson(path) : stressGrid->SaveCsv(path)))
+        showInfoMessageBox(QString("Fail to write %1").arg(fileName));
 }
 
 int showInfoMessageBox(const QString& msg)
@@ -31,13 +31,18 @@
 class QAction;
 class QActionGroup;
 class QMenu;
+class QProgressDialog;
 
 namespace Urho3D
 {
 
+class EffectLibraryWidget;
+class EffectTiersWidget;
 class EmitterAttributeEditor;
 class ParticleAttributeEditor;
 class NodeManagerWidget;
+class PreviewCache;
+class RenderWidget;
 class ScrollAreaWidget;
 
 /// Editor main window class.
@@ -53,6 +58,8 @@ public:
     /// Create widgets.
     void CreateWidgets();
     void OpenPrevioslyOpenedPS() const;
+    /// Return surface the engine renders into.
+    RenderWidget* GetRenderWidget() const { return renderWidget_; }
 
 private:
     /// Handle update widget.
@@ -67,13 +74,27 @@ private:
     /// Create dock widgets.
     void CreateDockWidgets();
     /// change active particle emmiter
-    void SetSelectedKey(String key);
+    void SetSelectedLayer(LayerHandle layer);
+    /// Save layer to its file and refresh its preview.
+    void SaveLayer(LayerHandle layer);
+    /// Show visibility, restart period and position of layer in its row.
+    void SyncLayerRow(LayerHandle layer);
+    /// Ask for stress grid settings and start measuring the selected effect.
+    void StartStressGrid();
+    /// Offer to export stress grid measurements.
+    void SaveStressGrid();
 
 private slots:
     /// Handle new action.
     void HandleNewAction();
     /// Handle open action.
     void HandleOpenAction();
+    /// Handle import folder action.
+    void HandleImportFolderAction();
+    /// Handle export header action.
+    void HandleExportHeaderAction();
+    /// Handle optimize effect action.
+    void HandleOptimizeAction();
     /// Handle save action.
     void HandleSaveAction();
     /// Handle save as action.
@@ -82,12 +103,38 @@ private slots:
     void HandleZoomAction();
     /// Handle background action.
     void HandleBackgroundAction();
+    /// Handle frame timings action.
+    void HandleFrameTimingsAction();
+    /// Handle save trace action.
+    void HandleSaveTraceAction();
+    /// Handle record simulation action.
+    void HandleRecordAction(bool checked);
+    /// Handle end of a simulation recording.
+    void HandleRecordingStopped(bool success);
 
 private:
     /// New action.
     QAction* newAction_;
     /// Open action.
     QAction* openAction_;
+    /// Import folder action.
+    QAction* importFolderAction_;
+    /// Export C++ header action.
+    QAction* exportHeaderAction_;
+    /// Downscale sprites on import action.
+    QAction* downscaleSpritesAction_;
+    /// Premultiply sprites on import action.
+    QAction* premultiplySpritesAction_;
+    /// Relative edits of several selected layers action.
+    QAction* relativeBatchEditsAction_;
+    /// Optimize effect action.
+    QAction* optimizeAction_;
+    /// Progressive startup action.
+    QAction* progressiveStartupAction_;
+    /// Undo action.
+    QAction* undoAction_;
+    /// Redo action.
+    QAction* redoAction_;
     /// Save action.
     QAction* saveAction_;
     /// Save action.
@@ -102,20 +149,33 @@ private:
     QAction* zoomResetAction_;
     /// Background action;
     QAction* backgroundAction_;
+    /// Frame timings action.
+    QAction* frameTimingsAction_;
+    /// Save trace action.
+    QAction* saveTraceAction_;
+    /// Record simulation action.
+    QAction* recordAction_;
     /// File menu.
     QMenu* fileMenu_;
+    /// Edit menu.
+    QMenu* editMenu_;
     /// View menu.
     QMenu* viewMenu_;
     /// Tool bar.
     QToolBar* toolBar_;
+    /// Engine render surface.
+    RenderWidget* renderWidget_;
     /// Inspector window.
     EmitterAttributeEditor* emitterAttributeEditor_;
     /// Inspector window.
     ParticleAttributeEditor* particleAttributeEditor_;
-
-    void SaveOpenedPS() const;
+    /// Effect library window.
+    EffectLibraryWidget* effectLibraryWidget_ = nullptr;
+    /// Stress grid progress, shown while it runs.
+    QProgressDialog* stressProgress_ = nullptr;
 
     NodeManagerWidget* nodeManagerWidget_ = nullptr;
+    PreviewCache* previewCache_ = nullptr;
 
     bool CheckClosePermition() const;
 
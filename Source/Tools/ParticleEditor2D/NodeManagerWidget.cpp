@@ -21,22 +21,394 @@
 //
 
 #include "NodeManagerWidget.h"
-#include "NodeItemWidget.h"
+#include "PreviewCache.h"
 
+#include <QAbstractListModel>
+#include <QApplication>
 #include <QHBoxLayout>
-#include <QSpacerItem>
+#include <QIntValidator>
+#include <QItemSelectionModel>
+#include <QLabel>
+#include <QLineEdit>
+#include <QListView>
+#include <QMouseEvent>
+#include <QPainter>
 #include <QPushButton>
+#include <QScrollBar>
+#include <QSpacerItem>
+#include <QStyledItemDelegate>
+#include <QTimer>
 #include <QDebug>
 
+#include <vector>
+
+namespace {
+const int DELAY_MS = 2000;
+const int ITEM_WIDTH = 300;
+const int LINE_HEIGHT = 22;
+const int MARGIN = 4;
+const int ITEM_HEIGHT = 4 * LINE_HEIGHT + 2 * MARGIN;
+
+enum RenameState {
+    RENAME_NONE = 0,
+    RENAME_ACCEPTED,
+    RENAME_REJECTED
+};
+
+/// Clickable or editable part of a layer row.
+enum LayerField {
+    FIELD_NONE = 0,
+    FIELD_VISIBLE,
+    FIELD_PERIOD,
+    FIELD_SAVE,
+    FIELD_CLONE,
+    FIELD_DELETE,
+    FIELD_NAME,
+    FIELD_POSITION
+};
+
+/// Return rectangle of a field inside the item rectangle.
+QRect fieldRect(const QRect& item, LayerField field) {
+    const int previewSize = Urho3D::PreviewCache::GetSize();
+    const int left = item.left() + MARGIN;
+    const int top = item.top() + MARGIN;
+    const int width = item.width() - previewSize - 3 * MARGIN;
+    const int half = width / 2;
+    const int third = width / 3;
+
+    switch (field) {
+    case FIELD_VISIBLE: return QRect(left, top, half, LINE_HEIGHT);
+    case FIELD_PERIOD: return QRect(left + half, top, width - half, LINE_HEIGHT);
+    case FIELD_SAVE: return QRect(left, top + LINE_HEIGHT, third, LINE_HEIGHT);
+    case FIELD_CLONE: return QRect(left + third, top + LINE_HEIGHT, third, LINE_HEIGHT);
+    case FIELD_DELETE: return QRect(left + 2 * third, top + LINE_HEIGHT, width - 2 * third, LINE_HEIGHT);
+    case FIELD_NAME: return QRect(left, top + 2 * LINE_HEIGHT, width, LINE_HEIGHT);
+    case FIELD_POSITION: return QRect(left, top + 3 * LINE_HEIGHT, width, LINE_HEIGHT);
+    default: return QRect();
+    }
+}
+
+LayerField hitField(const QRect& item, const QPoint& pos) {
+    for (int field = FIELD_VISIBLE; field <= FIELD_POSITION; ++field) {
+        if (fieldRect(item, (LayerField)field).contains(pos)) {
+            return (LayerField)field;
+        }
+    }
+    return FIELD_NONE;
+}
+} // namespace
+
 namespace Urho3D
 {
-    
+
+/// State of one row of the layers panel.
+struct LayerRow
+{
+    LayerHandle layer = INVALID_LAYER;
+    QString fileName;
+    bool visible = true;
+    bool dirty = false;
+    int period = -1;
+    int x = 0;
+    int y = 0;
+    RenameState renameState = RENAME_NONE;
+};
+
+/// List model over the open layers. Rows are found by layer handle in constant time.
+class LayerListModel : public QAbstractListModel
+{
+public:
+    LayerListModel(QObject* parent) :
+        QAbstractListModel(parent)
+    {
+    }
+
+    void setPreviewCache(PreviewCache* previewCache) { m_previewCache = previewCache; }
+
+    void append(LayerHandle layer, const QString& fileName) {
+        int row = (int)m_rows.size();
+        beginInsertRows(QModelIndex(), row, row);
+        LayerRow entry;
+        entry.layer = layer;
+        entry.fileName = fileName;
+        m_rows.push_back(entry);
+        m_rowIndex.InsertAt(layer, row);
+        endInsertRows();
+    }
+
+    bool removeLayer(LayerHandle layer) {
+        int row = rowOf(layer);
+        if (row < 0) {
+            return false;
+        }
+        beginRemoveRows(QModelIndex(), row, row);
+        m_rows.erase(m_rows.begin() + row);
+        m_rowIndex.Remove(layer);
+        for (int i = row; i < (int)m_rows.size(); ++i) {
+            *m_rowIndex.Get(m_rows[i].layer) = i;
+        }
+        endRemoveRows();
+        return true;
+    }
+
+    int rowOf(LayerHandle layer) const {
+        const int* row = m_rowIndex.Get(layer);
+        return row ? *row : -1;
+    }
+
+    LayerRow* find(LayerHandle layer) {
+        int row = rowOf(layer);
+        return row < 0 ? nullptr : &m_rows[row];
+    }
+
+    const LayerRow& at(int row) const { return m_rows[row]; }
+    const std::vector<LayerRow>& rows() const { return m_rows; }
+
+    /// Repaint row if visible.
+    void rowChanged(LayerHandle layer) {
+        int row = rowOf(layer);
+        if (row >= 0) {
+            QModelIndex changed = index(row);
+            emit dataChanged(changed, changed);
+        }
+    }
+
+    virtual int rowCount(const QModelIndex& parent = QModelIndex()) const {
+        return parent.isValid() ? 0 : (int)m_rows.size();
+    }
+
+    virtual QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const {
+        if (!index.isValid() || index.row() >= (int)m_rows.size()) {
+            return QVariant();
+        }
+
+        const LayerRow& entry = m_rows[index.row()];
+        if (role == Qt::DisplayRole || role == Qt::ToolTipRole) {
+            return entry.fileName;
+        }
+        if (role == Qt::DecorationRole && m_previewCache) {
+            // Only visible rows are painted, so only they request previews
+            QPixmap frame = m_previewCache->GetFrame(entry.fileName);
+            if (frame.isNull()) {
+                m_previewCache->Request(entry.fileName);
+            }
+            return frame;
+        }
+        return QVariant();
+    }
+
+    virtual Qt::ItemFlags flags(const QModelIndex& index) const {
+        return QAbstractListModel::flags(index) | Qt::ItemIsEditable;
+    }
+
+private:
+    std::vector<LayerRow> m_rows;
+    LayerTable<int> m_rowIndex;
+    PreviewCache* m_previewCache = nullptr;
+};
+
+/// Paints layer rows and turns clicks into panel actions. Line edits exist only while a field is edited.
+class LayerItemDelegate : public QStyledItemDelegate
+{
+public:
+    LayerItemDelegate(NodeManagerWidget* manager, LayerListModel* model) :
+        QStyledItemDelegate(manager),
+        m_manager(manager),
+        m_model(model)
+    {
+    }
+
+    virtual QSize sizeHint(const QStyleOptionViewItem&, const QModelIndex&) const {
+        return QSize(ITEM_WIDTH, ITEM_HEIGHT);
+    }
+
+    virtual void paint(QPainter* painter, const QStyleOptionViewItem& option, const QModelIndex& index) const {
+        const LayerRow& entry = m_model->at(index.row());
+        const QRect& rect = option.rect;
+        const bool isSelected = option.state & QStyle::State_Selected;
+        QStyle* style = option.widget ? option.widget->style() : QApplication::style();
+
+        painter->save();
+
+        // Status colors are fixed, so the brushes are built once
+        static const QBrush dirtyBrush(QColor(255, 0, 0, 25));
+        static const QBrush dirtySelectedBrush(QColor(255, 0, 0, 51));
+        static const QBrush selectedBrush(QColor(0, 0, 0, 51));
+        if (entry.dirty) {
+            painter->fillRect(rect, isSelected ? dirtySelectedBrush : dirtyBrush);
+        } else if (isSelected) {
+            painter->fillRect(rect, selectedBrush);
+        }
+
+        QStyleOptionButton checkBox;
+        checkBox.rect = fieldRect(rect, FIELD_VISIBLE);
+        checkBox.text = tr("Visible");
+        checkBox.state = QStyle::State_Enabled | (entry.visible ? QStyle::State_On : QStyle::State_Off);
+        style->drawControl(QStyle::CE_CheckBox, &checkBox, painter, option.widget);
+
+        QString period = entry.period > 0 ? tr("restart emiter in %1 ms").arg(entry.period) : tr("restart emiter: off");
+        painter->drawText(fieldRect(rect, FIELD_PERIOD), Qt::AlignVCenter | Qt::AlignLeft, period);
+
+        drawButton(painter, style, option, FIELD_SAVE, tr("Save"));
+        drawButton(painter, style, option, FIELD_CLONE, tr("Clone"));
+        drawButton(painter, style, option, FIELD_DELETE, tr("Delete"));
+
+        static const QBrush acceptedBrush(QColor(0x2E, 0xCC, 0x40));
+        static const QBrush rejectedBrush(QColor(0xFF, 0xA7, 0x6B));
+        QRect name = fieldRect(rect, FIELD_NAME);
+        if (entry.renameState == RENAME_ACCEPTED) {
+            painter->fillRect(name, acceptedBrush);
+        } else if (entry.renameState == RENAME_REJECTED) {
+            painter->fillRect(name, rejectedBrush);
+        }
+        QString fileName = option.fontMetrics.elidedText(entry.fileName, Qt::ElideLeft, name.width());
+        painter->drawText(name, Qt::AlignVCenter | Qt::AlignLeft, fileName);
+
+        painter->drawText(fieldRect(rect, FIELD_POSITION), Qt::AlignVCenter | Qt::AlignLeft,
+                          QString("%1,%2").arg(entry.x).arg(entry.y));
+
+        QPixmap preview = index.data(Qt::DecorationRole).value<QPixmap>();
+        if (!preview.isNull()) {
+            const int previewSize = PreviewCache::GetSize();
+            painter->drawPixmap(rect.right() - MARGIN - previewSize, rect.top() + MARGIN, preview);
+        }
+
+        painter->restore();
+    }
+
+    virtual bool editorEvent(QEvent* event, QAbstractItemModel* model, const QStyleOptionViewItem& option,
+                             const QModelIndex& index) {
+        if (event->type() != QEvent::MouseButtonRelease && event->type() != QEvent::MouseButtonDblClick) {
+            return QStyledItemDelegate::editorEvent(event, model, option, index);
+        }
+
+        QMouseEvent* mouseEvent = static_cast<QMouseEvent*>(event);
+        if (mouseEvent->button() != Qt::LeftButton) {
+            return false;
+        }
+
+        const LayerRow& entry = m_model->at(index.row());
+        const LayerHandle layer = entry.layer;
+        LayerField field = hitField(option.rect, mouseEvent->pos());
+
+        if (event->type() == QEvent::MouseButtonDblClick) {
+            // Let the view open an editor for text fields only
+            m_editField = field;
+            return !(field == FIELD_NAME || field == FIELD_PERIOD || field == FIELD_POSITION);
+        }
+
+        NodeManagerWidget* manager = m_manager;
+        switch (field) {
+        case FIELD_VISIBLE:
+            manager->setVisible(layer, !entry.visible);
+            return true;
+        case FIELD_SAVE:
+            emit manager->saveRequested(layer);
+            return true;
+        case FIELD_CLONE:
+            emit manager->cloneRequested(layer);
+            return true;
+        case FIELD_DELETE:
+            // Rows must not go away while the view is still handling the click
+            QTimer::singleShot(0, manager, [manager, layer]() {
+                if (manager->remove(layer)) {
+                    emit manager->deleteRequested(layer);
+                }
+            });
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    virtual QWidget* createEditor(QWidget* parent, const QStyleOptionViewItem&, const QModelIndex&) const {
+        QLineEdit* editor = new QLineEdit(parent);
+        editor->setProperty("field", (int)m_editField);
+        if (m_editField == FIELD_PERIOD) {
+            editor->setValidator(new QIntValidator(0, 10000, editor));
+        }
+        return editor;
+    }
+
+    virtual void setEditorData(QWidget* editor, const QModelIndex& index) const {
+        const LayerRow& entry = m_model->at(index.row());
+        QLineEdit* lineEdit = static_cast<QLineEdit*>(editor);
+        switch (editorField(editor)) {
+        case FIELD_NAME:
+            lineEdit->setText(entry.fileName);
+            break;
+        case FIELD_PERIOD:
+            lineEdit->setText(QString::number(entry.period));
+            break;
+        case FIELD_POSITION:
+            lineEdit->setText(QString("%1,%2").arg(entry.x).arg(entry.y));
+            break;
+        default:
+            break;
+        }
+    }
+
+    virtual void setModelData(QWidget* editor, QAbstractItemModel*, const QModelIndex& index) const {
+        const LayerHandle layer = m_model->at(index.row()).layer;
+        const QString text = static_cast<QLineEdit*>(editor)->text();
+        switch (editorField(editor)) {
+        case FIELD_NAME:
+            m_manager->requestRename(layer, text);
+            break;
+        case FIELD_PERIOD:
+            m_manager->setPeriod(layer, text.toInt());
+            break;
+        case FIELD_POSITION: {
+            QStringList numbers = text.split(",");
+            if (numbers.size() == 2) {
+                m_manager->setPosition(layer, numbers[0].toInt(), numbers[1].toInt());
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    virtual void updateEditorGeometry(QWidget* editor, const QStyleOptionViewItem& option, const QModelIndex&) const {
+        editor->setGeometry(fieldRect(option.rect, editorField(editor)));
+    }
+
+private:
+    NodeManagerWidget* m_manager;
+    LayerListModel* m_model;
+    LayerField m_editField = FIELD_NONE;
+
+    static LayerField editorField(const QWidget* editor) {
+        return (LayerField)editor->property("field").toInt();
+    }
+
+    static QString tr(const char* text) {
+        return QApplication::translate("NodeManagerWidget", text);
+    }
+
+    void drawButton(QPainter* painter, QStyle* style, const QStyleOptionViewItem& option,
+                    LayerField field, const QString& text) const {
+        QStyleOptionButton button;
+        button.rect = fieldRect(option.rect, field);
+        button.text = text;
+        button.state = QStyle::State_Enabled | QStyle::State_Raised;
+        style->drawControl(QStyle::CE_PushButton, &button, painter, option.widget);
+    }
+};
+
 NodeManagerWidget::NodeManagerWidget(QWidget* parent) :
     QWidget(parent)
   , m_pbToggleGrid(new QPushButton(tr("grid"), this))
   , m_pbSaveAll(new QPushButton(tr("save all"), this))
-  , m_horizontalSpacer(new QSpacerItem(20, 20, QSizePolicy::Expanding, QSizePolicy::Minimum))
+  , m_pbAlignRestarts(new QPushButton(tr("sync restarts"), this))
+  , m_pbStress(new QPushButton(tr("stress"), this))
+  , m_lbShared(new QLabel(this))
+  , m_view(new QListView(this))
+  , m_model(new LayerListModel(this))
 {
+    m_delegate = new LayerItemDelegate(this, m_model);
+
     setLayout(new QHBoxLayout);
 
     layout()->setSizeConstraint(QLayout::SetMinimumSize);
@@ -47,14 +419,34 @@ NodeManagerWidget::NodeManagerWidget(QWidget* parent) :
     vBar->setLayout(new QVBoxLayout);
     vBar->layout()->addWidget(m_pbToggleGrid);
     vBar->layout()->addWidget(m_pbSaveAll);
+    vBar->layout()->addWidget(m_pbAlignRestarts);
+    vBar->layout()->addWidget(m_pbStress);
+    vBar->layout()->addWidget(m_lbShared);
     vBar->layout()->addItem(new QSpacerItem(10, 10, QSizePolicy::Minimum, QSizePolicy::Expanding));
 
+    m_view->setModel(m_model);
+    m_view->setItemDelegate(m_delegate);
+    m_view->setFlow(QListView::LeftToRight);
+    m_view->setWrapping(false);
+    m_view->setUniformItemSizes(true);
+    m_view->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    m_view->setEditTriggers(QAbstractItemView::DoubleClicked);
+    m_view->setHorizontalScrollMode(QAbstractItemView::ScrollPerPixel);
+    m_view->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    m_view->setFixedHeight(ITEM_HEIGHT + m_view->horizontalScrollBar()->sizeHint().height() + 2 * m_view->frameWidth());
+
     layout()->addWidget(vBar);
-    layout()->addItem(m_horizontalSpacer);
+    layout()->addWidget(m_view);
+
+    m_lbShared->setToolTip(tr("Memory saved by sharing identical effects and textures between layers"));
+    setSharedMemory(0);
+
+    connect(m_view, &QListView::pressed, this, &NodeManagerWidget::select);
+    connect(m_view->selectionModel(), &QItemSelectionModel::selectionChanged, this, &NodeManagerWidget::emitSelection);
 
     connect(m_pbToggleGrid, &QPushButton::clicked, this, [this]() {
         float step = 2;
-        int size = m_widgets.size();
+        int size = (int)m_model->rows().size();
         int rows = 2;
         float size_x = float(size)/rows;
 
@@ -63,10 +455,12 @@ NodeManagerWidget::NodeManagerWidget(QWidget* parent) :
 
         float x = left_border_x;
         float y = 0;
-        auto it = m_widgets.begin();
-        for(; it!=m_widgets.end(); ++it) {
-            NodeItemWidget* widget = it->second;
-            widget->setNodePosition(x,y);
+        std::vector<LayerHandle> layers;
+        for (const LayerRow& entry: m_model->rows()) {
+            layers.push_back(entry.layer);
+        }
+        for (LayerHandle layer: layers) {
+            setPosition(layer, x, y);
             x += step;
             if (x >= right_border_x) {
                 x = left_border_x;
@@ -78,131 +472,165 @@ NodeManagerWidget::NodeManagerWidget(QWidget* parent) :
     connect(m_pbSaveAll, &QPushButton::clicked, this, [this]{
         emit saveAllRequested();
     });
+
+    m_pbAlignRestarts->setToolTip(tr("Restart all periodic emitters now, so equal periods stay in step"));
+    connect(m_pbAlignRestarts, &QPushButton::clicked, this, [this]{
+        emit alignRestartsRequested();
+    });
+
+    m_pbStress->setToolTip(tr("Measure how the selected effect scales when instanced in a grid"));
+    connect(m_pbStress, &QPushButton::clicked, this, [this]{
+        emit stressRequested();
+    });
 }
 
 NodeManagerWidget::~NodeManagerWidget()
 {
 }
 
-void NodeManagerWidget::add(NodeItemWidget* item)
+void NodeManagerWidget::add(LayerHandle layer, const QString& fileName)
 {
-    auto it = m_widgets.find(item->key());
-    assert(it == m_widgets.end());
+    assert(m_model->rowOf(layer) < 0);
 
-    connect(item, &NodeItemWidget::visibleChanged, this, &NodeManagerWidget::visibleChanged);
-    connect(item, &NodeItemWidget::selected, this, [this](const QString& key){
-        emit selected(key);
-        for (auto it: m_widgets) {
-            auto w = it.second;
-            if (w->key() == key) {
-                w->select();
-            } else {
-                w->deselect();
-            }
-        }
-    });
-    connect(item, &NodeItemWidget::restartEmiterRequest, this, &NodeManagerWidget::restartEmiterRequest);
-    connect(item, &NodeItemWidget::saveRequested, this, &NodeManagerWidget::saveRequested);
-    connect(item, &NodeItemWidget::deleteRequested, this, [this](QString key){
-        assert(remove(key));
-        emit deleteRequested(key);
-    });
-    connect(item, &NodeItemWidget::nodePositionChanged, this, &NodeManagerWidget::nodePositionChanged);
-    connect(item, &NodeItemWidget::changeKeyRequest, this, [this](QString key, QString newKeyCandidate){
-        NodeItemWidget* widget = itemWidget(key);
-        if (isKeyUnique(newKeyCandidate)) {
-            assert(changeKey(key, newKeyCandidate));
-            widget->acceptNewKeyCandidate();
-            emit acceptKeyChangeRequest(key, newKeyCandidate);
-        } else {
-            widget->rejectNewKeyCandidate();
-        }
-    });
+    m_model->append(layer, fileName);
 
-    m_widgets.insert(std::make_pair(item->key(), item));
-    layout()->removeItem(m_horizontalSpacer);
-    layout()->addWidget(item);
-    layout()->addItem(m_horizontalSpacer);
+    if (m_model->rows().size() == 1) {
+        select(m_model->index(0));
+    }
+}
 
-    if (m_widgets.size() == 1) {
-        item->emitSelected();
+void NodeManagerWidget::select(const QModelIndex& index)
+{
+    if (!index.isValid()) {
+        return;
     }
+    m_view->setCurrentIndex(index);
+    emit selected(m_model->at(index.row()).layer);
 }
 
-bool NodeManagerWidget::hasUnsaved() const {
-    return (getDirtyKeys().size() !=0);
+void NodeManagerWidget::emitSelection()
+{
+    QVector<unsigned> layers;
+    for (const QModelIndex& index: m_view->selectionModel()->selectedIndexes()) {
+        layers << m_model->at(index.row()).layer;
+    }
+    emit selectionChanged(layers);
 }
 
-QList<QString> NodeManagerWidget::getDirtyKeys() const {
-    QList<QString> keys;
-    for(auto it: m_widgets) {
-        if (it.second->isDirty()) {
-            keys << it.first;
-        }
+void NodeManagerWidget::setDirty(LayerHandle layer, bool dirty) {
+    LayerRow* entry = m_model->find(layer);
+    if (entry && entry->dirty != dirty) {
+        entry->dirty = dirty;
+        m_model->rowChanged(layer);
     }
-    return keys;
 }
 
-void NodeManagerWidget::markDirty(QString key) {
-    NodeItemWidget* widget = itemWidget(key);
-    if (widget) {
-        widget->markDirty();
+bool NodeManagerWidget::rename(LayerHandle layer, const QString& fileName)
+{
+    LayerRow* entry = m_model->find(layer);
+    if (entry) {
+        entry->fileName = fileName;
+        m_model->rowChanged(layer);
+        return true;
     }
+    return false;
 }
 
-void NodeManagerWidget::unmarkDirty(QString key) {
-    NodeItemWidget* widget = itemWidget(key);
-    if (widget) {
-        widget->unmarkDirty();
+void NodeManagerWidget::requestRename(LayerHandle layer, const QString& fileName)
+{
+    LayerRow* entry = m_model->find(layer);
+    if (!entry || entry->fileName == fileName) {
+        return;
     }
+
+    bool accepted = isFileNameUnique(fileName);
+    if (accepted) {
+        assert(rename(layer, fileName));
+        emit renameAccepted(layer, fileName);
+    }
+
+    entry->renameState = accepted ? RENAME_ACCEPTED : RENAME_REJECTED;
+    m_model->rowChanged(layer);
+    QTimer::singleShot(DELAY_MS, this, [this, layer]{
+        if (LayerRow* entry = m_model->find(layer)) {
+            entry->renameState = RENAME_NONE;
+            m_model->rowChanged(layer);
+        }
+    });
 }
 
-NodeItemWidget* NodeManagerWidget::itemWidget(const QString& key) const {
-    auto it = m_widgets.find(key);
-    if (it != m_widgets.end()) {
-        NodeItemWidget* item = it->second;
-        return item;
+void NodeManagerWidget::setVisible(LayerHandle layer, bool visible)
+{
+    LayerRow* entry = m_model->find(layer);
+    if (entry) {
+        entry->visible = visible;
+        m_model->rowChanged(layer);
+        emit visibleChanged(layer, visible);
     }
-    return nullptr;
 }
 
-NodeItemWidget* NodeManagerWidget::takeItemWidget(const QString& key) {
-    auto it = m_widgets.find(key);
-    if (it != m_widgets.end()) {
-        NodeItemWidget* item = it->second;
-        m_widgets.erase(it);
-        return item;
+void NodeManagerWidget::setPeriod(LayerHandle layer, int periodMs)
+{
+    LayerRow* entry = m_model->find(layer);
+    if (!entry) {
+        return;
     }
-    return nullptr;
+    entry->period = periodMs > 0 ? periodMs : -1;
+    m_model->rowChanged(layer);
+    emit restartPeriodChanged(layer, entry->period);
 }
 
-bool NodeManagerWidget::changeKey(const QString& fromKey, const QString& toKey)
+void NodeManagerWidget::setPosition(LayerHandle layer, int x, int y)
 {
-    NodeItemWidget* widget = takeItemWidget(fromKey);
-    if (widget) {
-        widget->setKey(toKey);
-        m_widgets.insert(std::make_pair(toKey, widget));
-        return true;
+    LayerRow* entry = m_model->find(layer);
+    if (entry) {
+        entry->x = x;
+        entry->y = y;
+        m_model->rowChanged(layer);
+        emit nodePositionChanged(layer, x, y);
     }
-    return false;
 }
 
-bool NodeManagerWidget::remove(const QString& key)
+void NodeManagerWidget::setLayerState(LayerHandle layer, bool visible, int periodMs, int x, int y)
 {
-    NodeItemWidget* widget = takeItemWidget(key);
-    if (widget) {
-        layout()->removeWidget(widget);
-        delete widget;
-        return true;
-    } else {
-        return false;
+    LayerRow* entry = m_model->find(layer);
+    if (entry) {
+        entry->visible = visible;
+        entry->period = periodMs > 0 ? periodMs : -1;
+        entry->x = x;
+        entry->y = y;
+        m_model->rowChanged(layer);
     }
 }
 
-bool NodeManagerWidget::isKeyUnique(const QString& key) const
+void NodeManagerWidget::setPreviewCache(PreviewCache* previewCache)
+{
+    m_previewCache = previewCache;
+    m_model->setPreviewCache(previewCache);
+    connect(m_previewCache, &PreviewCache::frameChanged, this, [this]() {
+        m_view->viewport()->update();
+    });
+}
+
+void NodeManagerWidget::setSharedMemory(unsigned bytes)
 {
-    NodeItemWidget* widget = itemWidget(key);
-    return (widget == nullptr);
+    m_lbShared->setText(tr("shared\n%1 KB").arg(bytes / 1024));
+}
+
+bool NodeManagerWidget::remove(LayerHandle layer)
+{
+    return m_model->removeLayer(layer);
+}
+
+bool NodeManagerWidget::isFileNameUnique(const QString& fileName) const
+{
+    // Only runs on rename, so a scan is fine
+    for (const LayerRow& entry: m_model->rows()) {
+        if (entry.fileName == fileName) {
+            return false;
+        }
+    }
+    return true;
 }
 
 } // namespace Urho3D
@@ -22,16 +22,24 @@
 
 #pragma once
 
+#include "LayerTable.h"
+
+#include <QVector>
 #include <QWidget>
 
-class QSpacerItem;
+class QLabel;
+class QListView;
+class QModelIndex;
 class QPushButton;
 
 namespace Urho3D
 {
 
-class NodeItemWidget;
+class LayerItemDelegate;
+class LayerListModel;
+class PreviewCache;
 
+/// Layers panel. Rows are painted by a delegate and only visible rows cost anything, so hundreds of layers stay cheap.
 class NodeManagerWidget : public QWidget
 {
     Q_OBJECT
@@ -39,35 +47,49 @@ public:
     NodeManagerWidget(QWidget* parent);
     virtual ~NodeManagerWidget();
 
-    NodeItemWidget* itemWidget(const QString&) const;
-
-    bool hasUnsaved() const;
-    QList<QString> getDirtyKeys() const;
-
-    void unmarkDirty(QString key);
-    void markDirty(QString key);
-    void add(NodeItemWidget*);
-    bool remove(const QString&);
-    bool changeKey(const QString&, const QString&);
+    void setDirty(LayerHandle layer, bool dirty);
+    void add(LayerHandle layer, const QString& fileName);
+    bool remove(LayerHandle);
+    bool rename(LayerHandle, const QString&);
+    void setPreviewCache(PreviewCache*);
+    void setSharedMemory(unsigned bytes);
+    /// Show restored layer state without emitting change signals.
+    void setLayerState(LayerHandle layer, bool visible, int periodMs, int x, int y);
 
 signals:
-    void visibleChanged(const QString&, bool);
-    void deleteRequested(QString);
-    void nodePositionChanged(const QString&, int, int);
-    void acceptKeyChangeRequest(QString, QString);
-    void selected(const QString&);
-    void restartEmiterRequest(const QString&);
+    void visibleChanged(unsigned, bool);
+    void deleteRequested(unsigned);
+    void nodePositionChanged(unsigned, int, int);
+    void renameAccepted(unsigned, QString);
+    void selected(unsigned);
+    void selectionChanged(const QVector<unsigned>&);
+    void restartPeriodChanged(unsigned, int);
+    void alignRestartsRequested();
     void saveAllRequested();
-    void saveRequested(const QString&);
+    void saveRequested(unsigned);
+    void cloneRequested(unsigned);
+    void stressRequested();
 
 private:
+    friend class LayerItemDelegate;
+
     QPushButton* m_pbToggleGrid = nullptr;
     QPushButton* m_pbSaveAll = nullptr;
-    QSpacerItem* m_horizontalSpacer = nullptr;
-    std::map<QString, NodeItemWidget*> m_widgets;
+    QPushButton* m_pbAlignRestarts = nullptr;
+    QPushButton* m_pbStress = nullptr;
+    QLabel* m_lbShared = nullptr;
+    QListView* m_view = nullptr;
+    LayerListModel* m_model = nullptr;
+    LayerItemDelegate* m_delegate = nullptr;
+    PreviewCache* m_previewCache = nullptr;
 
-    NodeItemWidget* takeItemWidget(const QString&);
-    bool isKeyUnique(const QString& key) const;
+    void select(const QModelIndex& index);
+    void emitSelection();
+    void setVisible(LayerHandle layer, bool visible);
+    void setPeriod(LayerHandle layer, int periodMs);
+    void setPosition(LayerHandle layer, int x, int y);
+    void requestRename(LayerHandle layer, const QString& fileName);
+    bool isFileNameUnique(const QString& fileName) const;
 };
 
 }
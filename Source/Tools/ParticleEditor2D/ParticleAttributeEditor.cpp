@@ -22,6 +22,7 @@
 
 #include "ColorVarianceEditor.h"
 #include "ParticleAttributeEditor.h"
+#include "TraceRecorder.h"
 #include <Urho3D/Urho2D/ParticleEffect2D.h>
 #include "ValueVarianceEditor.h"
 
@@ -61,45 +62,40 @@ void ParticleAttributeEditor::HanldeValueVarianceEditorValueChanged(float averag
     if (updatingWidget_)
         return;
 
-    ParticleEffect2D* effect = GetEffect( GetSelectedKey() );
-    if (!effect) {
-        return;
-    }
-
     QObject* s = sender();
     if (s == particleLifeSpanEditor_)
     {
-        effect->SetParticleLifeSpan(average);
-        effect->SetParticleLifespanVariance(variance);
+        QueueEdit(PARAM_PARTICLE_LIFESPAN, average);
+        QueueEdit(PARAM_PARTICLE_LIFESPAN_VARIANCE, variance);
     }
     else if (s == startSizeEditor_)
     {
-        effect->SetStartParticleSize(average);
-        effect->SetStartParticleSizeVariance(variance);
+        QueueEdit(PARAM_START_PARTICLE_SIZE, average);
+        QueueEdit(PARAM_START_PARTICLE_SIZE_VARIANCE, variance);
     }
     else if (s == finishSizeEditor_)
     {
-        effect->SetFinishParticleSize(average);
-        effect->SetFinishParticleSizeVariance(variance);
+        QueueEdit(PARAM_FINISH_PARTICLE_SIZE, average);
+        QueueEdit(PARAM_FINISH_PARTICLE_SIZE_VARIANCE, variance);
     }
     else if (s == startRotationEditor_)
     {
-        effect->SetRotationStart(average);
-        effect->SetRotationStartVariance(variance);
+        QueueEdit(PARAM_ROTATION_START, average);
+        QueueEdit(PARAM_ROTATION_START_VARIANCE, variance);
     }
     else if (s == finishRotationEditor_)
     {
-        effect->SetRotationEnd(average);
-        effect->SetRotationEndVariance(variance);
+        QueueEdit(PARAM_ROTATION_END, average);
+        QueueEdit(PARAM_ROTATION_END_VARIANCE, variance);
     }
-
-    emit changed( GetSelectedKey().CString() );
 }
 
 
 void ParticleAttributeEditor::HandleUpdateWidget()
 {
-    ParticleEffect2D* effect = GetEffect( GetSelectedKey() );
+    EDITOR_TRACE("ParticleAttributeEditor::HandleUpdateWidget");
+
+    ParticleEffect2D* effect = GetEffect( GetSelectedLayer() );
     if (!effect) {
         return;
     }
@@ -135,15 +131,8 @@ void ParticleAttributeEditor::HandleStartColorEditorValueChanged(const Color& av
     if (updatingWidget_)
         return;
 
-    ParticleEffect2D* effect = GetEffect( GetSelectedKey() );
-    if (!effect) {
-        return;
-    }
-
-    effect->SetStartColor(average);
-    effect->SetStartColorVariance(variance);
-
-    emit changed( GetSelectedKey().CString() );
+    QueueEdit(PARAM_START_COLOR_R, average);
+    QueueEdit(PARAM_START_COLOR_VARIANCE_R, variance);
 }
 
 void ParticleAttributeEditor::HandleFinishColorEditorValueChanged(const Color& average, const Color& variance)
@@ -151,15 +140,8 @@ void ParticleAttributeEditor::HandleFinishColorEditorValueChanged(const Color& a
     if (updatingWidget_)
         return;
 
-    ParticleEffect2D* effect = GetEffect( GetSelectedKey() );
-    if (!effect) {
-        return;
-    }
-
-    effect->SetFinishColor(average);
-    effect->SetFinishColorVariance(variance);
-
-    emit changed( GetSelectedKey().CString() );
+    QueueEdit(PARAM_FINISH_COLOR_R, average);
+    QueueEdit(PARAM_FINISH_COLOR_VARIANCE_R, variance);
 }
 
 } // namespace Urho3D
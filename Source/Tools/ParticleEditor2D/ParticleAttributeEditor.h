@@ -39,9 +39,6 @@ public:
     ParticleAttributeEditor(Context* context);
     virtual ~ParticleAttributeEditor();
 
-signals:
-    void changed(QString);
-
 private slots:
     void HanldeValueVarianceEditorValueChanged(float average, float variance);
     void HandleStartColorEditorValueChanged(const Color& average, const Color& variance);
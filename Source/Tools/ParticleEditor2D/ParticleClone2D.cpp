@@ -0,0 +1,127 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "ParticleClone2D.h"
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Scene/Node.h>
+#include <Urho3D/Scene/Scene.h>
+#include <Urho3D/Scene/SceneEvents.h>
+#include <Urho3D/Urho2D/ParticleEmitter2D.h>
+
+namespace Urho3D
+{
+
+ParticleClone2D::ParticleClone2D(Context* context) :
+    Drawable2D(context)
+{
+    sourceBatches_.Resize(1);
+    sourceBatches_[0].owner_ = this;
+}
+
+ParticleClone2D::~ParticleClone2D()
+{
+}
+
+void ParticleClone2D::RegisterObject(Context* context)
+{
+    context->RegisterFactory<ParticleClone2D>();
+}
+
+void ParticleClone2D::SetSource(ParticleEmitter2D* source)
+{
+    source_ = source;
+    if (node_)
+        OnMarkedDirty(node_);
+}
+
+ParticleEffect2D* ParticleClone2D::GetEffect() const
+{
+    return source_ ? source_->GetEffect() : nullptr;
+}
+
+void ParticleClone2D::OnSceneSet(Scene* scene)
+{
+    Drawable2D::OnSceneSet(scene);
+
+    if (scene)
+        SubscribeToEvent(scene, E_SCENEPOSTUPDATE, URHO3D_HANDLER(ParticleClone2D, HandleScenePostUpdate));
+    else
+        UnsubscribeFromEvent(E_SCENEPOSTUPDATE);
+}
+
+void ParticleClone2D::OnWorldBoundingBoxUpdate()
+{
+    if (!source_ || !source_->GetNode())
+    {
+        worldBoundingBox_.Clear();
+        return;
+    }
+
+    worldBoundingBox_ = source_->GetWorldBoundingBox().Transformed(GetSourceToClone());
+}
+
+void ParticleClone2D::OnDrawOrderChanged()
+{
+}
+
+void ParticleClone2D::UpdateSourceBatches()
+{
+    if (!sourceBatchesDirty_)
+        return;
+    sourceBatchesDirty_ = false;
+
+    SourceBatch2D& batch = sourceBatches_[0];
+    batch.vertices_.Clear();
+    if (!source_ || !source_->GetNode())
+        return;
+
+    const Vector<SourceBatch2D>& sourceBatches = source_->GetSourceBatches();
+    if (sourceBatches.Empty())
+        return;
+
+    // Same material, so the clone batches with its source; only positions move
+    const SourceBatch2D& sourceBatch = sourceBatches[0];
+    batch.material_ = sourceBatch.material_;
+    batch.drawOrder_ = sourceBatch.drawOrder_;
+
+    const Matrix3x4 transform = GetSourceToClone();
+    batch.vertices_ = sourceBatch.vertices_;
+    for (unsigned i = 0; i < batch.vertices_.Size(); ++i)
+        batch.vertices_[i].position_ = transform * batch.vertices_[i].position_;
+}
+
+void ParticleClone2D::HandleScenePostUpdate(StringHash eventType, VariantMap& eventData)
+{
+    // The vertices are copied when rendering asks for them, by then the source has updated whatever the order of
+    // the post update handlers
+    OnMarkedDirty(node_);
+}
+
+Matrix3x4 ParticleClone2D::GetSourceToClone() const
+{
+    // Particles are simulated in world space around the source node
+    return node_->GetWorldTransform() * source_->GetNode()->GetWorldTransform().Inverse();
+}
+
+}
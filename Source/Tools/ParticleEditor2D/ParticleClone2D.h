@@ -0,0 +1,76 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <Urho3D/Urho2D/Drawable2D.h>
+
+namespace Urho3D
+{
+
+class ParticleEffect2D;
+class ParticleEmitter2D;
+
+/// Draws the particles of another emitter again under its own node transform. The source emitter does all the
+/// simulating; a clone only copies and transforms the vertices the source already built, once per frame. A hidden
+/// source keeps simulating while it has clones, so they go on moving.
+class ParticleClone2D : public Drawable2D
+{
+    URHO3D_OBJECT(ParticleClone2D, Drawable2D)
+
+public:
+    /// Construct.
+    ParticleClone2D(Context* context);
+    /// Destruct.
+    virtual ~ParticleClone2D();
+    /// Register object factory.
+    static void RegisterObject(Context* context);
+
+    /// Set emitter whose particles are drawn.
+    void SetSource(ParticleEmitter2D* source);
+    /// Return source emitter.
+    ParticleEmitter2D* GetSource() const { return source_; }
+    /// Return effect of the source emitter.
+    ParticleEffect2D* GetEffect() const;
+
+protected:
+    /// Handle scene being assigned.
+    virtual void OnSceneSet(Scene* scene);
+    /// Recalculate the world-space bounding box.
+    virtual void OnWorldBoundingBoxUpdate();
+    /// Handle draw order changed. Clones draw in the order of their source.
+    virtual void OnDrawOrderChanged();
+    /// Update source batches from the source emitter.
+    virtual void UpdateSourceBatches();
+
+private:
+    /// Handle scene post update, after the source has simulated.
+    void HandleScenePostUpdate(StringHash eventType, VariantMap& eventData);
+    /// Return transform from the source node to this node.
+    Matrix3x4 GetSourceToClone() const;
+
+    /// Source emitter.
+    WeakPtr<ParticleEmitter2D> source_;
+};
+
+}
@@ -20,9 +20,20 @@
 // THE SOFTWARE.
 //
 
+#include "EditHistory.h"
+#include "EditQueue.h"
+#include "LayerStats.h"
 #include "ParticleEditor.h"
 #include "MainWindow.h"
+#include "ParticleClone2D.h"
+#include "ParticleRecorder.h"
 #include "PathUtils.h"
+#include "PexImporter.h"
+#include "RenderWidget.h"
+#include "RestartScheduler.h"
+#include "SpritePreprocessor.h"
+#include "StressGrid.h"
+#include "TraceRecorder.h"
 
 #include <Urho3D/Graphics/Camera.h>
 #include <Urho3D/Engine/Console.h>
@@ -33,25 +44,37 @@
 #include <Urho3D/Graphics/DebugRenderer.h>
 #include <Urho3D/Engine/Engine.h>
 #include <Urho3D/Graphics/Graphics.h>
+#include <Urho3D/Graphics/GraphicsEvents.h>
 #include <Urho3D/Input/Input.h>
 #include <Urho3D/Input/InputEvents.h>
+#include <Urho3D/IO/FileSystem.h>
 #include <Urho3D/IO/Log.h>
 #include <Urho3D/Graphics/Octree.h>
+#include <Urho3D/Urho2D/Drawable2D.h>
 #include <Urho3D/Urho2D/ParticleEffect2D.h>
 #include <Urho3D/Urho2D/ParticleEmitter2D.h>
 #include <Urho3D/Urho2D/StaticSprite2D.h>
 #include <Urho3D/Urho2D/Sprite2D.h>
 #include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/Profiler.h>
+#include <Urho3D/Core/Timer.h>
 #include <Urho3D/Graphics/Renderer.h>
+#include <Urho3D/Graphics/Texture2D.h>
 #include <Urho3D/Resource/ResourceCache.h>
 #include <Urho3D/Scene/Scene.h>
 #include <Urho3D/Graphics/Viewport.h>
+#include <Urho3D/Graphics/Zone.h>
 #include <Urho3D/Resource/XMLFile.h>
 
+#include <QDir>
+#include <QDirIterator>
 #include <QFile>
+#include <QStandardPaths>
 #include <QTimer>
 #include <QDebug>
 
+#include <set>
+
 namespace Urho3D
 {
 
@@ -60,14 +83,35 @@ ParticleEditor::ParticleEditor(int argc, char** argv, Context* context) :
     Object(context),
     engine_(new Engine(context_)),
     scene_(new Scene(context_)),
-    mainWindow_(new MainWindow(context_))
+    mainWindow_(new MainWindow(context_)),
+    selectedLayer_(INVALID_LAYER),
+    relativeBatchEdits_(false)
 {
+
     SubscribeToEvent(E_UPDATE, URHO3D_HANDLER(ParticleEditor, HandleUpdate));
     SubscribeToEvent(E_KEYDOWN, URHO3D_HANDLER(ParticleEditor, HandleKeyDown));
     SubscribeToEvent(E_MOUSEWHEEL, URHO3D_HANDLER(ParticleEditor, HandleMouseWheel));
     SubscribeToEvent(E_RENDERUPDATE, URHO3D_HANDLER(ParticleEditor, HandleRenderUpdate));
+    SubscribeToEvent(E_SCREENMODE, URHO3D_HANDLER(ParticleEditor, HandleScreenMode));
 
     QApplication::setApplicationName("Urho2DParticleEditor");
+
+    ParticleClone2D::RegisterObject(context_);
+
+    // Processed sprites are cached under the application name
+    importer_ = new PexImporter(context_);
+    spritePreprocessor_ = new SpritePreprocessor(context_);
+    importer_->SetSpritePreprocessor(spritePreprocessor_);
+    importer_->SetShareResources(true);
+
+    editQueue_ = new EditQueue(context_);
+    editHistory_ = new EditHistory(context_);
+    layerStats_ = new LayerStats(context_);
+    workspace_ = new Workspace(context_);
+    connect(editQueue_.Get(), &EditQueue::applied, this, [this](const QVector<unsigned>& layers) {
+        for (unsigned layer: layers)
+            UpdateDirty(layer);
+    });
 }
 
 ParticleEditor::~ParticleEditor()
@@ -77,31 +121,55 @@ ParticleEditor::~ParticleEditor()
 
 int ParticleEditor::Run()
 {
+    startupTimings_.EndStage("Construct");
+
     VariantMap engineParameters;
     engineParameters[EP_FRAME_LIMITER] = false;
     engineParameters[EP_RESOURCE_PATHS] = "CoreData;Data";
     engineParameters[EP_LOG_NAME] = "ParticleEditor2D.log";
-    engineParameters[EP_EXTERNAL_WINDOW] = (void*)(mainWindow_->centralWidget()->winId());
+    RenderWidget* renderWidget = mainWindow_->GetRenderWidget();
+    const QSize renderSize = renderWidget->pixelSize();
+    engineParameters[EP_EXTERNAL_WINDOW] = (void*)(renderWidget->winId());
+    engineParameters[EP_WINDOW_WIDTH] = renderSize.width();
+    engineParameters[EP_WINDOW_HEIGHT] = renderSize.height();
     engineParameters[EP_WINDOW_RESIZABLE] = true;
     engineParameters[EP_FULL_SCREEN] = false;
 
     if (!engine_->Initialize(engineParameters))
         return -1;
 
+    TraceRecorder::Get().SetProfiler(GetSubsystem<Profiler>());
+    startupTimings_.EndStage("Engine");
+
+    // SDL does not see size changes of an external window, so they come from Qt
+    connect(renderWidget, &RenderWidget::resized, this, &ParticleEditor::HandleRenderResized);
+
     mainWindow_->CreateWidgets();
+    startupTimings_.EndStage("Widgets");
 
+    // Console and debug HUD are created on first F1 / F2
     CreateScene();
+    restartScheduler_ = new RestartScheduler(context_, scene_);
+    layerStats_->SetScene(scene_);
+    stressGrid_ = new StressGrid(context_, scene_);
+    recorder_ = new ParticleRecorder(context_, scene_);
     CreateParticles();
-    CreateConsole();
-    CreateDebugHud();
+    startupTimings_.EndStage("Scene");
 
     QTimer timer;
     connect(&timer, SIGNAL(timeout()), this, SLOT(OnTimeout()));
     timer.start(16);
 
     mainWindow_->OpenPrevioslyOpenedPS();
+    startupTimings_.EndStage("Session");
 
-    return QApplication::exec();
+    const int result = QApplication::exec();
+
+    String report = frameTimings_.GetReport();
+    if (!report.Empty())
+        URHO3D_LOGINFO("Frame timings per resolution:\n" + report);
+
+    return result;
 }
 
 //void ParticleEditor::RemoveSelected()
@@ -117,13 +185,16 @@ void ParticleEditor::CreateParticles()
     }
 }
 
-bool ParticleEditor::restartEmiter(const String& key)
+bool ParticleEditor::restartEmiter(LayerHandle layer)
 {
-    auto it = particleNodes_.find(key);
-    if (it != particleNodes_.end()) {
-        selectedParticleNode_ = it->second;
-
-        ParticleEmitter2D* emiter = selectedParticleNode_->GetComponent<ParticleEmitter2D>();
+    if (Layer* entry = layers_.Get(layer)) {
+        // Scheduled restarts run for every layer, the selection stays where it is
+        // Clones restart with their source
+        if (recorder_)
+            recorder_->Restart(layer);
+        ParticleEmitter2D* emiter = entry->node_->GetComponent<ParticleEmitter2D>();
+        if (!emiter)
+            return true;
         ParticleEffect2D* effect = emiter->GetEffect();
         emiter->SetEffect(nullptr);
         emiter->SetEffect(effect);
@@ -133,12 +204,21 @@ bool ParticleEditor::restartEmiter(const String& key)
     return false;
 }
 
-bool ParticleEditor::select(const String& key)
+bool ParticleEditor::SetRestartPeriod(LayerHandle layer, unsigned periodMs)
+{
+    if (!layers_.Contains(layer))
+        return false;
+
+    restartScheduler_->SetPeriod(layer, periodMs);
+    workspace_->SetRestartPeriod(layer, periodMs);
+    return true;
+}
+
+bool ParticleEditor::select(LayerHandle layer)
 {
-    auto it = particleNodes_.find(key);
-    if (it != particleNodes_.end()) {
-        selectedKey_ = key;
-        selectedParticleNode_ = it->second;
+    if (Layer* entry = layers_.Get(layer)) {
+        selectedLayer_ = layer;
+        selectedParticleNode_ = entry->node_;
         pointerNode_->SetEnabled(true);
         selectedAnimation_.start();
 
@@ -147,79 +227,399 @@ bool ParticleEditor::select(const String& key)
     return false;
 }
 
-bool ParticleEditor::SetVisible(const String& key, bool visible)
+bool ParticleEditor::SetVisible(LayerHandle layer, bool visible)
 {
-    auto it = particleNodes_.find(key);
-    if (it != particleNodes_.end()) {
-        SharedPtr<Node>& node = it->second;
-        node->SetEnabled(visible);
+    if (Layer* entry = layers_.Get(layer)) {
+        entry->visible_ = visible;
+        ApplyVisibility(layer);
+        workspace_->SetVisible(layer, visible);
         return true;
     }
     return false;
 }
 
-bool ParticleEditor::RemoveParticleNode(const String& key)
+void ParticleEditor::ApplyVisibility(LayerHandle layer)
+{
+    Layer* entry = layers_.Get(layer);
+    if (!entry)
+        return;
+
+    bool hasClones = false;
+    layers_.ForEach([&](LayerHandle, const Layer& clone) {
+        if (clone.source_ == layer)
+            hasClones = true;
+    });
+
+    // Disabling the node would freeze the clones too, so a hidden source only stops drawing
+    entry->node_->SetEnabled(entry->visible_ || hasClones);
+    if (Drawable2D* drawable = entry->node_->GetDerivedComponent<Drawable2D>())
+        drawable->SetViewMask(entry->visible_ ? DEFAULT_VIEWMASK : 0);
+}
+
+bool ParticleEditor::IsVisible(LayerHandle layer) const
+{
+    const Layer* entry = layers_.Get(layer);
+    return entry && entry->visible_;
+}
+
+Vector2 ParticleEditor::GetParticleNodePosition(LayerHandle layer) const
+{
+    const Layer* entry = layers_.Get(layer);
+    return entry ? entry->node_->GetPosition2D() : Vector2::ZERO;
+}
+
+void ParticleEditor::SetZoom(float zoom)
+{
+    GetCamera()->SetZoom(zoom);
+    workspace_->SetZoom(zoom);
+}
+
+void ParticleEditor::SetBackgroundColor(const Color& color)
+{
+    GetSubsystem<Renderer>()->GetDefaultZone()->SetFogColor(color);
+    workspace_->SetBackgroundColor(color);
+}
+
+bool ParticleEditor::OpenWorkspace()
+{
+    EDITOR_TRACE("OpenWorkspace");
+
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(dir);
+    workspaceFileName_ = (dir + "/workspace.pews").toStdString().c_str();
+
+    const bool loaded = workspace_->Load(workspaceFileName_);
+
+    // Take the loaded state, layers are recorded again under the handles they get now. Clones go last so that
+    // their sources exist by the time they are opened.
+    pendingLayers_.Clear();
+    restoredLayers_.Clear();
+    const PODVector<LayerHandle> layers = workspace_->GetLayers();
+    for (LayerHandle layer: layers) {
+        if (workspace_->GetLayer(layer)->source_ == INVALID_LAYER)
+            pendingLayers_.Push(MakePair(layer, *workspace_->GetLayer(layer)));
+    }
+    for (LayerHandle layer: layers) {
+        if (workspace_->GetLayer(layer)->source_ != INVALID_LAYER)
+            pendingLayers_.Push(MakePair(layer, *workspace_->GetLayer(layer)));
+    }
+    const float zoom = workspace_->GetZoom();
+    const bool hasBackgroundColor = workspace_->HasBackgroundColor();
+    const Color backgroundColor = workspace_->GetBackgroundColor();
+    workspace_->Clear();
+    failedLayers_ = 0;
+
+    SetZoom(zoom);
+    if (hasBackgroundColor)
+        SetBackgroundColor(backgroundColor);
+
+    if (!progressiveStartup_ || pendingLayers_.Empty()) {
+        RestorePendingLayers(0);
+        FinishWorkspace();
+    }
+    return loaded;
+}
+
+void ParticleEditor::RestorePendingLayers(long long budgetUSec)
 {
-    auto it = particleNodes_.find(key);
-    if (it != particleNodes_.end()) {
-        SharedPtr<Node> node = it->second;
+    EDITOR_TRACE("RestorePendingLayers");
+
+    // Always open at least one layer so that progress is made on slow frames too
+    HiresTimer timer;
+    unsigned count = 0;
+    while (count < pendingLayers_.Size() && (!budgetUSec || !count || timer.GetUSec(false) < budgetUSec)) {
+        const WorkspaceLayer& state = pendingLayers_[count].second_;
+        const LayerHandle savedLayer = pendingLayers_[count++].first_;
+
+        // A clone whose source is gone opens its own file, if it was ever saved
+        LayerHandle layer = INVALID_LAYER;
+        HashMap<LayerHandle, LayerHandle>::ConstIterator source = restoredLayers_.Find(state.source_);
+        if (state.source_ != INVALID_LAYER && source != restoredLayers_.End())
+            layer = AddCloneNode(source->second_, state.fileName_);
+        else if (isFileAlreadyOpened(state.fileName_.CString())) {
+            // Opened by hand while the rest was still restoring, clones of it attach to that layer
+            restoredLayers_[savedLayer] = FindLayer(state.fileName_);
+            continue;
+        } else
+            layer = AddParticleNode(state.fileName_);
+        if (layer == INVALID_LAYER) {
+            ++failedLayers_;
+            continue;
+        }
+        layers_.Get(layer)->node_->SetPosition2D(state.position_);
+        workspace_->SetPosition(layer, state.position_);
+        SetVisible(layer, state.visible_);
+        if (state.restartPeriod_)
+            SetRestartPeriod(layer, state.restartPeriod_);
+        restoredLayers_[savedLayer] = layer;
+        emit LayerRestored(layer);
+    }
+    pendingLayers_.Erase(0, count);
+}
+
+void ParticleEditor::FinishWorkspace()
+{
+    // Layers not opened yet are not in the workspace state, so the file is only rewritten once all of them are
+    workspace_->Open(workspaceFileName_);
+
+    if (failedLayers_)
+        URHO3D_LOGWARNING(String(failedLayers_) + " workspace effects could not be opened");
+    if (layers_.Size())
+        mainWindow_->UpdateWidget();
+}
+
+void ParticleEditor::FinishStartup()
+{
+    startupFinished_ = true;
+    URHO3D_LOGINFO("Startup timings:\n" + startupTimings_.GetReport());
+}
+
+LayerHandle ParticleEditor::CloneLayer(LayerHandle layer, const String& fileName)
+{
+    const Layer* entry = layers_.Get(layer);
+    if (!entry || (!fileName.Empty() && FindLayer(fileName) != INVALID_LAYER))
+        return INVALID_LAYER;
+
+    // Clones of clones share the original simulation
+    const LayerHandle source = entry->source_ != INVALID_LAYER ? entry->source_ : layer;
+    String cloneFileName = fileName;
+    if (cloneFileName.Empty()) {
+        const String& sourceFileName = layers_.Get(source)->fileName_;
+        const String baseName = Urho3D::GetPath(sourceFileName) + Urho3D::GetFileName(sourceFileName) + "_clone";
+        for (unsigned i = 1; cloneFileName.Empty() || FindLayer(cloneFileName) != INVALID_LAYER ||
+            QFile(cloneFileName.CString()).exists(); ++i)
+            cloneFileName = baseName + String(i) + Urho3D::GetExtension(sourceFileName);
+    }
+
+    // Beside the cloned layer, one grid step to the right
+    LayerHandle clone = AddCloneNode(source, cloneFileName);
+    if (clone != INVALID_LAYER) {
+        const Vector2 position = GetParticleNodePosition(layer) + Vector2(2.0f, 0.0f);
+        layers_.Get(clone)->node_->SetPosition2D(position);
+        workspace_->SetPosition(clone, position);
+    }
+    return clone;
+}
+
+LayerHandle ParticleEditor::GetCloneSource(LayerHandle layer) const
+{
+    const Layer* entry = layers_.Get(layer);
+    return entry ? entry->source_ : INVALID_LAYER;
+}
+
+LayerHandle ParticleEditor::AddCloneNode(LayerHandle source, const String& fileName)
+{
+    const Layer* sourceEntry = layers_.Get(source);
+    ParticleEmitter2D* sourceEmitter = GetEmitter(source);
+    if (!sourceEntry || !sourceEmitter)
+        return INVALID_LAYER;
+
+    SharedPtr<Node> node = SharedPtr<Node>(scene_->CreateChild("ParticleClone2D"));
+    node->SetPosition2D(sourceEntry->node_->GetPosition2D());
+    node->CreateComponent<ParticleClone2D>()->SetSource(sourceEmitter);
+
+    Layer entry;
+    entry.node_ = node;
+    entry.fileName_ = fileName;
+    entry.source_ = source;
+    LayerHandle layer = layers_.Insert(entry);
+    if (layer == INVALID_LAYER) {
+        node->Remove();
+        return INVALID_LAYER;
+    }
+    MarkSaved(layer);
+    ApplyVisibility(source);
+
+    WorkspaceLayer state;
+    state.fileName_ = fileName;
+    state.position_ = node->GetPosition2D();
+    state.source_ = source;
+    workspace_->AddLayer(layer, state);
+
+    emit NewParticleNodeAdded(layer);
+    return layer;
+}
+
+void ParticleEditor::SplitClone(LayerHandle layer)
+{
+    Layer* entry = layers_.Get(layer);
+    ParticleClone2D* clone = entry ? entry->node_->GetComponent<ParticleClone2D>() : nullptr;
+    if (!clone)
+        return;
+
+    // From here on the layer simulates by itself, its effect is copied on the first write like any shared effect
+    EDITOR_TRACE("SplitClone");
+    SharedPtr<ParticleEffect2D> effect(clone->GetEffect());
+    entry->node_->RemoveComponent(clone);
+    entry->node_->CreateComponent<ParticleEmitter2D>()->SetEffect(effect);
+    const LayerHandle source = entry->source_;
+    entry->source_ = INVALID_LAYER;
+    ApplyVisibility(layer);
+    ApplyVisibility(source);
+    emit SharedResourcesChanged();
+}
+
+bool ParticleEditor::RemoveParticleNode(LayerHandle layer)
+{
+    // Clones cannot outlive the simulation they draw
+    PODVector<LayerHandle> clones;
+    layers_.ForEach([&](LayerHandle clone, const Layer& entry) {
+        if (entry.source_ == layer)
+            clones.Push(clone);
+    });
+    for (LayerHandle clone: clones)
+        SplitClone(clone);
+
+    if (recorder_ && recorder_->GetLayer() == layer)
+        recorder_->Stop();
+
+    if (Layer* entry = layers_.Get(layer)) {
+        SharedPtr<Node> node = entry->node_;
         scene_->RemoveChild(node);
         node->Remove();
-        particleNodes_.erase(it);
+        layers_.Remove(layer);
+        dirtyLayers_.Erase(layer);
+        restartScheduler_->Remove(layer);
+        layerStats_->Remove(layer);
+        workspace_->RemoveLayer(layer);
+        if (selectedLayer_ == layer)
+            selectedLayer_ = INVALID_LAYER;
+        selectedLayers_.Remove(layer);
+        emit SharedResourcesChanged();
         return true;
     }
 
     return false;
 }
 
-bool ParticleEditor::SetParticleNodePosition(const String& key, int x, int y)
+bool ParticleEditor::SetParticleNodePosition(LayerHandle layer, int x, int y)
 {
-    auto it = particleNodes_.find(key);
-    if (it != particleNodes_.end()) {
-        SharedPtr<Node> node = it->second;
-        node->SetPosition2D(Vector2(x,y));
+    if (Layer* entry = layers_.Get(layer)) {
+        entry->node_->SetPosition2D(Vector2(x,y));
+        workspace_->SetPosition(layer, Vector2(x, y));
         return true;
     }
 
     return false;
 }
 
-bool ParticleEditor::AddParticleNode(const String& fileName)
+LayerHandle ParticleEditor::AddParticleNode(const String& fileName)
 {
-    ResourceCache* cache = GetSubsystem<ResourceCache>();
-    ParticleEffect2D* particleEffect = cache->GetResource<ParticleEffect2D>(fileName);
+    // Identical effects and textures are shared between layers until one of them is edited
+    SharedPtr<ParticleEffect2D> particleEffect = importer_->Import(fileName);
+    importer_->ClearIssues();
     if (!particleEffect) {
-        return false;
+        return INVALID_LAYER;
     }
 
     SharedPtr<Node> node = SharedPtr<Node>(scene_->CreateChild("ParticleEmitter2D"));
     ParticleEmitter2D* particleEmitter = node->CreateComponent<ParticleEmitter2D>();
     particleEmitter->SetEffect(particleEffect);
 
-    particleNodes_.insert(std::make_pair(fileName, node));
+    Layer entry;
+    entry.node_ = node;
+    entry.fileName_ = fileName;
+    LayerHandle layer = layers_.Insert(entry);
+    if (layer == INVALID_LAYER) {
+        node->Remove();
+        return INVALID_LAYER;
+    }
+    MarkSaved(layer);
 
-    QString key(fileName.CString());
-    emit NewParticleNodeAdded(key);
-    return true;
+    WorkspaceLayer state;
+    state.fileName_ = fileName;
+    workspace_->AddLayer(layer, state);
+
+    emit NewParticleNodeAdded(layer);
+    emit SharedResourcesChanged();
+    return layer;
 }
 
-bool ParticleEditor::isFileAlreadyOpened(const QString& key) const
+bool ParticleEditor::isFileAlreadyOpened(const QString& fileName) const
 {
-    auto it = particleNodes_.find(key.toStdString().c_str());
-    return (it != particleNodes_.end());
+    return FindLayer(fileName.toStdString().c_str()) != INVALID_LAYER;
 }
 
-QList<QString> ParticleEditor::GetKeys() const
+LayerHandle ParticleEditor::FindLayer(const String& fileName) const
 {
-    QList<QString> keys;
-    for(auto it: particleNodes_) {
-        keys<<it.first.CString();
-    }
-    return keys;
+    // File names are only looked up when opening, edits go through handles
+    LayerHandle found = INVALID_LAYER;
+    layers_.ForEach([&](LayerHandle layer, const Layer& entry) {
+        if (entry.fileName_ == fileName)
+            found = layer;
+    });
+    return found;
+}
+
+const String& ParticleEditor::GetFileName(LayerHandle layer) const
+{
+    const Layer* entry = layers_.Get(layer);
+    return entry ? entry->fileName_ : String::EMPTY;
+}
+
+QList<LayerHandle> ParticleEditor::GetLayers() const
+{
+    QList<LayerHandle> layers;
+    layers_.ForEach([&layers](LayerHandle layer, const Layer&) {
+        layers << layer;
+    });
+    return layers;
+}
+
+QList<LayerHandle> ParticleEditor::GetDirtyLayers() const
+{
+    QList<LayerHandle> layers;
+    for (HashSet<LayerHandle>::ConstIterator it = dirtyLayers_.Begin(); it != dirtyLayers_.End(); ++it)
+        layers << *it;
+    return layers;
+}
+
+unsigned ParticleEditor::GetGeneration(LayerHandle layer) const
+{
+    const Layer* entry = layers_.Get(layer);
+    return entry ? entry->generation_ : 0;
+}
+
+void ParticleEditor::UpdateDirty(LayerHandle layer)
+{
+    Layer* entry = layers_.Get(layer);
+    if (!entry)
+        return;
+
+    ++entry->generation_;
+
+    // Compare content rather than count edits, so reverting a value clears the flag
+    EffectParams params;
+    ReadEffectParams(GetEffect(layer), params);
+    SetDirty(layer, params != entry->savedParams_);
+}
+
+void ParticleEditor::MarkSaved(LayerHandle layer)
+{
+    Layer* entry = layers_.Get(layer);
+    if (!entry)
+        return;
+
+    ReadEffectParams(GetEffect(layer), entry->savedParams_);
+    SetDirty(layer, false);
+}
+
+void ParticleEditor::SetDirty(LayerHandle layer, bool dirty)
+{
+    if (dirty == dirtyLayers_.Contains(layer))
+        return;
+
+    if (dirty)
+        dirtyLayers_.Insert(layer);
+    else
+        dirtyLayers_.Erase(layer);
+    emit DirtyChanged(layer, dirty);
 }
 
 bool ParticleEditor::Open(QString filepath)
 {
+    EDITOR_TRACE("Open");
+
     if (!QFile(filepath).exists()) {
         showInfoMessageBox(QString("File %1 doesn't exist. Abort.").arg(filepath));
         return false;
@@ -228,7 +628,7 @@ bool ParticleEditor::Open(QString filepath)
         showInfoMessageBox(QString("The %1 already opened. Abort").arg(filepath));
         return false;
     }
-    if (!AddParticleNode(filepath.toStdString().c_str())) {
+    if (AddParticleNode(filepath.toStdString().c_str()) == INVALID_LAYER) {
         showInfoMessageBox(QString("Fail to open %1 particle effect. Abort").arg(filepath));
         return false;
     }
@@ -237,9 +637,52 @@ bool ParticleEditor::Open(QString filepath)
 }
 
 
-bool ParticleEditor::Save(const String& filepath)
+unsigned ParticleEditor::ImportFolder(const QString& path)
 {
-    ParticleEffect2D* particleEffect = GetEffect(filepath);
+    EDITOR_TRACE("ImportFolder");
+
+    unsigned opened = 0;
+    unsigned failed = 0;
+
+    QDirIterator it(path, QStringList("*.pex"), QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        QString filepath = it.next();
+        if (isFileAlreadyOpened(filepath))
+            continue;
+        if (AddParticleNode(filepath.toStdString().c_str()) != INVALID_LAYER)
+            ++opened;
+        else
+            ++failed;
+    }
+
+    if (failed)
+        showInfoMessageBox(QString("Fail to open %1 particle effects, see the log for details.").arg(failed));
+
+    if (opened)
+        mainWindow_->UpdateWidget();
+    return opened;
+}
+
+bool ParticleEditor::Save(LayerHandle layer)
+{
+    if (!Save(layer, GetFileName(layer)))
+        return false;
+
+    // A split clone reopens from its own file from now on
+    if (GetCloneSource(layer) == INVALID_LAYER)
+        workspace_->SetSource(layer, INVALID_LAYER);
+    MarkSaved(layer);
+    return true;
+}
+
+bool ParticleEditor::Save(LayerHandle layer, const String& filepath)
+{
+    EDITOR_TRACE("Save");
+
+    // Include edits made since the last frame
+    editQueue_->Flush();
+
+    ParticleEffect2D* particleEffect = GetEffect(layer);
     if (!particleEffect)
         return false;
 
@@ -257,24 +700,78 @@ Camera* ParticleEditor::GetCamera() const
     return cameraNode_->GetComponent<Camera>();
 }
 
-ParticleEffect2D* ParticleEditor::GetEffect(const String& key) const
+ParticleEffect2D* ParticleEditor::GetEffect(LayerHandle layer) const
 {
-    ParticleEmitter2D* emitter = GetEmitter( key );
+    if (ParticleEmitter2D* emitter = GetEmitter(layer))
+        return emitter->GetEffect();
+
+    const Layer* entry = layers_.Get(layer);
+    ParticleClone2D* clone = entry ? entry->node_->GetComponent<ParticleClone2D>() : nullptr;
+    return clone ? clone->GetEffect() : nullptr;
+}
+
+ParticleEffect2D* ParticleEditor::GetEffectForEdit(LayerHandle layer)
+{
+    SplitClone(layer);
+
+    ParticleEmitter2D* emitter = GetEmitter(layer);
     if (!emitter)
         return nullptr;
 
-    return emitter->GetEffect();
+    ParticleEffect2D* effect = emitter->GetEffect();
+    if (!effect || GetNumEffectUsers(effect) < 2)
+        return effect;
+
+    // Copy on write, the other layers keep the shared effect
+    SharedPtr<ParticleEffect2D> clone = effect->Clone(GetFileName(layer));
+    emitter->SetEffect(clone);
+    emit SharedResourcesChanged();
+    return clone;
 }
 
+unsigned ParticleEditor::GetNumEffectUsers(const ParticleEffect2D* effect) const
+{
+    unsigned users = 0;
+    layers_.ForEach([&](LayerHandle, const Layer& entry) {
+        ParticleEmitter2D* emitter = entry.node_->GetComponent<ParticleEmitter2D>();
+        if (emitter && emitter->GetEffect() == effect)
+            ++users;
+    });
+    return users;
+}
 
-ParticleEmitter2D* ParticleEditor::GetEmitter(const String& key) const
+unsigned ParticleEditor::GetSharedMemorySavings() const
 {
-    auto it = particleNodes_.find(key);
-    if (it != particleNodes_.end()) {
-        const SharedPtr<Node>& node = it->second;
-        return node->GetComponent<ParticleEmitter2D>();
-    }
-    return nullptr;
+    // Compare against every layer owning its own effect and texture
+    std::set<const ParticleEffect2D*> effects;
+    std::set<const Texture2D*> textures;
+    unsigned unshared = 0;
+    unsigned shared = 0;
+
+    layers_.ForEach([&](LayerHandle, const Layer& entry) {
+        ParticleEmitter2D* emitter = entry.node_->GetComponent<ParticleEmitter2D>();
+        const ParticleEffect2D* effect = emitter ? emitter->GetEffect() : nullptr;
+        if (!effect)
+            return;
+
+        const Sprite2D* sprite = effect->GetSprite();
+        const Texture2D* texture = sprite ? sprite->GetTexture() : nullptr;
+        const unsigned textureMemory = texture ? texture->GetMemoryUse() : 0;
+
+        unshared += sizeof(ParticleEffect2D) + textureMemory;
+        if (effects.insert(effect).second)
+            shared += sizeof(ParticleEffect2D);
+        if (texture && textures.insert(texture).second)
+            shared += textureMemory;
+    });
+
+    return unshared - shared;
+}
+
+ParticleEmitter2D* ParticleEditor::GetEmitter(LayerHandle layer) const
+{
+    const Layer* entry = layers_.Get(layer);
+    return entry ? entry->node_->GetComponent<ParticleEmitter2D>() : nullptr;
 }
 
 
@@ -285,8 +782,43 @@ ParticleEditor* ParticleEditor::Get()
 
 void ParticleEditor::OnTimeout()
 {
-    if (engine_ && !engine_->IsExiting())
+    // Time from one timeout to the next, the gaps between our sections belong to Qt
+    TraceRecorder& recorder = TraceRecorder::Get();
+    const long long now = recorder.Now();
+    if (lastTimeout_)
+        recorder.Add("Frame", lastTimeout_, now);
+    lastTimeout_ = now;
+
+    TraceScope scope("OnTimeout", false);
+
+    if (engine_ && !engine_->IsExiting()) {
+        ApplyPendingResize();
+
+        TraceScope runFrameScope("RunFrame", false);
+        HiresTimer frameTimer;
         engine_->RunFrame();
+        const long long frameUSec = frameTimer.GetUSec(false);
+
+        Graphics* graphics = GetSubsystem<Graphics>();
+        frameTimings_.AddFrame(IntVector2(graphics->GetWidth(), graphics->GetHeight()), frameUSec);
+        stressGrid_->AddFrame(frameUSec);
+
+        if (!firstFrame_) {
+            firstFrame_ = true;
+            startupTimings_.EndStage("First frame");
+        }
+    }
+
+    // Progressive startup, the rest of the frame budget goes to opening layers
+    if (firstFrame_ && !pendingLayers_.Empty()) {
+        RestorePendingLayers(8000);
+        if (pendingLayers_.Empty()) {
+            FinishWorkspace();
+            startupTimings_.EndStage("Layers");
+        }
+    }
+    if (firstFrame_ && !startupFinished_ && pendingLayers_.Empty())
+        FinishStartup();
 
     // animation to point currently selected particle node
     if (selectedParticleNode_ && selectedAnimation_.isActive()) {
@@ -300,6 +832,34 @@ void ParticleEditor::OnTimeout()
     }
 }
 
+void ParticleEditor::HandleRenderResized(int width, int height)
+{
+    // A drag delivers many sizes, only the latest one is applied
+    pendingSize_ = IntVector2(width, height);
+}
+
+void ParticleEditor::ApplyPendingResize()
+{
+    if (pendingSize_ == IntVector2::ZERO)
+        return;
+
+    Graphics* graphics = GetSubsystem<Graphics>();
+    if (pendingSize_.x_ != graphics->GetWidth() || pendingSize_.y_ != graphics->GetHeight())
+        graphics->SetMode(pendingSize_.x_, pendingSize_.y_);
+    pendingSize_ = IntVector2::ZERO;
+}
+
+void ParticleEditor::HandleScreenMode(StringHash eventType, VariantMap& eventData)
+{
+    using namespace ScreenMode;
+
+    if (!cameraNode_)
+        return;
+
+    Camera* camera = cameraNode_->GetComponent<Camera>();
+    camera->SetOrthoSize(eventData[P_HEIGHT].GetInt() * PIXEL_SIZE);
+}
+
 void ParticleEditor::CreateScene()
 {
     scene_ = new Scene(context_);
@@ -329,30 +889,44 @@ void ParticleEditor::CreateScene()
     pointerNode_->SetEnabled(false);
 }
 
-void ParticleEditor::CreateConsole()
+XMLFile* ParticleEditor::GetDefaultStyle()
 {
-    // Get default style
-    ResourceCache* cache = GetSubsystem<ResourceCache>();
-    XMLFile* xmlFile = cache->GetResource<XMLFile>("UI/DefaultStyle.xml");
-
-    // Create console
-    Console* console = engine_->CreateConsole();
-    console->SetDefaultStyle(xmlFile);
+    if (!defaultStyle_)
+    {
+        ResourceCache* cache = GetSubsystem<ResourceCache>();
+        defaultStyle_ = cache->GetResource<XMLFile>("UI/DefaultStyle.xml");
+    }
+    return defaultStyle_;
 }
 
-void ParticleEditor::CreateDebugHud()
+Console* ParticleEditor::CreateConsole()
 {
-    // Get default style
-    ResourceCache* cache = GetSubsystem<ResourceCache>();
-    XMLFile* xmlFile = cache->GetResource<XMLFile>("UI/DefaultStyle.xml");
+    Console* console = GetSubsystem<Console>();
+    if (!console)
+    {
+        EDITOR_TRACE("CreateConsole");
+        console = engine_->CreateConsole();
+        console->SetDefaultStyle(GetDefaultStyle());
+    }
+    return console;
+}
 
-    // Create debug HUD.
-    DebugHud* debugHud = engine_->CreateDebugHud();
-    debugHud->SetDefaultStyle(xmlFile);
+DebugHud* ParticleEditor::CreateDebugHud()
+{
+    DebugHud* debugHud = GetSubsystem<DebugHud>();
+    if (!debugHud)
+    {
+        EDITOR_TRACE("CreateDebugHud");
+        debugHud = engine_->CreateDebugHud();
+        debugHud->SetDefaultStyle(GetDefaultStyle());
+    }
+    return debugHud;
 }
 
 void ParticleEditor::HandleUpdate(StringHash eventType, VariantMap& eventData)
 {
+    EDITOR_TRACE("HandleUpdate");
+
     using namespace Update;
 
     // Take the frame time step, which is stored as a float
@@ -370,6 +944,13 @@ void ParticleEditor::HandleUpdate(StringHash eventType, VariantMap& eventData)
         Camera* camera = cameraNode_->GetComponent<Camera>();
         Vector3 worldPoint = camera->ScreenToWorldPoint(screenPoint);
         selectedParticleNode_->SetPosition(worldPoint);
+        draggedLayer_ = selectedLayer_;
+    }
+    else if (draggedLayer_ != INVALID_LAYER)
+    {
+        // One workspace record per drag
+        workspace_->SetPosition(draggedLayer_, GetParticleNodePosition(draggedLayer_));
+        draggedLayer_ = INVALID_LAYER;
     }
 }
 
@@ -378,9 +959,9 @@ void ParticleEditor::HandleKeyDown(StringHash eventType, VariantMap& eventData)
     using namespace KeyDown;
     int key = eventData[P_KEY].GetInt();
     if (key == KEY_F1)
-        GetSubsystem<Console>()->Toggle();
+        CreateConsole()->Toggle();
     else if (key == KEY_F2)
-        GetSubsystem<DebugHud>()->ToggleAll();
+        CreateDebugHud()->ToggleAll();
 }
 
 void ParticleEditor::HandleMouseWheel(StringHash eventType, VariantMap& eventData)
@@ -390,13 +971,15 @@ void ParticleEditor::HandleMouseWheel(StringHash eventType, VariantMap& eventDat
     int wheel = eventData[P_WHEEL].GetInt();
     Camera* camera = cameraNode_->GetComponent<Camera>();
     if (wheel > 0)
-        camera->SetZoom(camera->GetZoom() * 1.25f);
+        SetZoom(camera->GetZoom() * 1.25f);
     else
-        camera->SetZoom(camera->GetZoom() * 0.80f);
+        SetZoom(camera->GetZoom() * 0.80f);
 }
 
 void ParticleEditor::HandleRenderUpdate(StringHash eventType, VariantMap& eventData)
 {
+    EDITOR_TRACE("HandleRenderUpdate");
+
     Camera* camera = cameraNode_->GetComponent<Camera>();
     const float value = 20.0f / camera->GetZoom();
     const Color color(0.0f, 0.5f, 0.0f, 0.5f);
@@ -407,22 +990,27 @@ void ParticleEditor::HandleRenderUpdate(StringHash eventType, VariantMap& eventD
     debugRenderer->Render();
 }
 
-bool ParticleEditor::changeKey(const String& fromKey, const String& toKey)
+bool ParticleEditor::Rename(LayerHandle layer, const String& fileName)
 {
-    auto it = particleNodes_.find(fromKey);
-    if (it != particleNodes_.end()) {
-        SharedPtr<Node> node = it->second;
-        particleNodes_.erase(it);
-        particleNodes_.insert(std::make_pair(toKey, node));
-        return renameFile(fromKey.CString(), toKey.CString());
-    }
-    return false;
+    Layer* entry = layers_.Get(layer);
+    if (!entry)
+        return false;
+
+    // Clones have no file until their first save, for them only the name to save under changes
+    const bool hasFile = QFile(entry->fileName_.CString()).exists();
+    if (hasFile && !renameFile(entry->fileName_.CString(), fileName.CString()))
+        return false;
+
+    // Only the file changes, every handle held by widgets and queues stays valid
+    entry->fileName_ = fileName;
+    workspace_->SetFileName(layer, fileName);
+    return true;
 }
 
-bool ParticleEditor::renameFile(const QString& fromKey, const QString& toKey) const
+bool ParticleEditor::renameFile(const QString& fromFileName, const QString& toFileName) const
 {
-    QString absPathFrom( fromKey );
-    QString absPathTo( toKey );
+    QString absPathFrom( fromFileName );
+    QString absPathTo( toFileName );
 
     if (QFile(absPathTo).exists()) {
         QString msg("file %1 already exists, will be backup as %2");
@@ -20,7 +20,15 @@
 // THE SOFTWARE.
 //
 
+#include "EffectParams.h"
+#include "FrameTimings.h"
+#include "LayerTable.h"
+#include "StartupTimings.h"
+#include "Workspace.h"
+
 #include <Urho3D/Core/Object.h>
+#include <Urho3D/Container/HashMap.h>
+#include <Urho3D/Container/HashSet.h>
 #include <Urho3D/Container/Ptr.h>
 
 #include <QApplication>
@@ -62,12 +70,23 @@ private:
 
 class Camera;
 class Context;
+class EditHistory;
+class EditQueue;
 class Engine;
+class LayerStats;
 class MainWindow;
 class Node;
 class ParticleEffect2D;
 class ParticleEmitter2D;
+class ParticleRecorder;
+class PexImporter;
+class RestartScheduler;
+class SpritePreprocessor;
 class Scene;
+class StressGrid;
+class Console;
+class DebugHud;
+class XMLFile;
 
 /// Particle editor class.
 class ParticleEditor : public QApplication, public Object
@@ -84,31 +103,112 @@ public:
     /// Run.
     int Run();
 
-    bool SetVisible(const String& key, bool visible);
-    bool RemoveParticleNode(const String& key);
-    bool SetParticleNodePosition(const String& key, int x, int y);
+    bool SetVisible(LayerHandle layer, bool visible);
+    bool RemoveParticleNode(LayerHandle layer);
+    bool SetParticleNodePosition(LayerHandle layer, int x, int y);
+    /// Return whether layer is visible.
+    bool IsVisible(LayerHandle layer) const;
+    /// Return layer position.
+    Vector2 GetParticleNodePosition(LayerHandle layer) const;
+    /// Set camera zoom.
+    void SetZoom(float zoom);
+    /// Set background color.
+    void SetBackgroundColor(const Color& color);
+
+    /// Reopen the layers and view of the last session with one read of the workspace file, then keep recording
+    /// changes to it. Return false if there was no workspace. With progressive startup the layers are opened a few
+    /// per frame afterwards.
+    bool OpenWorkspace();
+    /// Set whether startup shows the window first and opens the workspace layers over the following frames.
+    void SetProgressiveStartup(bool enable) { progressiveStartup_ = enable; }
+    /// Return whether startup is progressive.
+    bool GetProgressiveStartup() const { return progressiveStartup_; }
 
     bool Open(QString fileName);
-    bool Save(const String& fileName);
-    bool changeKey(const String& fromKey, const String& toKey);
-    bool restartEmiter(const String& key);
-    bool select(const String& key);
+    /// Open every .pex file under the directory. Return number of opened files.
+    unsigned ImportFolder(const QString& path);
+    /// Save layer to its file.
+    bool Save(LayerHandle layer);
+    /// Save layer to another file. The layer keeps its file name.
+    bool Save(LayerHandle layer, const String& fileName);
+    /// Rename layer file. The layer handle does not change.
+    bool Rename(LayerHandle layer, const String& fileName);
+    bool restartEmiter(LayerHandle layer);
+    /// Restart layer emitter every period on the scene clock, zero to stop.
+    bool SetRestartPeriod(LayerHandle layer, unsigned periodMs);
+    bool select(LayerHandle layer);
 
-    const String& GetFileName() const { return selectedKey_; }
+    /// Return selected layer.
+    LayerHandle GetSelectedLayer() const { return selectedLayer_; }
+    /// Set layers that attribute edits apply to, including the selected one.
+    void SetSelectedLayers(const PODVector<LayerHandle>& layers) { selectedLayers_ = layers; }
+    /// Create a layer that draws the simulation of layer again at another position, until its first edit splits it
+    /// off into an independent copy. Without a file name the next free <name>_clone<N> is used. Return the clone, or
+    /// invalid on failure.
+    LayerHandle CloneLayer(LayerHandle layer, const String& fileName = String::EMPTY);
+    /// Return layer whose simulation a clone draws, or invalid if layer simulates by itself.
+    LayerHandle GetCloneSource(LayerHandle layer) const;
+    /// Return layers that attribute edits apply to.
+    const PODVector<LayerHandle>& GetSelectedLayers() const { return selectedLayers_; }
+    /// Set whether edits move the other selected layers by the same offset instead of to the same value.
+    void SetRelativeBatchEdits(bool enable) { relativeBatchEdits_ = enable; }
+    /// Return whether edits of several layers are relative.
+    bool GetRelativeBatchEdits() const { return relativeBatchEdits_; }
+    /// Return file name of layer.
+    const String& GetFileName(LayerHandle layer) const;
+    /// Return layer opened from file, or invalid if none.
+    LayerHandle FindLayer(const String& fileName) const;
     /// Return camera.
     Camera* GetCamera() const;
     /// Return effect.
-    ParticleEffect2D* GetEffect(const String&) const;
+    ParticleEffect2D* GetEffect(LayerHandle layer) const;
+    /// Return effect to modify. An effect shared with other layers is cloned first.
+    ParticleEffect2D* GetEffectForEdit(LayerHandle layer);
     /// Return emitter.
-    ParticleEmitter2D* GetEmitter(const String&) const;
+    ParticleEmitter2D* GetEmitter(LayerHandle layer) const;
+    /// Return number of layers using the effect.
+    unsigned GetNumEffectUsers(const ParticleEffect2D* effect) const;
+    /// Return memory saved by sharing identical effects and textures between layers.
+    unsigned GetSharedMemorySavings() const;
+    /// Return queue that applies attribute edits once per frame.
+    EditQueue* GetEditQueue() const { return editQueue_; }
+    /// Return undo history of attribute edits.
+    EditHistory* GetEditHistory() const { return editHistory_; }
+    /// Return scheduler of periodic emitter restarts.
+    RestartScheduler* GetRestartScheduler() const { return restartScheduler_; }
+    /// Return per-layer runtime statistics.
+    LayerStats* GetLayerStats() const { return layerStats_; }
+    /// Return stress grid measurements.
+    StressGrid* GetStressGrid() const { return stressGrid_; }
+    /// Return simulation recorder.
+    ParticleRecorder* GetParticleRecorder() const { return recorder_; }
+    /// Return frame time statistics per backbuffer resolution.
+    const FrameTimings& GetFrameTimings() const { return frameTimings_; }
+    /// Return texture preprocessor used when opening effects.
+    SpritePreprocessor* GetSpritePreprocessor() const { return spritePreprocessor_; }
 
-    QList<QString> GetKeys() const;
+    /// Return all layers in slot order.
+    QList<LayerHandle> GetLayers() const;
+    /// Return whether layer differs from its file.
+    bool IsDirty(LayerHandle layer) const { return dirtyLayers_.Contains(layer); }
+    /// Return whether any layer differs from its file.
+    bool HasUnsaved() const { return !dirtyLayers_.Empty(); }
+    /// Return layers that differ from their files.
+    QList<LayerHandle> GetDirtyLayers() const;
+    /// Return change generation of layer, incremented by every applied edit.
+    unsigned GetGeneration(LayerHandle layer) const;
 
     /// Return editor pointer.
     static ParticleEditor* Get();
 
 signals:
-    void NewParticleNodeAdded(QString);
+    void NewParticleNodeAdded(unsigned layer);
+    /// Emitted when a workspace layer got its position, visibility and restart period back.
+    void LayerRestored(unsigned layer);
+    /// Emitted when a layer starts or stops differing from its file.
+    void DirtyChanged(unsigned layer, bool dirty);
+    /// Emitted when layers start or stop sharing resources.
+    void SharedResourcesChanged();
 
 private slots:
     // Timeout handler.
@@ -117,10 +217,18 @@ private slots:
 private:
     /// Create scene.
     void CreateScene();
-    /// Create console.
-    void CreateConsole();
-    /// Create debug HUD.
-    void CreateDebugHud();
+    /// Return console, creating it on first use.
+    Console* CreateConsole();
+    /// Return debug HUD, creating it on first use.
+    DebugHud* CreateDebugHud();
+    /// Return UI style shared by the console and debug HUD, loading it on first use.
+    XMLFile* GetDefaultStyle();
+    /// Open pending workspace layers until the time budget runs out, all of them if zero.
+    void RestorePendingLayers(long long budgetUSec);
+    /// Start recording to the workspace file once every pending layer is open.
+    void FinishWorkspace();
+    /// Log the startup timings once the first frame is shown and the workspace is open.
+    void FinishStartup();
     /// Handle update event.
     void HandleUpdate(StringHash eventType, VariantMap& eventData);
     /// Handle key down (toggle debug HUD).
@@ -129,9 +237,27 @@ private:
     void HandleMouseWheel(StringHash eventType, VariantMap& eventData);
     /// Handle render update.
     void HandleRenderUpdate(StringHash eventType, VariantMap& eventData);
+    /// Handle screen mode change, keeping one world unit per pixel height.
+    void HandleScreenMode(StringHash eventType, VariantMap& eventData);
+    /// Handle resize of the render widget, applied before the next frame.
+    void HandleRenderResized(int width, int height);
+    /// Resize the backbuffer to the render widget if it changed.
+    void ApplyPendingResize();
 
 //    void RemoveSelected();
-    bool AddParticleNode(const String&);
+    LayerHandle AddParticleNode(const String&);
+    /// Add layer drawing the simulation of source.
+    LayerHandle AddCloneNode(LayerHandle source, const String& fileName);
+    /// Give a clone its own emitter. Does nothing for other layers.
+    void SplitClone(LayerHandle layer);
+    /// Show or hide layer. A hidden layer stops simulating, unless clones draw its simulation.
+    void ApplyVisibility(LayerHandle layer);
+    /// Recompute dirty state of layer after a change.
+    void UpdateDirty(LayerHandle layer);
+    /// Take current parameters of layer as its saved content.
+    void MarkSaved(LayerHandle layer);
+    /// Set dirty state and notify on change.
+    void SetDirty(LayerHandle layer, bool dirty);
 
     /// Editor main window.
     MainWindow* mainWindow_;
@@ -141,18 +267,85 @@ private:
     SharedPtr<Scene> scene_;
     /// Camera node.
     SharedPtr<Node> cameraNode_;
-    /// Particle nodes <filename, Node>.
-    std::map<String, SharedPtr<Node>> particleNodes_;
+    /// Streaming .pex importer.
+    SharedPtr<PexImporter> importer_;
+    /// Texture preprocessor.
+    SharedPtr<SpritePreprocessor> spritePreprocessor_;
+    /// Attribute edit queue.
+    SharedPtr<EditQueue> editQueue_;
+    /// Attribute edit undo history.
+    SharedPtr<EditHistory> editHistory_;
+    /// Periodic emitter restarts.
+    SharedPtr<RestartScheduler> restartScheduler_;
+    /// Per-layer runtime statistics.
+    SharedPtr<LayerStats> layerStats_;
+    /// Session layout.
+    SharedPtr<Workspace> workspace_;
+    /// Instance scaling measurements.
+    SharedPtr<StressGrid> stressGrid_;
+    /// Simulation recorder.
+    SharedPtr<ParticleRecorder> recorder_;
+    /// Workspace file name.
+    String workspaceFileName_;
+    /// Workspace layers not opened yet, with their handles in the workspace file.
+    Vector<Pair<LayerHandle, WorkspaceLayer> > pendingLayers_;
+    /// Handles of opened workspace layers by their handles in the workspace file.
+    HashMap<LayerHandle, LayerHandle> restoredLayers_;
+    /// Number of workspace layers that failed to open.
+    unsigned failedLayers_ = 0;
+    /// Layer moved by mouse drag, recorded when the button is released.
+    LayerHandle draggedLayer_ = INVALID_LAYER;
+    /// Open workspace layers over the first frames.
+    bool progressiveStartup_ = true;
+    /// Startup stage timings.
+    StartupTimings startupTimings_;
+    /// Startup report was logged.
+    bool startupFinished_ = false;
+    /// First frame was rendered.
+    bool firstFrame_ = false;
+    /// UI style of the console and debug HUD.
+    SharedPtr<XMLFile> defaultStyle_;
+    /// Frame time statistics.
+    FrameTimings frameTimings_;
+    /// Render widget size waiting to be applied, zero if none.
+    IntVector2 pendingSize_;
+    /// Trace time of the last timeout.
+    long long lastTimeout_ = 0;
+    /// Particle layer.
+    struct Layer
+    {
+        /// Emitter node.
+        SharedPtr<Node> node_;
+        /// Effect file, kept for saving and display only.
+        String fileName_;
+        /// Parameters as last opened or saved.
+        EffectParams savedParams_;
+        /// Incremented by every applied change.
+        unsigned generation_ = 0;
+        /// Layer whose simulation this clone draws, invalid if not a clone.
+        LayerHandle source_ = INVALID_LAYER;
+        /// Whether the layer is drawn.
+        bool visible_ = true;
+    };
+
+    /// Particle layers by handle.
+    LayerTable<Layer> layers_;
+    /// Layers that differ from their files.
+    HashSet<LayerHandle> dirtyLayers_;
 
     ScaleDownAnimation selectedAnimation_;
-    String selectedKey_;
+    LayerHandle selectedLayer_;
+    /// Layers edited together.
+    PODVector<LayerHandle> selectedLayers_;
+    /// Edits of several layers are relative.
+    bool relativeBatchEdits_;
     SharedPtr<Node> selectedParticleNode_;
     SharedPtr<Node> pointerNode_;
 
     void CreateParticles();
 
-    bool isFileAlreadyOpened(const QString& key) const;
-    bool renameFile(const QString& fromKey, const QString& toKey) const;
+    bool isFileAlreadyOpened(const QString& fileName) const;
+    bool renameFile(const QString& fromFileName, const QString& toFileName) const;
 };
 
 } // namespace Urho3D
@@ -21,15 +21,18 @@
 // THE SOFTWARE.
 //
 
+#include "EditQueue.h"
 #include "ParticleEditor.h"
 #include "ParticleEffectEditor.h"
+#include "TraceRecorder.h"
 
 
 namespace Urho3D
 {
 ParticleEffectEditor::ParticleEffectEditor(Context* context) : 
     Object(context),
-    updatingWidget_(false)
+    updatingWidget_(false),
+    selectedLayer_(INVALID_LAYER)
 {
 
 }
@@ -48,14 +51,59 @@ void ParticleEffectEditor::UpdateWidget()
     updatingWidget_ = false;
 }
 
-ParticleEffect2D* ParticleEffectEditor::GetEffect(const String& key) const
+ParticleEffect2D* ParticleEffectEditor::GetEffect(LayerHandle layer) const
 {
-    return ParticleEditor::Get()->GetEffect(key);
+    return ParticleEditor::Get()->GetEffect(layer);
 }
 
-ParticleEmitter2D* ParticleEffectEditor::GetEmitter(const String& key) const
+ParticleEffect2D* ParticleEffectEditor::GetEffectForEdit(LayerHandle layer) const
 {
-    return ParticleEditor::Get()->GetEmitter(key);
+    return ParticleEditor::Get()->GetEffectForEdit(layer);
+}
+
+ParticleEmitter2D* ParticleEffectEditor::GetEmitter(LayerHandle layer) const
+{
+    return ParticleEditor::Get()->GetEmitter(layer);
+}
+
+void ParticleEffectEditor::QueueEdit(EffectParam param, float value) const
+{
+    EDITOR_TRACE("QueueEdit");
+
+    ParticleEditor* editor = ParticleEditor::Get();
+    EditQueue* queue = editor->GetEditQueue();
+
+    // Other selected layers follow the edited one, either to the same value or by the same offset. Enumerations
+    // have no meaningful offset.
+    const bool relative = editor->GetRelativeBatchEdits() && param != PARAM_EMITTER_TYPE && param != PARAM_BLEND_MODE;
+    const float delta = relative ? value - queue->GetValue(selectedLayer_, param) : 0.0f;
+
+    queue->Set(selectedLayer_, param, value);
+
+    const PODVector<LayerHandle>& layers = editor->GetSelectedLayers();
+    for (unsigned i = 0; i < layers.Size(); ++i)
+    {
+        if (layers[i] == selectedLayer_)
+            continue;
+        if (relative)
+            queue->Offset(layers[i], param, delta);
+        else
+            queue->Set(layers[i], param, value);
+    }
+}
+
+void ParticleEffectEditor::QueueEdit(EffectParam x, const Vector2& value) const
+{
+    QueueEdit(x, value.x_);
+    QueueEdit((EffectParam)(x + 1), value.y_);
+}
+
+void ParticleEffectEditor::QueueEdit(EffectParam r, const Color& value) const
+{
+    QueueEdit(r, value.r_);
+    QueueEdit((EffectParam)(r + 1), value.g_);
+    QueueEdit((EffectParam)(r + 2), value.b_);
+    QueueEdit((EffectParam)(r + 3), value.a_);
 }
 
 }
@@ -22,6 +22,9 @@
 
 #pragma once
 
+#include "EffectParams.h"
+#include "LayerTable.h"
+
 #include <Urho3D/Core/Object.h>
 
 namespace Urho3D
@@ -38,8 +41,8 @@ public:
     ParticleEffectEditor(Context* context);
     virtual ~ParticleEffectEditor();
 
-    void SetSelectedKey(String key) { selectedKey_ = key; }
-    const String& GetSelectedKey() const { return selectedKey_; }
+    void SetSelectedLayer(LayerHandle layer) { selectedLayer_ = layer; }
+    LayerHandle GetSelectedLayer() const { return selectedLayer_; }
 
     /// Update widget.
     void UpdateWidget();
@@ -49,16 +52,24 @@ protected:
     virtual void HandleUpdateWidget() = 0;
 
     /// Return particle effect.
-    ParticleEffect2D* GetEffect(const String&) const;
+    ParticleEffect2D* GetEffect(LayerHandle) const;
+    /// Return particle effect to modify, cloned first if other layers share it.
+    ParticleEffect2D* GetEffectForEdit(LayerHandle) const;
     /// Return particle emitter.
-    ParticleEmitter2D* GetEmitter(const String&) const;
+    ParticleEmitter2D* GetEmitter(LayerHandle) const;
+    /// Queue parameter change of the selected layer and the other layers edited with it, applied with the next frame.
+    void QueueEdit(EffectParam param, float value) const;
+    /// Queue change of two consecutive parameters of the selected layer.
+    void QueueEdit(EffectParam x, const Vector2& value) const;
+    /// Queue change of four consecutive parameters of the selected layer.
+    void QueueEdit(EffectParam r, const Color& value) const;
 
     /// Is updating widget.
     bool updatingWidget_;
 
 private:
-    /// Key of selected particle node
-    String selectedKey_;
+    /// Selected layer.
+    LayerHandle selectedLayer_;
 };
 
 }
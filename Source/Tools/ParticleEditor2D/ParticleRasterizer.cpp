@@ -0,0 +1,216 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "ParticleRasterizer.h"
+#include "ParticleSimulator.h"
+
+#include <Urho3D/Math/MathDefs.h>
+
+#include <algorithm>
+
+namespace
+{
+// Particles are sampled nearest, larger sprites only cost memory
+const int MAX_SPRITE_SIZE = 64;
+}
+
+namespace Urho3D
+{
+
+ParticleRasterizer::ParticleRasterizer(int width, int height) :
+    width_(width),
+    height_(height),
+    pixels_(width * height, Color::BLACK),
+    spriteWidth_(0),
+    spriteHeight_(0),
+    center_(Vector2::ZERO),
+    scale_(1.0f)
+{
+}
+
+void ParticleRasterizer::SetSprite(const QImage& sprite)
+{
+    sprite_.clear();
+    spriteWidth_ = spriteHeight_ = 0;
+    if (sprite.isNull())
+        return;
+
+    QImage image = sprite;
+    if (image.width() > MAX_SPRITE_SIZE || image.height() > MAX_SPRITE_SIZE)
+        image = image.scaled(MAX_SPRITE_SIZE, MAX_SPRITE_SIZE, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    image = image.convertToFormat(QImage::Format_ARGB32);
+
+    spriteWidth_ = image.width();
+    spriteHeight_ = image.height();
+    sprite_.resize(spriteWidth_ * spriteHeight_);
+    for (int y = 0; y < spriteHeight_; ++y)
+    {
+        const QRgb* line = reinterpret_cast<const QRgb*>(image.constScanLine(y));
+        for (int x = 0; x < spriteWidth_; ++x)
+        {
+            QRgb texel = line[x];
+            sprite_[y * spriteWidth_ + x] = Color(qRed(texel) / 255.0f, qGreen(texel) / 255.0f, qBlue(texel) / 255.0f, qAlpha(texel) / 255.0f);
+        }
+    }
+}
+
+void ParticleRasterizer::SetView(const Vector2& center, float scale)
+{
+    center_ = center;
+    scale_ = scale;
+}
+
+void ParticleRasterizer::FitView(const Vector2& min, const Vector2& max)
+{
+    if (min.x_ > max.x_ || min.y_ > max.y_)
+    {
+        SetView(Vector2::ZERO, 1.0f);
+        return;
+    }
+
+    Vector2 size = max - min;
+    float scale = Min(width_ / Max(size.x_, 1.0f), height_ / Max(size.y_, 1.0f)) * 0.9f;
+    SetView((min + max) * 0.5f, scale);
+}
+
+void ParticleRasterizer::Clear(const Color& color)
+{
+    std::fill(pixels_.begin(), pixels_.end(), color);
+}
+
+void ParticleRasterizer::Draw(const ParticleSimulator& simulator)
+{
+    const BlendMode blendMode = (BlendMode)(int)simulator.GetParams().Get(PARAM_BLEND_MODE);
+
+    for (const SimParticle& particle: simulator.GetParticles())
+    {
+        float size = particle.size_ * scale_;
+        if (size <= 0.0f)
+            continue;
+
+        // Y axis points up in effect space and down in the image
+        float centerX = (particle.position_.x_ - center_.x_) * scale_ + width_ * 0.5f;
+        float centerY = height_ * 0.5f - (particle.position_.y_ - center_.y_) * scale_;
+        float extent = size * 0.7072f;
+
+        int x0 = Max(0, (int)(centerX - extent));
+        int x1 = Min(width_ - 1, (int)(centerX + extent));
+        int y0 = Max(0, (int)(centerY - extent));
+        int y1 = Min(height_ - 1, (int)(centerY + extent));
+        if (x0 > x1 || y0 > y1)
+            continue;
+
+        float cosRotation = Cos(particle.rotation_);
+        float sinRotation = Sin(particle.rotation_);
+        float invSize = 1.0f / size;
+
+        Color tint = particle.color_;
+        tint.r_ = Clamp(tint.r_, 0.0f, 1.0f);
+        tint.g_ = Clamp(tint.g_, 0.0f, 1.0f);
+        tint.b_ = Clamp(tint.b_, 0.0f, 1.0f);
+        tint.a_ = Clamp(tint.a_, 0.0f, 1.0f);
+
+        for (int y = y0; y <= y1; ++y)
+        {
+            float dy = y + 0.5f - centerY;
+            for (int x = x0; x <= x1; ++x)
+            {
+                float dx = x + 0.5f - centerX;
+                float u = (dx * cosRotation - dy * sinRotation) * invSize + 0.5f;
+                float v = (dx * sinRotation + dy * cosRotation) * invSize + 0.5f;
+                if (u < 0.0f || u >= 1.0f || v < 0.0f || v >= 1.0f)
+                    continue;
+
+                Color src = tint;
+                if (!sprite_.empty())
+                {
+                    const Color& texel = sprite_[(int)(v * spriteHeight_) * spriteWidth_ + (int)(u * spriteWidth_)];
+                    src = Color(texel.r_ * tint.r_, texel.g_ * tint.g_, texel.b_ * tint.b_, texel.a_ * tint.a_);
+                }
+
+                Color& dst = pixels_[y * width_ + x];
+                switch (blendMode)
+                {
+                case BLEND_REPLACE:
+                    dst = src;
+                    break;
+                case BLEND_ADD:
+                    dst = Color(dst.r_ + src.r_, dst.g_ + src.g_, dst.b_ + src.b_, dst.a_);
+                    break;
+                case BLEND_MULTIPLY:
+                    dst = Color(dst.r_ * src.r_, dst.g_ * src.g_, dst.b_ * src.b_, dst.a_);
+                    break;
+                case BLEND_ADDALPHA:
+                    dst = Color(dst.r_ + src.r_ * src.a_, dst.g_ + src.g_ * src.a_, dst.b_ + src.b_ * src.a_, dst.a_);
+                    break;
+                case BLEND_PREMULALPHA:
+                    dst = Color(src.r_ + dst.r_ * (1.0f - src.a_), src.g_ + dst.g_ * (1.0f - src.a_), src.b_ + dst.b_ * (1.0f - src.a_), dst.a_);
+                    break;
+                case BLEND_SUBTRACT:
+                    dst = Color(dst.r_ - src.r_, dst.g_ - src.g_, dst.b_ - src.b_, dst.a_);
+                    break;
+                case BLEND_SUBTRACTALPHA:
+                    dst = Color(dst.r_ - src.r_ * src.a_, dst.g_ - src.g_ * src.a_, dst.b_ - src.b_ * src.a_, dst.a_);
+                    break;
+                default:
+                    dst = dst.Lerp(Color(src.r_, src.g_, src.b_, dst.a_), src.a_);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+float ParticleRasterizer::GetDifference(const ParticleRasterizer& other) const
+{
+    if (other.width_ != width_ || other.height_ != height_ || pixels_.empty())
+        return 1.0f;
+
+    float sum = 0.0f;
+    for (unsigned i = 0; i < pixels_.size(); ++i)
+    {
+        const Color& lhs = pixels_[i];
+        const Color& rhs = other.pixels_[i];
+        sum += Abs(Clamp(lhs.r_, 0.0f, 1.0f) - Clamp(rhs.r_, 0.0f, 1.0f));
+        sum += Abs(Clamp(lhs.g_, 0.0f, 1.0f) - Clamp(rhs.g_, 0.0f, 1.0f));
+        sum += Abs(Clamp(lhs.b_, 0.0f, 1.0f) - Clamp(rhs.b_, 0.0f, 1.0f));
+    }
+    return sum / (pixels_.size() * 3);
+}
+
+QImage ParticleRasterizer::GetImage() const
+{
+    QImage image(width_, height_, QImage::Format_RGB32);
+    for (int y = 0; y < height_; ++y)
+    {
+        QRgb* line = reinterpret_cast<QRgb*>(image.scanLine(y));
+        for (int x = 0; x < width_; ++x)
+        {
+            const Color& color = pixels_[y * width_ + x];
+            line[x] = qRgb((int)(Clamp(color.r_, 0.0f, 1.0f) * 255.0f), (int)(Clamp(color.g_, 0.0f, 1.0f) * 255.0f),
+                (int)(Clamp(color.b_, 0.0f, 1.0f) * 255.0f));
+        }
+    }
+    return image;
+}
+
+}
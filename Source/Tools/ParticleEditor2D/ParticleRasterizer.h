@@ -0,0 +1,83 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include <Urho3D/Math/Color.h>
+#include <Urho3D/Math/Vector2.h>
+
+#include <QImage>
+
+#include <vector>
+
+namespace Urho3D
+{
+
+class ParticleSimulator;
+
+/// Software renderer for simulated particles, used for previews and visual comparison.
+class ParticleRasterizer
+{
+public:
+    /// Construct.
+    ParticleRasterizer(int width, int height);
+
+    /// Set particle sprite. A null image draws solid squares.
+    void SetSprite(const QImage& sprite);
+    /// Set view center in pixels of effect space and scale in image pixels per effect pixel.
+    void SetView(const Vector2& center, float scale);
+    /// Center and scale view so the given bounds fit with a small margin.
+    void FitView(const Vector2& min, const Vector2& max);
+    /// Clear to background color.
+    void Clear(const Color& color = Color::BLACK);
+    /// Draw all particles of the simulator with the effect blend mode.
+    void Draw(const ParticleSimulator& simulator);
+
+    /// Return width.
+    int GetWidth() const { return width_; }
+    /// Return height.
+    int GetHeight() const { return height_; }
+    /// Return color buffer, row by row.
+    const std::vector<Color>& GetPixels() const { return pixels_; }
+    /// Return mean absolute color difference to another image of the same size, in [0, 1].
+    float GetDifference(const ParticleRasterizer& other) const;
+    /// Return image.
+    QImage GetImage() const;
+
+private:
+    /// Image size.
+    int width_;
+    int height_;
+    /// Color buffer.
+    std::vector<Color> pixels_;
+    /// Sprite size.
+    int spriteWidth_;
+    int spriteHeight_;
+    /// Sprite texels.
+    std::vector<Color> sprite_;
+    /// View center.
+    Vector2 center_;
+    /// View scale.
+    float scale_;
+};
+
+}
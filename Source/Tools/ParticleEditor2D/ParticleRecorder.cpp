@@ -0,0 +1,107 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "LayerStats.h"
+#include "ParticleEditor.h"
+#include "ParticleRecorder.h"
+
+#include <Urho3D/Scene/Scene.h>
+#include <Urho3D/Scene/SceneEvents.h>
+
+namespace Urho3D
+{
+
+ParticleRecorder::ParticleRecorder(Context* context, Scene* scene) :
+    Object(context),
+    scene_(scene),
+    layer_(INVALID_LAYER)
+{
+}
+
+ParticleRecorder::~ParticleRecorder()
+{
+    writer_.Close();
+}
+
+bool ParticleRecorder::Start(LayerHandle layer, const String& fileName, const ParticleStreamSettings& settings)
+{
+    ParticleEffect2D* effect = ParticleEditor::Get()->GetEffect(layer);
+    if (IsRecording() || !effect || !scene_)
+        return false;
+
+    ReadEffectParams(effect, params_);
+    if (!writer_.Open(fileName, params_, settings))
+        return false;
+
+    layer_ = layer;
+    fileName_ = fileName;
+    SubscribeToEvent(scene_, E_SCENEPOSTUPDATE, URHO3D_HANDLER(ParticleRecorder, HandleScenePostUpdate));
+    return true;
+}
+
+bool ParticleRecorder::Stop()
+{
+    if (!IsRecording())
+        return false;
+
+    UnsubscribeFromEvent(E_SCENEPOSTUPDATE);
+    layer_ = INVALID_LAYER;
+
+    // Waits for the worker to write what is still queued, a few frames at most unless the disk fell behind
+    const bool success = writer_.Close();
+    emit stopped(success);
+    return success;
+}
+
+void ParticleRecorder::Restart(LayerHandle layer)
+{
+    if (IsRecording() && (layer == layer_ || ParticleEditor::Get()->GetCloneSource(layer_) == layer))
+        writer_.Restart();
+}
+
+void ParticleRecorder::HandleScenePostUpdate(StringHash eventType, VariantMap& eventData)
+{
+    using namespace ScenePostUpdate;
+
+    ParticleEditor* editor = ParticleEditor::Get();
+    ParticleEffect2D* effect = editor->GetEffect(layer_);
+    if (!effect)
+    {
+        Stop();
+        return;
+    }
+
+    // Reading the parameters is cheaper than finding out which of undo, edits or a clone source changed them
+    EffectParams params;
+    ReadEffectParams(effect, params);
+    if (params != params_)
+    {
+        params_ = params;
+        writer_.SetParams(params_);
+    }
+
+    const LayerStatsEntry* stats = editor->GetLayerStats()->Get(layer_);
+    writer_.AddFrame(eventData[P_TIMESTEP].GetFloat(), stats ? stats->particles_ : 0);
+}
+
+}
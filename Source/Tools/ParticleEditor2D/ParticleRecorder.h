@@ -0,0 +1,95 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "EffectParams.h"
+#include "LayerTable.h"
+#include "ParticleStream.h"
+
+#include <Urho3D/Container/Ptr.h>
+#include <Urho3D/Core/Object.h>
+
+#include <QObject>
+
+namespace Urho3D
+{
+
+class Scene;
+
+/// Records the simulation of one layer to a particle stream for offline analysis. Emitters keep their particles to
+/// themselves, so every scene update hands its time step, and the layer's parameters when they change, to a stream
+/// writer that replays the effect on a ParticleSimulator in its own thread. Positions are relative to the emitter, in
+/// pixels.
+class ParticleRecorder : public QObject, public Object
+{
+    Q_OBJECT
+    URHO3D_OBJECT(ParticleRecorder, Object)
+
+public:
+    /// Construct.
+    ParticleRecorder(Context* context, Scene* scene);
+    /// Destruct. Finishes a running recording.
+    virtual ~ParticleRecorder();
+
+    /// Start recording layer. Return false if already recording or the file cannot be created.
+    bool Start(LayerHandle layer, const String& fileName, const ParticleStreamSettings& settings);
+    /// Finish writing and close the file. Return false if not recording or anything failed to write.
+    bool Stop();
+    /// Restart the recorded simulation if layer is the recorded one or its clone source.
+    void Restart(LayerHandle layer);
+
+    /// Return whether recording.
+    bool IsRecording() const { return writer_.IsOpen(); }
+    /// Return recorded layer.
+    LayerHandle GetLayer() const { return layer_; }
+    /// Return file name of the recording.
+    const String& GetFileName() const { return fileName_; }
+    /// Return number of written frames.
+    unsigned GetNumFrames() const { return writer_.GetNumFrames(); }
+    /// Return number of frames merged into the next one because writing fell behind.
+    unsigned GetNumDroppedFrames() const { return writer_.GetNumDroppedFrames(); }
+    /// Return written bytes.
+    unsigned long long GetSize() const { return writer_.GetSize(); }
+
+signals:
+    /// Emitted when a recording ends, also when its layer is removed, with whether everything was written.
+    void stopped(bool success);
+
+private:
+    /// Handle scene post update, after the emitters advanced by the same time step.
+    void HandleScenePostUpdate(StringHash eventType, VariantMap& eventData);
+
+    /// Scene.
+    WeakPtr<Scene> scene_;
+    /// Stream writer.
+    ParticleStreamWriter writer_;
+    /// Recorded layer.
+    LayerHandle layer_;
+    /// File name of the recording.
+    String fileName_;
+    /// Parameters last handed to the writer.
+    EffectParams params_;
+};
+
+}
@@ -0,0 +1,212 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "ParticleSimulator.h"
+
+#include <Urho3D/Math/MathDefs.h>
+#include <Urho3D/Urho2D/ParticleEffect2D.h>
+
+namespace Urho3D
+{
+
+ParticleSimulator::ParticleSimulator(const EffectParams& params, unsigned seed) :
+    params_(params),
+    seed_(seed)
+{
+    Reset();
+}
+
+void ParticleSimulator::Reset()
+{
+    particles_.clear();
+    particles_.reserve(Max(1, (int)params_.Get(PARAM_MAX_PARTICLES)));
+    emitParticleTime_ = 0.0f;
+    emissionTime_ = params_.Get(PARAM_DURATION);
+    random_ = seed_;
+}
+
+void ParticleSimulator::Update(float timeStep)
+{
+    unsigned index = 0;
+    while (index < particles_.size())
+    {
+        SimParticle& particle = particles_[index];
+        if (particle.timeToLive_ > 0.0f)
+        {
+            UpdateParticle(particle, timeStep);
+            ++index;
+        }
+        else
+        {
+            particle = particles_.back();
+            particles_.pop_back();
+        }
+    }
+
+    if (emissionTime_ == 0.0f)
+        return;
+
+    const float timeBetweenParticles = params_.Get(PARAM_PARTICLE_LIFESPAN) / Max(1.0f, params_.Get(PARAM_MAX_PARTICLES));
+    if (timeBetweenParticles <= 0.0f)
+        return;
+
+    emitParticleTime_ += timeStep;
+    while (emitParticleTime_ > 0.0f)
+    {
+        if (EmitParticle())
+            UpdateParticle(particles_.back(), emitParticleTime_);
+
+        emitParticleTime_ -= timeBetweenParticles;
+    }
+
+    if (emissionTime_ > 0.0f)
+        emissionTime_ = Max(0.0f, emissionTime_ - timeStep);
+}
+
+void ParticleSimulator::SetParams(const EffectParams& params)
+{
+    params_ = params;
+
+    const unsigned maxParticles = (unsigned)Max(0, (int)params_.Get(PARAM_MAX_PARTICLES));
+    if (particles_.size() > maxParticles)
+        particles_.resize(maxParticles);
+}
+
+void ParticleSimulator::GetBounds(Vector2& min, Vector2& max) const
+{
+    min = Vector2(M_INFINITY, M_INFINITY);
+    max = Vector2(-M_INFINITY, -M_INFINITY);
+    for (const SimParticle& particle: particles_)
+    {
+        float halfSize = particle.size_ * 0.5f;
+        min.x_ = Min(min.x_, particle.position_.x_ - halfSize);
+        min.y_ = Min(min.y_, particle.position_.y_ - halfSize);
+        max.x_ = Max(max.x_, particle.position_.x_ + halfSize);
+        max.y_ = Max(max.y_, particle.position_.y_ + halfSize);
+    }
+}
+
+float ParticleSimulator::Random()
+{
+    // Private LCG, Urho3D's Random() is global and not safe to call from preview workers
+    random_ = random_ * 214013u + 2531011u;
+    return (float)((random_ >> 16) & 0x7fff) / 16383.5f - 1.0f;
+}
+
+bool ParticleSimulator::EmitParticle()
+{
+    if (particles_.size() >= (unsigned)Max(0, (int)params_.Get(PARAM_MAX_PARTICLES)))
+        return false;
+
+    float lifespan = params_.Get(PARAM_PARTICLE_LIFESPAN) + params_.Get(PARAM_PARTICLE_LIFESPAN_VARIANCE) * Random();
+    if (lifespan <= 0.0f)
+        return false;
+
+    float invLifespan = 1.0f / lifespan;
+
+    particles_.push_back(SimParticle());
+    SimParticle& particle = particles_.back();
+    particle.timeToLive_ = lifespan;
+
+    particle.position_.x_ = params_.Get(PARAM_SOURCE_POSITION_VARIANCE_X) * Random();
+    particle.position_.y_ = params_.Get(PARAM_SOURCE_POSITION_VARIANCE_Y) * Random();
+    particle.startPos_ = Vector2::ZERO;
+
+    float angle = params_.Get(PARAM_ANGLE) + params_.Get(PARAM_ANGLE_VARIANCE) * Random();
+    float speed = params_.Get(PARAM_SPEED) + params_.Get(PARAM_SPEED_VARIANCE) * Random();
+    particle.velocity_.x_ = speed * Cos(angle);
+    particle.velocity_.y_ = speed * Sin(angle);
+
+    float maxRadius = Max(0.0f, params_.Get(PARAM_MAX_RADIUS) + params_.Get(PARAM_MAX_RADIUS_VARIANCE) * Random());
+    float minRadius = Max(0.0f, params_.Get(PARAM_MIN_RADIUS) + params_.Get(PARAM_MIN_RADIUS_VARIANCE) * Random());
+    particle.emitRadius_ = maxRadius;
+    particle.emitRadiusDelta_ = (minRadius - maxRadius) * invLifespan;
+    particle.emitRotation_ = params_.Get(PARAM_ANGLE) + params_.Get(PARAM_ANGLE_VARIANCE) * Random();
+    particle.emitRotationDelta_ = params_.Get(PARAM_ROTATE_PER_SECOND) + params_.Get(PARAM_ROTATE_PER_SECOND_VARIANCE) * Random();
+    particle.radialAcceleration_ = params_.Get(PARAM_RADIAL_ACCELERATION) + params_.Get(PARAM_RADIAL_ACCEL_VARIANCE) * Random();
+    particle.tangentialAcceleration_ = params_.Get(PARAM_TANGENTIAL_ACCELERATION) + params_.Get(PARAM_TANGENTIAL_ACCEL_VARIANCE) * Random();
+
+    float startSize = Max(0.1f, params_.Get(PARAM_START_PARTICLE_SIZE) + params_.Get(PARAM_START_PARTICLE_SIZE_VARIANCE) * Random());
+    float finishSize = Max(0.1f, params_.Get(PARAM_FINISH_PARTICLE_SIZE) + params_.Get(PARAM_FINISH_PARTICLE_SIZE_VARIANCE) * Random());
+    particle.size_ = startSize;
+    particle.sizeDelta_ = (finishSize - startSize) * invLifespan;
+
+    particle.color_ = params_.GetColor(PARAM_START_COLOR_R) + params_.GetColor(PARAM_START_COLOR_VARIANCE_R) * Random();
+    Color endColor = params_.GetColor(PARAM_FINISH_COLOR_R) + params_.GetColor(PARAM_FINISH_COLOR_VARIANCE_R) * Random();
+    particle.colorDelta_ = (endColor - particle.color_) * invLifespan;
+
+    particle.rotation_ = params_.Get(PARAM_ROTATION_START) + params_.Get(PARAM_ROTATION_START_VARIANCE) * Random();
+    float endRotation = params_.Get(PARAM_ROTATION_END) + params_.Get(PARAM_ROTATION_END_VARIANCE) * Random();
+    particle.rotationDelta_ = (endRotation - particle.rotation_) * invLifespan;
+
+    return true;
+}
+
+void ParticleSimulator::UpdateParticle(SimParticle& particle, float timeStep)
+{
+    if (timeStep > particle.timeToLive_)
+        timeStep = particle.timeToLive_;
+
+    particle.timeToLive_ -= timeStep;
+
+    if ((int)params_.Get(PARAM_EMITTER_TYPE) == EMITTER_TYPE_RADIAL)
+    {
+        particle.emitRotation_ += particle.emitRotationDelta_ * timeStep;
+        particle.emitRadius_ += particle.emitRadiusDelta_ * timeStep;
+
+        particle.position_.x_ = particle.startPos_.x_ - Cos(particle.emitRotation_) * particle.emitRadius_;
+        particle.position_.y_ = particle.startPos_.y_ + Sin(particle.emitRotation_) * particle.emitRadius_;
+    }
+    else
+    {
+        float distanceX = particle.position_.x_ - particle.startPos_.x_;
+        float distanceY = particle.position_.y_ - particle.startPos_.y_;
+
+        float distanceScalar = Vector2(distanceX, distanceY).Length();
+        if (distanceScalar < 0.0001f)
+            distanceScalar = 0.0001f;
+
+        float radialX = distanceX / distanceScalar;
+        float radialY = distanceY / distanceScalar;
+
+        float tangentialX = radialX;
+        float tangentialY = radialY;
+
+        radialX *= particle.radialAcceleration_;
+        radialY *= particle.radialAcceleration_;
+
+        float newY = tangentialX;
+        tangentialX = -tangentialY * particle.tangentialAcceleration_;
+        tangentialY = newY * particle.tangentialAcceleration_;
+
+        particle.velocity_.x_ += (params_.Get(PARAM_GRAVITY_X) + radialX - tangentialX) * timeStep;
+        particle.velocity_.y_ -= (params_.Get(PARAM_GRAVITY_Y) - radialY + tangentialY) * timeStep;
+        particle.position_.x_ += particle.velocity_.x_ * timeStep;
+        particle.position_.y_ += particle.velocity_.y_ * timeStep;
+    }
+
+    particle.size_ += particle.sizeDelta_ * timeStep;
+    particle.rotation_ += particle.rotationDelta_ * timeStep;
+    particle.color_ += particle.colorDelta_ * timeStep;
+}
+
+}
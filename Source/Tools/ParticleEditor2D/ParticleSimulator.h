@@ -0,0 +1,115 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "EffectParams.h"
+
+#include <vector>
+
+namespace Urho3D
+{
+
+/// Simulated particle, same state as ParticleEmitter2D keeps per particle.
+struct SimParticle
+{
+    /// Time to live.
+    float timeToLive_;
+    /// Position.
+    Vector2 position_;
+    /// Start position.
+    Vector2 startPos_;
+    /// Velocity.
+    Vector2 velocity_;
+    /// Radial acceleration.
+    float radialAcceleration_;
+    /// Tangential acceleration.
+    float tangentialAcceleration_;
+    /// Emit radius.
+    float emitRadius_;
+    /// Emit radius delta.
+    float emitRadiusDelta_;
+    /// Emit rotation.
+    float emitRotation_;
+    /// Emit rotation delta.
+    float emitRotationDelta_;
+    /// Color.
+    Color color_;
+    /// Color delta.
+    Color colorDelta_;
+    /// Size.
+    float size_;
+    /// Size delta.
+    float sizeDelta_;
+    /// Rotation.
+    float rotation_;
+    /// Rotation delta.
+    float rotationDelta_;
+};
+
+/// CPU particle simulation following ParticleEmitter2D, without scene, node or renderer. Units are pixels.
+class ParticleSimulator
+{
+public:
+    /// Construct. The same seed reproduces the same particles.
+    ParticleSimulator(const EffectParams& params, unsigned seed = 1);
+
+    /// Restart emission and remove all particles.
+    void Reset();
+    /// Advance simulation.
+    void Update(float timeStep);
+    /// Change parameters of the running simulation, as an edit of a playing emitter does. Particles over the new limit
+    /// are dropped.
+    void SetParams(const EffectParams& params);
+
+    /// Return parameters.
+    const EffectParams& GetParams() const { return params_; }
+    /// Return live particles.
+    const std::vector<SimParticle>& GetParticles() const { return particles_; }
+    /// Return number of live particles.
+    unsigned GetNumParticles() const { return particles_.size(); }
+    /// Return particle bounds including particle size.
+    void GetBounds(Vector2& min, Vector2& max) const;
+
+private:
+    /// Return random value in [-1, 1].
+    float Random();
+    /// Emit a particle.
+    bool EmitParticle();
+    /// Update a particle.
+    void UpdateParticle(SimParticle& particle, float timeStep);
+
+    /// Parameters.
+    EffectParams params_;
+    /// Live particles.
+    std::vector<SimParticle> particles_;
+    /// Time accumulated for emission.
+    float emitParticleTime_;
+    /// Remaining emission time, negative for infinite.
+    float emissionTime_;
+    /// Seed.
+    unsigned seed_;
+    /// Random state.
+    unsigned random_;
+};
+
+}
@@ -0,0 +1,501 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "ParticleStream.h"
+
+#include <Urho3D/Math/MathDefs.h>
+
+#include <cmath>
+#include <cstring>
+#include <functional>
+
+namespace Urho3D
+{
+
+const char* STREAM_VALUE_NAMES[] = { "speed", "size", "rotation", "ttl" };
+
+/// Format version.
+static const unsigned STREAM_VERSION = 1;
+/// Size of the sliding write window. Dirty pages are written back by the OS, not by the worker.
+static const unsigned long long STREAM_MAP_WINDOW = 64 * 1024 * 1024;
+/// Commands the worker may be behind, two seconds of frames at 60 fps.
+static const unsigned STREAM_MAX_QUEUED_COMMANDS = 120;
+
+/// Return bytes of a frame with the given number of particles.
+static unsigned long long GetFrameSize(unsigned numParticles)
+{
+    return sizeof(ParticleStreamFrame) + (unsigned long long)numParticles * MAX_STREAM_COLUMNS * sizeof(float);
+}
+
+ParticleStreamWriter::ParticleStreamWriter() :
+    simulator_(EffectParams()),
+    map_(nullptr),
+    mapOffset_(0),
+    mapSize_(0),
+    writeOffset_(0),
+    time_(0.0f),
+    frameCounter_(0),
+    closing_(false),
+    numFrames_(0),
+    droppedFrames_(0),
+    size_(0),
+    failed_(false)
+{
+}
+
+ParticleStreamWriter::~ParticleStreamWriter()
+{
+    Close();
+}
+
+bool ParticleStreamWriter::Open(const String& fileName, const EffectParams& params, const ParticleStreamSettings& settings)
+{
+    Close();
+
+    file_.setFileName(QString::fromUtf8(fileName.CString()));
+    if (!file_.open(QIODevice::ReadWrite | QIODevice::Truncate))
+        return false;
+
+    settings_ = settings;
+    settings_.frameStride_ = Max(settings_.frameStride_, 1U);
+    settings_.particleStride_ = Max(settings_.particleStride_, 1U);
+
+    // Written up front with no frame index, so a recording that is never closed can still be read
+    ParticleStreamHeader header;
+    memcpy(header.id_, "PSTR", 4);
+    header.version_ = STREAM_VERSION;
+    header.frameStride_ = settings_.frameStride_;
+    header.particleStride_ = settings_.particleStride_;
+    header.numColumns_ = MAX_STREAM_COLUMNS;
+    header.numFrames_ = 0;
+    header.indexOffset_ = 0;
+    if (file_.write((const char*)&header, sizeof header) != sizeof header)
+    {
+        file_.close();
+        return false;
+    }
+
+    simulator_.SetParams(params);
+    simulator_.Reset();
+    writeOffset_ = sizeof header;
+    frameOffsets_.clear();
+    time_ = 0.0f;
+    frameCounter_ = 0;
+    closing_ = false;
+    numFrames_ = 0;
+    droppedFrames_ = 0;
+    size_ = writeOffset_;
+    failed_ = false;
+
+    thread_ = std::thread(&ParticleStreamWriter::Run, this);
+    return true;
+}
+
+void ParticleStreamWriter::AddFrame(float timeStep, unsigned emitterParticles)
+{
+    Command command;
+    command.type_ = COMMAND_FRAME;
+    command.timeStep_ = timeStep;
+    command.emitterParticles_ = emitterParticles;
+    Push(command);
+}
+
+void ParticleStreamWriter::SetParams(const EffectParams& params)
+{
+    Command command;
+    command.type_ = COMMAND_PARAMS;
+    command.timeStep_ = 0.0f;
+    command.emitterParticles_ = 0;
+    command.params_ = params;
+    Push(command);
+}
+
+void ParticleStreamWriter::Restart()
+{
+    Command command;
+    command.type_ = COMMAND_RESTART;
+    command.timeStep_ = 0.0f;
+    command.emitterParticles_ = 0;
+    Push(command);
+}
+
+bool ParticleStreamWriter::Close()
+{
+    if (!IsOpen())
+        return false;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closing_ = true;
+    }
+    condition_.notify_one();
+    thread_.join();
+
+    // Frame index at the end, then the header is completed in place
+    const unsigned long long indexSize = frameOffsets_.size() * sizeof(unsigned long long);
+    const unsigned long long indexOffset = writeOffset_;
+    if (!frameOffsets_.empty())
+    {
+        if (unsigned char* index = Reserve(indexSize))
+        {
+            memcpy(index, frameOffsets_.data(), indexSize);
+            writeOffset_ += indexSize;
+        }
+        else
+            failed_ = true;
+    }
+    Unmap();
+
+    if (!failed_)
+    {
+        ParticleStreamHeader header;
+        memcpy(header.id_, "PSTR", 4);
+        header.version_ = STREAM_VERSION;
+        header.frameStride_ = settings_.frameStride_;
+        header.particleStride_ = settings_.particleStride_;
+        header.numColumns_ = MAX_STREAM_COLUMNS;
+        header.numFrames_ = frameOffsets_.size();
+        header.indexOffset_ = indexOffset;
+        if (!file_.seek(0) || file_.write((const char*)&header, sizeof header) != sizeof header)
+            failed_ = true;
+    }
+
+    // The file grew a window at a time
+    if (!file_.resize(writeOffset_))
+        failed_ = true;
+    size_ = writeOffset_;
+    file_.close();
+    commands_.clear();
+    frameOffsets_.clear();
+
+    return !failed_;
+}
+
+void ParticleStreamWriter::Push(const Command& command)
+{
+    if (!IsOpen())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        // Keep the simulated time by taking the step together with the last queued one. Parameter changes and
+        // restarts follow user edits and are always queued.
+        if (command.type_ == COMMAND_FRAME && commands_.size() >= STREAM_MAX_QUEUED_COMMANDS &&
+            commands_.back().type_ == COMMAND_FRAME)
+        {
+            commands_.back().timeStep_ += command.timeStep_;
+            commands_.back().emitterParticles_ = command.emitterParticles_;
+            ++droppedFrames_;
+        }
+        else
+            commands_.push_back(command);
+    }
+    condition_.notify_one();
+}
+
+void ParticleStreamWriter::Run()
+{
+    std::vector<Command> commands;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_.wait(lock, [this]() { return closing_ || !commands_.empty(); });
+            if (commands_.empty())
+                break;
+            commands.swap(commands_);
+        }
+
+        for (const Command& command: commands)
+            Process(command);
+        commands.clear();
+    }
+}
+
+void ParticleStreamWriter::Process(const Command& command)
+{
+    switch (command.type_)
+    {
+    case COMMAND_PARAMS:
+        simulator_.SetParams(command.params_);
+        break;
+
+    case COMMAND_RESTART:
+        simulator_.Reset();
+        break;
+
+    case COMMAND_FRAME:
+        if (command.timeStep_ <= 0.0f)
+            break;
+        simulator_.Update(command.timeStep_);
+        time_ += command.timeStep_;
+        if (frameCounter_++ % settings_.frameStride_ == 0 && !failed_)
+            WriteFrame(command.emitterParticles_);
+        break;
+    }
+}
+
+void ParticleStreamWriter::WriteFrame(unsigned emitterParticles)
+{
+    const std::vector<SimParticle>& particles = simulator_.GetParticles();
+    const unsigned stride = settings_.particleStride_;
+    const unsigned numParticles = (particles.size() + stride - 1) / stride;
+    const unsigned long long frameSize = GetFrameSize(numParticles);
+
+    unsigned char* data = Reserve(frameSize);
+    if (!data)
+    {
+        failed_ = true;
+        return;
+    }
+
+    ParticleStreamFrame* frame = (ParticleStreamFrame*)data;
+    frame->time_ = time_;
+    frame->numParticles_ = numParticles;
+    frame->simulatedParticles_ = particles.size();
+    frame->emitterParticles_ = emitterParticles;
+    simulator_.GetBounds(frame->min_, frame->max_);
+
+    // Written straight into the mapping, one column after another
+    float* columns = (float*)(data + sizeof(ParticleStreamFrame));
+    float* positionX = columns + STREAM_POSITION_X * numParticles;
+    float* positionY = columns + STREAM_POSITION_Y * numParticles;
+    float* velocityX = columns + STREAM_VELOCITY_X * numParticles;
+    float* velocityY = columns + STREAM_VELOCITY_Y * numParticles;
+    float* size = columns + STREAM_SIZE * numParticles;
+    float* rotation = columns + STREAM_ROTATION * numParticles;
+    float* timeToLive = columns + STREAM_TIME_TO_LIVE * numParticles;
+    unsigned* color = (unsigned*)(columns + STREAM_COLOR * numParticles);
+    for (unsigned i = 0, j = 0; j < numParticles; i += stride, ++j)
+    {
+        const SimParticle& particle = particles[i];
+        positionX[j] = particle.position_.x_;
+        positionY[j] = particle.position_.y_;
+        velocityX[j] = particle.velocity_.x_;
+        velocityY[j] = particle.velocity_.y_;
+        size[j] = particle.size_;
+        rotation[j] = particle.rotation_;
+        timeToLive[j] = particle.timeToLive_;
+        color[j] = particle.color_.ToUInt();
+    }
+
+    frameOffsets_.push_back(writeOffset_);
+    writeOffset_ += frameSize;
+    numFrames_ = frameOffsets_.size();
+    size_ = writeOffset_;
+}
+
+unsigned char* ParticleStreamWriter::Reserve(unsigned long long size)
+{
+    if (map_ && writeOffset_ + size <= mapOffset_ + mapSize_)
+        return map_ + (writeOffset_ - mapOffset_);
+
+    // Slide the window to the write position, a frame larger than the window gets a window of its own
+    Unmap();
+    mapOffset_ = writeOffset_;
+    mapSize_ = Max(STREAM_MAP_WINDOW, size);
+    if (!file_.resize(mapOffset_ + mapSize_))
+        return nullptr;
+    map_ = file_.map(mapOffset_, mapSize_);
+    return map_;
+}
+
+void ParticleStreamWriter::Unmap()
+{
+    if (map_)
+        file_.unmap(map_);
+    map_ = nullptr;
+    mapSize_ = 0;
+}
+
+ParticleStreamReader::ParticleStreamReader() :
+    data_(nullptr),
+    size_(0)
+{
+    memset(&header_, 0, sizeof header_);
+}
+
+ParticleStreamReader::~ParticleStreamReader()
+{
+    Close();
+}
+
+bool ParticleStreamReader::Open(const String& fileName)
+{
+    Close();
+
+    file_.setFileName(QString::fromUtf8(fileName.CString()));
+    if (!file_.open(QIODevice::ReadOnly))
+        return false;
+
+    size_ = file_.size();
+    data_ = size_ >= sizeof header_ ? file_.map(0, size_) : nullptr;
+    if (!data_)
+    {
+        Close();
+        return false;
+    }
+
+    memcpy(&header_, data_, sizeof header_);
+    if (memcmp(header_.id_, "PSTR", 4) || header_.version_ != STREAM_VERSION || header_.numColumns_ != MAX_STREAM_COLUMNS)
+    {
+        Close();
+        return false;
+    }
+
+    const unsigned long long indexSize = (unsigned long long)header_.numFrames_ * sizeof(unsigned long long);
+    if (header_.indexOffset_ && header_.indexOffset_ + indexSize <= size_)
+    {
+        frameOffsets_.resize(header_.numFrames_);
+        memcpy(frameOffsets_.data(), data_ + header_.indexOffset_, indexSize);
+    }
+    else
+    {
+        // Never closed: walk the frames up to the zeros of the last unwritten window. Time grows every written frame
+        unsigned long long offset = sizeof header_;
+        float lastTime = 0.0f;
+        while (offset + sizeof(ParticleStreamFrame) <= size_)
+        {
+            const ParticleStreamFrame* frame = (const ParticleStreamFrame*)(data_ + offset);
+            const unsigned long long frameSize = GetFrameSize(frame->numParticles_);
+            if (frame->time_ <= lastTime || offset + frameSize > size_)
+                break;
+            frameOffsets_.push_back(offset);
+            lastTime = frame->time_;
+            offset += frameSize;
+        }
+    }
+
+    for (unsigned long long offset: frameOffsets_)
+    {
+        if (offset + sizeof(ParticleStreamFrame) > size_ ||
+            offset + GetFrameSize(((const ParticleStreamFrame*)(data_ + offset))->numParticles_) > size_)
+        {
+            Close();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void ParticleStreamReader::Close()
+{
+    if (data_)
+        file_.unmap(const_cast<unsigned char*>(data_));
+    data_ = nullptr;
+    size_ = 0;
+    file_.close();
+    frameOffsets_.clear();
+}
+
+const ParticleStreamFrame& ParticleStreamReader::GetFrame(unsigned index) const
+{
+    return *(const ParticleStreamFrame*)(data_ + frameOffsets_[index]);
+}
+
+const float* ParticleStreamReader::GetColumn(unsigned index, ParticleStreamColumn column) const
+{
+    const float* columns = (const float*)(data_ + frameOffsets_[index] + sizeof(ParticleStreamFrame));
+    return columns + column * GetFrame(index).numParticles_;
+}
+
+const unsigned* ParticleStreamReader::GetColors(unsigned index) const
+{
+    return (const unsigned*)GetColumn(index, STREAM_COLOR);
+}
+
+float ParticleStreamReader::GetValue(unsigned index, unsigned particle, ParticleStreamValue value) const
+{
+    switch (value)
+    {
+    case STREAM_VALUE_SPEED:
+    {
+        const float x = GetColumn(index, STREAM_VELOCITY_X)[particle];
+        const float y = GetColumn(index, STREAM_VELOCITY_Y)[particle];
+        return sqrtf(x * x + y * y);
+    }
+
+    case STREAM_VALUE_SIZE:
+        return GetColumn(index, STREAM_SIZE)[particle];
+
+    case STREAM_VALUE_ROTATION:
+        return GetColumn(index, STREAM_ROTATION)[particle];
+
+    case STREAM_VALUE_TIME_TO_LIVE:
+        return GetColumn(index, STREAM_TIME_TO_LIVE)[particle];
+
+    default:
+        return 0.0f;
+    }
+}
+
+bool ParticleStreamReader::GetHistogram(ParticleStreamValue value, unsigned numBins, PODVector<unsigned>& counts,
+    float& min, float& max) const
+{
+    // Two passes, range then bins, each reading only the columns of the value
+    auto forEachValue = [&](const std::function<void(float)>& function) {
+        const ParticleStreamColumn column = value == STREAM_VALUE_SPEED ? STREAM_VELOCITY_X :
+            (value == STREAM_VALUE_SIZE ? STREAM_SIZE : (value == STREAM_VALUE_ROTATION ? STREAM_ROTATION : STREAM_TIME_TO_LIVE));
+        for (unsigned i = 0; i < GetNumFrames(); ++i)
+        {
+            const unsigned numParticles = GetFrame(i).numParticles_;
+            const float* x = GetColumn(i, column);
+            if (value == STREAM_VALUE_SPEED)
+            {
+                const float* y = GetColumn(i, STREAM_VELOCITY_Y);
+                for (unsigned j = 0; j < numParticles; ++j)
+                    function(sqrtf(x[j] * x[j] + y[j] * y[j]));
+            }
+            else
+            {
+                for (unsigned j = 0; j < numParticles; ++j)
+                    function(x[j]);
+            }
+        }
+    };
+
+    min = M_INFINITY;
+    max = -M_INFINITY;
+    forEachValue([&](float v) {
+        min = Min(min, v);
+        max = Max(max, v);
+    });
+
+    counts.Resize(Max(numBins, 1U));
+    for (unsigned i = 0; i < counts.Size(); ++i)
+        counts[i] = 0;
+    if (min > max)
+        return false;
+
+    const float scale = max > min ? counts.Size() / (max - min) : 0.0f;
+    const unsigned lastBin = counts.Size() - 1;
+    forEachValue([&](float v) {
+        ++counts[Min((unsigned)((v - min) * scale), lastBin)];
+    });
+
+    return true;
+}
+
+}
@@ -0,0 +1,267 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include "EffectParams.h"
+#include "ParticleSimulator.h"
+
+#include <Urho3D/Container/Str.h>
+#include <Urho3D/Container/Vector.h>
+
+#include <QFile>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Urho3D
+{
+
+/// Per-particle values of a particle stream frame, one column each. Colors are packed RGBA, everything else float.
+enum ParticleStreamColumn
+{
+    STREAM_POSITION_X = 0,
+    STREAM_POSITION_Y,
+    STREAM_VELOCITY_X,
+    STREAM_VELOCITY_Y,
+    STREAM_SIZE,
+    STREAM_ROTATION,
+    STREAM_TIME_TO_LIVE,
+    STREAM_COLOR,
+    MAX_STREAM_COLUMNS
+};
+
+/// Per-particle quantities a particle stream can be queried for.
+enum ParticleStreamValue
+{
+    STREAM_VALUE_SPEED = 0,
+    STREAM_VALUE_SIZE,
+    STREAM_VALUE_ROTATION,
+    STREAM_VALUE_TIME_TO_LIVE,
+    MAX_STREAM_VALUES
+};
+
+/// Value names, indexed by ParticleStreamValue.
+extern const char* STREAM_VALUE_NAMES[];
+
+/// Particle stream file header. Frame count and index offset are zero until the recording is closed.
+struct ParticleStreamHeader
+{
+    /// File identifier, "PSTR".
+    char id_[4];
+    /// Format version.
+    unsigned version_;
+    /// Every how many frames one was written.
+    unsigned frameStride_;
+    /// Every how many particles one was written.
+    unsigned particleStride_;
+    /// Columns per frame.
+    unsigned numColumns_;
+    /// Written frames.
+    unsigned numFrames_;
+    /// Offset of the frame offset table.
+    unsigned long long indexOffset_;
+};
+
+/// Header of one frame, followed by one column of numParticles_ values per ParticleStreamColumn.
+struct ParticleStreamFrame
+{
+    /// Simulated time since recording started, in seconds.
+    float time_;
+    /// Particles stored in the columns.
+    unsigned numParticles_;
+    /// Live particles of the simulation before particle decimation.
+    unsigned simulatedParticles_;
+    /// Live particles of the emitter in the scene, as last counted by LayerStats.
+    unsigned emitterParticles_;
+    /// Bounds of all live particles including their size, in pixels.
+    Vector2 min_;
+    /// Bounds maximum.
+    Vector2 max_;
+};
+
+/// Particle stream decimation.
+struct ParticleStreamSettings
+{
+    /// Write every Nth frame. The simulation still runs every frame.
+    unsigned frameStride_ = 1;
+    /// Write every Nth particle of a written frame. Counts and bounds still cover all.
+    unsigned particleStride_ = 1;
+};
+
+/// Appends the frames of a simulation to a column-oriented stream file through a sliding memory map. The caller only
+/// queues time steps, parameter changes and restarts; a worker thread replays them on a ParticleSimulator and writes
+/// the particles, so a frame costs the caller a lock and a push however many particles are recorded. A worker that
+/// falls behind gets its queued steps merged rather than a growing backlog, so closing never waits long.
+class ParticleStreamWriter
+{
+public:
+    /// Construct.
+    ParticleStreamWriter();
+    /// Destruct. Closes the file.
+    ~ParticleStreamWriter();
+
+    /// Create file and start the worker with the simulation parameters.
+    bool Open(const String& fileName, const EffectParams& params, const ParticleStreamSettings& settings);
+    /// Queue a simulation step.
+    void AddFrame(float timeStep, unsigned emitterParticles);
+    /// Queue a parameter change.
+    void SetParams(const EffectParams& params);
+    /// Queue a restart of the simulation.
+    void Restart();
+    /// Write all queued frames and the frame index, then close. Return false if anything failed to write.
+    bool Close();
+
+    /// Return whether open.
+    bool IsOpen() const { return thread_.joinable(); }
+    /// Return number of written frames.
+    unsigned GetNumFrames() const { return numFrames_; }
+    /// Return number of frames merged into the next one because the worker was behind.
+    unsigned GetNumDroppedFrames() const { return droppedFrames_; }
+    /// Return written bytes.
+    unsigned long long GetSize() const { return size_; }
+
+private:
+    /// Queued work.
+    enum CommandType
+    {
+        COMMAND_FRAME = 0,
+        COMMAND_PARAMS,
+        COMMAND_RESTART
+    };
+
+    /// Queued work item.
+    struct Command
+    {
+        /// Type.
+        CommandType type_;
+        /// Frame time step.
+        float timeStep_;
+        /// Frame emitter particles.
+        unsigned emitterParticles_;
+        /// Parameters of COMMAND_PARAMS.
+        EffectParams params_;
+    };
+
+    /// Queue command and wake the worker. A frame is merged into the last queued one if the queue is full.
+    void Push(const Command& command);
+    /// Worker thread function.
+    void Run();
+    /// Execute command in the worker.
+    void Process(const Command& command);
+    /// Write the current simulation state.
+    void WriteFrame(unsigned emitterParticles);
+    /// Return mapped memory for the next size bytes, growing the file as needed. Null on failure.
+    unsigned char* Reserve(unsigned long long size);
+    /// Unmap the current window.
+    void Unmap();
+
+    /// Decimation.
+    ParticleStreamSettings settings_;
+    /// Replayed simulation, used by the worker only.
+    ParticleSimulator simulator_;
+    /// Stream file, used by the worker only while open.
+    QFile file_;
+    /// Mapped window.
+    unsigned char* map_;
+    /// File offset of the mapped window.
+    unsigned long long mapOffset_;
+    /// Size of the mapped window.
+    unsigned long long mapSize_;
+    /// File offset of the next frame.
+    unsigned long long writeOffset_;
+    /// File offsets of written frames.
+    std::vector<unsigned long long> frameOffsets_;
+    /// Simulated time.
+    float time_;
+    /// Frames simulated, for frame decimation.
+    unsigned frameCounter_;
+    /// Worker thread.
+    std::thread thread_;
+    /// Guards the queue.
+    std::mutex mutex_;
+    /// Signals queued commands.
+    std::condition_variable condition_;
+    /// Commands not taken by the worker yet.
+    std::vector<Command> commands_;
+    /// No more commands follow.
+    bool closing_;
+    /// Written frames.
+    std::atomic<unsigned> numFrames_;
+    /// Frames merged into the next one.
+    std::atomic<unsigned> droppedFrames_;
+    /// Written bytes.
+    std::atomic<unsigned long long> size_;
+    /// A write failed.
+    std::atomic<bool> failed_;
+};
+
+/// Read-only view of a particle stream file, mapped whole so queries touch only the headers and columns they need.
+/// Recordings that were never closed are read up to their last complete frame.
+class ParticleStreamReader
+{
+public:
+    /// Construct.
+    ParticleStreamReader();
+    /// Destruct.
+    ~ParticleStreamReader();
+
+    /// Open and index the file.
+    bool Open(const String& fileName);
+    /// Close the file.
+    void Close();
+
+    /// Return file header.
+    const ParticleStreamHeader& GetHeader() const { return header_; }
+    /// Return number of frames.
+    unsigned GetNumFrames() const { return frameOffsets_.size(); }
+    /// Return frame header.
+    const ParticleStreamFrame& GetFrame(unsigned index) const;
+    /// Return float column of frame.
+    const float* GetColumn(unsigned index, ParticleStreamColumn column) const;
+    /// Return packed colors of frame.
+    const unsigned* GetColors(unsigned index) const;
+    /// Return value of a particle of frame.
+    float GetValue(unsigned index, unsigned particle, ParticleStreamValue value) const;
+    /// Return distribution of value over all frames as counts of equal bins between the smallest and largest value.
+    /// Return false if the stream has no particles.
+    bool GetHistogram(ParticleStreamValue value, unsigned numBins, PODVector<unsigned>& counts, float& min,
+        float& max) const;
+
+private:
+    /// Stream file.
+    QFile file_;
+    /// Mapped file.
+    const unsigned char* data_;
+    /// File size.
+    unsigned long long size_;
+    /// Copy of the file header.
+    ParticleStreamHeader header_;
+    /// File offsets of the frames.
+    std::vector<unsigned long long> frameOffsets_;
+};
+
+}
@@ -0,0 +1,234 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "PexImporter.h"
+#include "SpritePreprocessor.h"
+
+#include <Urho3D/Container/Sort.h>
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Graphics/Texture2D.h>
+#include <Urho3D/IO/File.h>
+#include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Urho2D/ParticleEffect2D.h>
+#include <Urho3D/Urho2D/Sprite2D.h>
+
+#include <QCryptographicHash>
+
+namespace Urho3D
+{
+
+PexImporter::PexImporter(Context* context) :
+    Object(context),
+    shareResources_(false)
+{
+}
+
+SharedPtr<ParticleEffect2D> PexImporter::Import(const String& fileName)
+{
+    File file(context_);
+    if (!file.Open(fileName, FILE_READ))
+    {
+        PexImportIssue issue;
+        issue.fileName_ = fileName;
+        issue.issue_.line_ = 0;
+        issue.issue_.error_ = true;
+        issue.issue_.message_ = "Could not open file";
+        issues_.Push(issue);
+        return SharedPtr<ParticleEffect2D>();
+    }
+
+    buffer_.Resize(file.GetSize());
+    if (!buffer_.Empty())
+        file.Read(&buffer_[0], buffer_.Size());
+
+    return Import(fileName, buffer_.Empty() ? "" : &buffer_[0], buffer_.Size());
+}
+
+SharedPtr<ParticleEffect2D> PexImporter::Import(const String& name, const char* data, unsigned size)
+{
+    EffectParams params;
+    bool parsed = parser_.Parse(data, size, params);
+
+    for (const PexIssue& parserIssue: parser_.GetIssues())
+    {
+        PexImportIssue issue;
+        issue.fileName_ = name;
+        issue.issue_ = parserIssue;
+        issues_.Push(issue);
+
+        if (parserIssue.error_)
+            URHO3D_LOGERROR(name + ":" + String(parserIssue.line_) + ": " + parserIssue.message_);
+        else
+            URHO3D_LOGWARNING(name + ":" + String(parserIssue.line_) + ": " + parserIssue.message_);
+    }
+
+    if (!parsed)
+        return SharedPtr<ParticleEffect2D>();
+
+    SharedPtr<Sprite2D> sprite;
+    if (!params.texture_.Empty())
+        sprite = GetSprite(GetParentPath(name) + params.texture_, params);
+
+    // The texture is identified by the sprite, which is already shared by content
+    params.texture_.Clear();
+    if (shareResources_)
+    {
+        SharedPtr<ParticleEffect2D> shared = FindSharedEffect(params, sprite);
+        if (shared)
+            return shared;
+    }
+
+    SharedPtr<ParticleEffect2D> effect(new ParticleEffect2D(context_));
+    effect->SetName(name);
+    ApplyEffectParams(effect, params);
+    effect->SetSprite(sprite);
+
+    if (shareResources_)
+    {
+        SharedEffect& entry = effectsByContent_[params.ToHash()];
+        entry.params_ = params;
+        entry.sprite_ = sprite;
+        entry.effect_ = effect;
+    }
+
+    return effect;
+}
+
+SharedPtr<Sprite2D> PexImporter::GetSprite(const String& textureFileName, const EffectParams& params)
+{
+    // Preprocessed sprites are cached by source content already
+    if (preprocessor_)
+    {
+        SharedPtr<Sprite2D> sprite = preprocessor_->GetSprite(textureFileName, params);
+        if (sprite)
+            return sprite;
+    }
+
+    ResourceCache* cache = GetSubsystem<ResourceCache>();
+    if (!shareResources_)
+        return SharedPtr<Sprite2D>(cache->GetResource<Sprite2D>(textureFileName));
+
+    SharedPtr<File> file = cache->GetFile(textureFileName, false);
+    if (!file)
+        return SharedPtr<Sprite2D>();
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    char block[16384];
+    while (!file->IsEof())
+    {
+        unsigned read = file->Read(block, sizeof(block));
+        if (!read)
+            break;
+        hash.addData(block, read);
+    }
+    const String digest(hash.result().toHex().constData());
+
+    // Saved effects reference the sprite by file name, so only the texture is shared between different names
+    const String spriteKey = digest + "|" + GetFileNameAndExtension(textureFileName);
+    HashMap<String, WeakPtr<Sprite2D> >::Iterator it = spritesByContent_.Find(spriteKey);
+    if (it != spritesByContent_.End() && it->second_)
+        return SharedPtr<Sprite2D>(it->second_);
+
+    SharedPtr<Sprite2D> sprite;
+    HashMap<String, WeakPtr<Texture2D> >::Iterator textureIt = texturesByContent_.Find(digest);
+    if (textureIt != texturesByContent_.End() && textureIt->second_)
+    {
+        Texture2D* texture = textureIt->second_;
+        sprite = new Sprite2D(context_);
+        sprite->SetName(textureFileName);
+        sprite->SetTexture(texture);
+        sprite->SetRectangle(IntRect(0, 0, texture->GetWidth(), texture->GetHeight()));
+    }
+    else
+    {
+        // Resolve the texture the same way ParticleEffect2D::Load does
+        sprite = cache->GetResource<Sprite2D>(textureFileName);
+        if (!sprite)
+            return sprite;
+        texturesByContent_[digest] = sprite->GetTexture();
+    }
+
+    spritesByContent_[spriteKey] = sprite;
+    return sprite;
+}
+
+SharedPtr<ParticleEffect2D> PexImporter::FindSharedEffect(const EffectParams& params, Sprite2D* sprite) const
+{
+    HashMap<unsigned, SharedEffect>::ConstIterator it = effectsByContent_.Find(params.ToHash());
+    if (it == effectsByContent_.End())
+        return SharedPtr<ParticleEffect2D>();
+
+    const SharedEffect& entry = it->second_;
+    SharedPtr<ParticleEffect2D> effect(entry.effect_);
+    if (!effect || entry.sprite_ != sprite || entry.params_ != params)
+        return SharedPtr<ParticleEffect2D>();
+
+    // Edited effects are cloned before modification, but check the effect was not changed in place
+    EffectParams current;
+    ReadEffectParams(effect, current);
+    current.texture_.Clear();
+    if (current != params || effect->GetSprite() != sprite)
+        return SharedPtr<ParticleEffect2D>();
+
+    return effect;
+}
+
+void PexImporter::SetSpritePreprocessor(SpritePreprocessor* preprocessor)
+{
+    preprocessor_ = preprocessor;
+}
+
+unsigned PexImporter::ImportDirectory(const String& pathName, Vector<SharedPtr<ParticleEffect2D> >& effects)
+{
+    Vector<String> fileNames;
+    GetSubsystem<FileSystem>()->ScanDir(fileNames, pathName, "*.pex", SCAN_FILES, true);
+    Sort(fileNames.Begin(), fileNames.End());
+
+    const String path = AddTrailingSlash(pathName);
+    unsigned imported = 0;
+    for (const String& fileName: fileNames)
+    {
+        SharedPtr<ParticleEffect2D> effect = Import(path + fileName);
+        if (effect)
+        {
+            effects.Push(effect);
+            ++imported;
+        }
+    }
+
+    return imported;
+}
+
+unsigned PexImporter::GetNumErrors() const
+{
+    unsigned errors = 0;
+    for (const PexImportIssue& issue: issues_)
+    {
+        if (issue.issue_.error_)
+            ++errors;
+    }
+    return errors;
+}
+
+}
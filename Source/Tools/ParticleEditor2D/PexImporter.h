@@ -0,0 +1,116 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "PexParser.h"
+
+#include <Urho3D/Container/HashMap.h>
+#include <Urho3D/Container/Ptr.h>
+#include <Urho3D/Core/Object.h>
+
+namespace Urho3D
+{
+
+class ParticleEffect2D;
+class Sprite2D;
+class SpritePreprocessor;
+class Texture2D;
+
+/// Issue found in one imported file.
+struct PexImportIssue
+{
+    /// File name.
+    String fileName_;
+    /// Issue.
+    PexIssue issue_;
+};
+
+/// Imports .pex files into ParticleEffect2D objects through PexParser instead of the XMLFile DOM.
+class PexImporter : public Object
+{
+    URHO3D_OBJECT(PexImporter, Object)
+
+public:
+    /// Construct.
+    PexImporter(Context* context);
+
+    /// Import effect from file. Return null on failure.
+    SharedPtr<ParticleEffect2D> Import(const String& fileName);
+    /// Import effect from file contents already in memory. The name is used to resolve the texture.
+    SharedPtr<ParticleEffect2D> Import(const String& name, const char* data, unsigned size);
+    /// Import all .pex files in a directory and its subdirectories. Return number of imported effects.
+    unsigned ImportDirectory(const String& pathName, Vector<SharedPtr<ParticleEffect2D> >& effects);
+
+    /// Set preprocessor for effect textures. Textures are loaded as is when not set.
+    void SetSpritePreprocessor(SpritePreprocessor* preprocessor);
+    /// Return preprocessor for effect textures.
+    SpritePreprocessor* GetSpritePreprocessor() const { return preprocessor_; }
+
+    /// Set whether effects and textures with identical content are shared between imports.
+    void SetShareResources(bool enable) { shareResources_ = enable; }
+    /// Return whether effects and textures with identical content are shared between imports.
+    bool GetShareResources() const { return shareResources_; }
+
+    /// Return issues collected since the last ClearIssues.
+    const Vector<PexImportIssue>& GetIssues() const { return issues_; }
+    /// Return number of errors collected since the last ClearIssues.
+    unsigned GetNumErrors() const;
+    /// Clear collected issues.
+    void ClearIssues() { issues_.Clear(); }
+
+private:
+    /// Effect that later imports with the same content may share.
+    struct SharedEffect
+    {
+        /// Parameters at import, without texture name.
+        EffectParams params_;
+        /// Sprite at import.
+        WeakPtr<Sprite2D> sprite_;
+        /// Effect.
+        WeakPtr<ParticleEffect2D> effect_;
+    };
+
+    /// Return sprite for texture file, shared with earlier textures of identical content when enabled.
+    SharedPtr<Sprite2D> GetSprite(const String& textureFileName, const EffectParams& params);
+    /// Return earlier effect that still has the given content, or null.
+    SharedPtr<ParticleEffect2D> FindSharedEffect(const EffectParams& params, Sprite2D* sprite) const;
+
+    /// Texture preprocessor.
+    SharedPtr<SpritePreprocessor> preprocessor_;
+    /// Parser, reused between files.
+    PexParser parser_;
+    /// File read buffer, reused between files.
+    PODVector<char> buffer_;
+    /// Issues.
+    Vector<PexImportIssue> issues_;
+    /// Share resources.
+    bool shareResources_;
+    /// Shared textures by content digest.
+    HashMap<String, WeakPtr<Texture2D> > texturesByContent_;
+    /// Shared sprites by texture content digest and file name.
+    HashMap<String, WeakPtr<Sprite2D> > spritesByContent_;
+    /// Shared effects by parameter hash.
+    HashMap<unsigned, SharedEffect> effectsByContent_;
+};
+
+}
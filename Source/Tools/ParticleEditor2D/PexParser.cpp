@@ -0,0 +1,403 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "PexParser.h"
+
+#include <cctype>
+#include <cstring>
+
+namespace
+{
+
+using namespace Urho3D;
+
+const char ROOT_ELEMENT[] = "particleEmitterConfig";
+
+/// Elements Particle Designer writes that Urho3D has no use for.
+const char* ignoredElements[] =
+{
+    "sourcePosition",
+    "yCoordFlipped",
+    "rotationIsDir",
+    "absolutePosition",
+    0
+};
+
+/// Consecutive rows of PEX_ATTRIBUTES that share an element.
+struct PexElement
+{
+    const char* name_;
+    unsigned length_;
+    unsigned first_;
+    unsigned count_;
+};
+
+/// Return elements of PEX_ATTRIBUTES, built once and safe to share between threads.
+const std::vector<PexElement>& GetElements()
+{
+    static const std::vector<PexElement> elements = []() {
+        std::vector<PexElement> result;
+        for (unsigned i = 0; i < NUM_PEX_ATTRIBUTES; ++i)
+        {
+            const char* name = PEX_ATTRIBUTES[i].element_;
+            if (!result.empty() && strcmp(result.back().name_, name) == 0)
+                ++result.back().count_;
+            else
+                result.push_back(PexElement{ name, (unsigned)strlen(name), i, 1 });
+        }
+        return result;
+    }();
+    return elements;
+}
+
+bool Equals(const char* lhs, unsigned lhsLength, const char* rhs, unsigned rhsLength, bool caseSensitive)
+{
+    if (lhsLength != rhsLength)
+        return false;
+    for (unsigned i = 0; i < lhsLength; ++i)
+    {
+        char l = lhs[i];
+        char r = rhs[i];
+        if (!caseSensitive)
+        {
+            l = (char)tolower(l);
+            r = (char)tolower(r);
+        }
+        if (l != r)
+            return false;
+    }
+    return true;
+}
+
+bool Equals(const char* lhs, unsigned lhsLength, const char* rhs)
+{
+    return Equals(lhs, lhsLength, rhs, (unsigned)strlen(rhs), true);
+}
+
+bool IsNameChar(char c)
+{
+    return isalnum((unsigned char)c) || c == '_' || c == '-' || c == ':' || c == '.';
+}
+
+bool IsSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+const char* Find(const char* position, const char* end, const char* token)
+{
+    unsigned length = (unsigned)strlen(token);
+    for (; position + length <= end; ++position)
+    {
+        if (memcmp(position, token, length) == 0)
+            return position;
+    }
+    return end;
+}
+
+}
+
+namespace Urho3D
+{
+
+bool PexParser::Parse(const char* data, unsigned size, EffectParams& params)
+{
+    issues_.Clear();
+    begin_ = data;
+    blendFuncSource_ = -1;
+    blendFuncDestination_ = -1;
+
+    const char* end = data + size;
+    const char* position = data;
+    bool foundRoot = false;
+    bool closedRoot = false;
+
+    while (position < end)
+    {
+        position = (const char*)memchr(position, '<', end - position);
+        if (!position)
+            break;
+
+        element_ = position++;
+
+        // Declarations, processing instructions and comments
+        if (position < end && *position == '?')
+        {
+            position = Find(position, end, "?>");
+            continue;
+        }
+        if (position < end && *position == '!')
+        {
+            if (end - position >= 3 && memcmp(position, "!--", 3) == 0)
+                position = Find(position, end, "-->");
+            else
+                position = Find(position, end, ">");
+            continue;
+        }
+
+        bool closing = position < end && *position == '/';
+        if (closing)
+            ++position;
+
+        const char* name = position;
+        while (position < end && IsNameChar(*position))
+            ++position;
+        unsigned nameLength = (unsigned)(position - name);
+        if (!nameLength)
+        {
+            AddIssue(element_, true, "Malformed tag");
+            position = Find(position, end, ">");
+            continue;
+        }
+
+        if (closing)
+        {
+            if (Equals(name, nameLength, ROOT_ELEMENT))
+                closedRoot = true;
+            position = Find(position, end, ">");
+            continue;
+        }
+
+        // Attributes up to the end of the tag
+        numAttributes_ = 0;
+        bool malformed = false;
+        while (position < end)
+        {
+            while (position < end && IsSpace(*position))
+                ++position;
+            if (position >= end)
+                break;
+            if (*position == '>' || *position == '/')
+                break;
+
+            Attribute attribute;
+            attribute.name_ = position;
+            while (position < end && IsNameChar(*position))
+                ++position;
+            attribute.nameLength_ = (unsigned)(position - attribute.name_);
+
+            while (position < end && IsSpace(*position))
+                ++position;
+            if (!attribute.nameLength_ || position >= end || *position != '=')
+            {
+                malformed = true;
+                break;
+            }
+            ++position;
+            while (position < end && IsSpace(*position))
+                ++position;
+            if (position >= end || (*position != '"' && *position != '\''))
+            {
+                malformed = true;
+                break;
+            }
+
+            const char quote = *position++;
+            attribute.value_ = position;
+            position = (const char*)memchr(position, quote, end - position);
+            if (!position)
+            {
+                position = end;
+                malformed = true;
+                break;
+            }
+            attribute.valueLength_ = (unsigned)(position - attribute.value_);
+            ++position;
+
+            if (numAttributes_ < sizeof(attributes_) / sizeof(attributes_[0]))
+                attributes_[numAttributes_++] = attribute;
+        }
+
+        if (malformed || position >= end)
+        {
+            AddIssue(element_, true, "Malformed element '" + String(name, nameLength) + "'");
+            position = Find(position, end, ">");
+            continue;
+        }
+
+        if (!foundRoot)
+        {
+            if (!Equals(name, nameLength, ROOT_ELEMENT))
+            {
+                AddIssue(element_, true, "Root element is '" + String(name, nameLength) + "', expected '" + ROOT_ELEMENT + "'");
+                return false;
+            }
+            foundRoot = true;
+        }
+        else if (closedRoot)
+            AddIssue(element_, false, "Element '" + String(name, nameLength) + "' after the end of the root element");
+        else
+            HandleElement(name, nameLength, params);
+
+        position = Find(position, end, ">");
+    }
+
+    if (!foundRoot)
+    {
+        AddIssue(end, true, String("Missing '") + ROOT_ELEMENT + "' element");
+        return false;
+    }
+    if (!closedRoot)
+        AddIssue(end, true, String("Unterminated '") + ROOT_ELEMENT + "' element");
+
+    if (blendFuncSource_ >= 0 && blendFuncDestination_ >= 0)
+        params.Set(PARAM_BLEND_MODE, (float)GetBlendModeFromFuncs(blendFuncSource_, blendFuncDestination_));
+
+    // Broken files would otherwise open with defaults in place of what could not be read
+    return !HasErrors();
+}
+
+bool PexParser::HasErrors() const
+{
+    for (const PexIssue& issue: issues_)
+    {
+        if (issue.error_)
+            return true;
+    }
+    return false;
+}
+
+void PexParser::HandleElement(const char* name, unsigned nameLength, EffectParams& params)
+{
+    const char* value;
+    unsigned valueLength;
+    float number;
+
+    if (Equals(name, nameLength, "texture"))
+    {
+        if (FindAttribute("name", value, valueLength))
+            params.texture_ = String(value, valueLength);
+        else
+            AddIssue(element_, true, "Element 'texture' has no 'name' attribute");
+        return;
+    }
+    if (Equals(name, nameLength, "blendFuncSource"))
+    {
+        if (ReadNumber(name, nameLength, "value", number))
+            blendFuncSource_ = (int)number;
+        return;
+    }
+    if (Equals(name, nameLength, "blendFuncDestination"))
+    {
+        if (ReadNumber(name, nameLength, "value", number))
+            blendFuncDestination_ = (int)number;
+        return;
+    }
+
+    const std::vector<PexElement>& elements = GetElements();
+    const PexElement* match = 0;
+    for (const PexElement& element: elements)
+    {
+        if (Equals(name, nameLength, element.name_, element.length_, true))
+        {
+            match = &element;
+            break;
+        }
+    }
+
+    if (!match)
+    {
+        for (const char** ignored = ignoredElements; *ignored; ++ignored)
+        {
+            if (Equals(name, nameLength, *ignored))
+                return;
+        }
+
+        // Exporters disagree on the capitalization of FinishParticleSizeVariance. The value is applied, and saving
+        // writes it under the exact spelling, the only one ParticleEffect2D::Load reads
+        for (const PexElement& element: elements)
+        {
+            if (Equals(name, nameLength, element.name_, element.length_, false))
+            {
+                match = &element;
+                AddIssue(element_, false, "Element '" + String(name, nameLength) + "' should be spelled '" + element.name_ +
+                    "'. Its value was applied; save the effect to write it under the spelling Urho3D reads");
+                break;
+            }
+        }
+    }
+
+    if (!match)
+    {
+        AddIssue(element_, false, "Unknown element '" + String(name, nameLength) + "'");
+        return;
+    }
+
+    for (unsigned i = match->first_; i < match->first_ + match->count_; ++i)
+    {
+        const PexAttribute& attribute = PEX_ATTRIBUTES[i];
+        if (ReadNumber(name, nameLength, attribute.attribute_, number))
+            params.Set(attribute.param_, number);
+    }
+}
+
+bool PexParser::FindAttribute(const char* name, const char*& value, unsigned& valueLength) const
+{
+    for (unsigned i = 0; i < numAttributes_; ++i)
+    {
+        const Attribute& attribute = attributes_[i];
+        if (Equals(attribute.name_, attribute.nameLength_, name))
+        {
+            value = attribute.value_;
+            valueLength = attribute.valueLength_;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool PexParser::ReadNumber(const char* element, unsigned elementLength, const char* attribute, float& result)
+{
+    const char* value;
+    unsigned valueLength;
+    if (!FindAttribute(attribute, value, valueLength))
+    {
+        AddIssue(element_, true, "Element '" + String(element, elementLength) + "' has no '" + attribute + "' attribute");
+        return false;
+    }
+
+    double number;
+    if (!ParseNumber(value, valueLength, number))
+    {
+        AddIssue(element_, true, "Bad number '" + String(value, valueLength) + "' in '" + String(element, elementLength) + "'");
+        return false;
+    }
+
+    result = (float)number;
+    return true;
+}
+
+void PexParser::AddIssue(const char* position, bool error, const String& message)
+{
+    PexIssue issue;
+    issue.line_ = 1;
+    for (const char* c = begin_; c < position; ++c)
+    {
+        if (*c == '\n')
+            ++issue.line_;
+    }
+    issue.error_ = error;
+    issue.message_ = message;
+    issues_.Push(issue);
+}
+
+}
@@ -0,0 +1,91 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "EffectParams.h"
+
+#include <Urho3D/Container/Vector.h>
+
+namespace Urho3D
+{
+
+/// Problem found while parsing a .pex file.
+struct PexIssue
+{
+    /// Line, starting from 1.
+    unsigned line_;
+    /// Is fatal.
+    bool error_;
+    /// Description.
+    String message_;
+};
+
+/// Streaming parser for the flat Particle Designer schema. Reads elements straight into EffectParams without
+/// building a DOM; the only allocations are the texture name and reported issues.
+class PexParser
+{
+public:
+    /// Parse .pex text. Return false if the text is not a particle emitter config or any error was found, e.g. a
+    /// malformed element or an unterminated root. Issues are collected either way.
+    bool Parse(const char* data, unsigned size, EffectParams& params);
+
+    /// Return issues of the last parse.
+    const Vector<PexIssue>& GetIssues() const { return issues_; }
+    /// Return whether the last parse had errors.
+    bool HasErrors() const;
+
+private:
+    /// Attribute name and value ranges inside the parsed text.
+    struct Attribute
+    {
+        const char* name_;
+        unsigned nameLength_;
+        const char* value_;
+        unsigned valueLength_;
+    };
+
+    /// Handle one element with its attributes.
+    void HandleElement(const char* name, unsigned nameLength, EffectParams& params);
+    /// Return attribute value range, or false if missing.
+    bool FindAttribute(const char* name, const char*& value, unsigned& valueLength) const;
+    /// Parse attribute as number, report if missing or malformed.
+    bool ReadNumber(const char* element, unsigned elementLength, const char* attribute, float& result);
+    /// Add issue at position.
+    void AddIssue(const char* position, bool error, const String& message);
+
+    /// Start of text, for line numbers.
+    const char* begin_;
+    /// Start of current element.
+    const char* element_;
+    /// Attributes of current element. No element in the schema has more than four.
+    Attribute attributes_[8];
+    /// Number of attributes of current element.
+    unsigned numAttributes_;
+    /// Blend functions.
+    int blendFuncSource_;
+    int blendFuncDestination_;
+    /// Issues.
+    Vector<PexIssue> issues_;
+};
+
+}
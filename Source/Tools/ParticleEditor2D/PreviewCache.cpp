@@ -0,0 +1,227 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "EffectLibrary.h"
+#include "ParticleRasterizer.h"
+#include "ParticleSimulator.h"
+#include "PreviewCache.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QPainter>
+#include <QPointer>
+#include <QRunnable>
+#include <QStandardPaths>
+#include <QThread>
+
+namespace
+{
+const int PREVIEW_SIZE = 48;
+const int PREVIEW_FRAMES = 16;
+const float PREVIEW_WARMUP = 1.0f;
+const float PREVIEW_DURATION = 2.0f;
+const int PREVIEW_STEPS_PER_FRAME = 8;
+/// Bump when the renderer changes to invalidate previews on disk.
+const char* PREVIEW_VERSION = "1";
+}
+
+namespace Urho3D
+{
+
+/// Loads or renders one preview in a worker thread.
+class PreviewTask : public QRunnable
+{
+public:
+    PreviewTask(PreviewCache* cache, const QString& path, const QString& cacheDir) :
+        cache_(cache),
+        path_(path),
+        cacheDir_(cacheDir)
+    {
+    }
+
+    virtual void run()
+    {
+        QThread::currentThread()->setPriority(QThread::LowestPriority);
+
+        QImage strip = Load();
+        if (!cache_.isNull())
+            QMetaObject::invokeMethod(cache_.data(), "HandleTaskFinished", Qt::QueuedConnection, Q_ARG(QString, path_), Q_ARG(QImage, strip));
+    }
+
+private:
+    QImage Load()
+    {
+        QFile file(path_);
+        if (!file.open(QIODevice::ReadOnly))
+            return QImage();
+
+        QByteArray data = file.readAll();
+        EffectParams params;
+        if (!EffectLibrary::ReadParams(data, params))
+            return QImage();
+
+        QFile textureFile(QFileInfo(path_).absolutePath() + "/" + params.texture_.CString());
+        QByteArray textureData;
+        if (textureFile.open(QIODevice::ReadOnly))
+            textureData = textureFile.readAll();
+
+        QCryptographicHash hash(QCryptographicHash::Md5);
+        hash.addData(QByteArray(PREVIEW_VERSION));
+        hash.addData(data);
+        hash.addData(textureData);
+        QString cachePath = cacheDir_ + "/" + QString::fromLatin1(hash.result().toHex()) + ".png";
+
+        QImage strip;
+        if (strip.load(cachePath))
+            return strip;
+
+        strip = PreviewCache::Render(params, QImage::fromData(textureData));
+        strip.save(cachePath, "PNG");
+        return strip;
+    }
+
+    QPointer<PreviewCache> cache_;
+    QString path_;
+    QString cacheDir_;
+};
+
+PreviewCache::PreviewCache(QObject* parent) :
+    QObject(parent),
+    previews_(64 * 1024),
+    frame_(0)
+{
+    cacheDir_ = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/previews";
+    QDir().mkpath(cacheDir_);
+
+    // Leave a core to the engine frame and GUI
+    pool_.setMaxThreadCount(Max(1, QThread::idealThreadCount() - 1));
+
+    connect(&timer_, &QTimer::timeout, this, [this]() {
+        frame_ = (frame_ + 1) % PREVIEW_FRAMES;
+        emit frameChanged();
+    });
+    timer_.start((int)(PREVIEW_DURATION * 1000.0f / PREVIEW_FRAMES));
+}
+
+PreviewCache::~PreviewCache()
+{
+    pool_.clear();
+    pool_.waitForDone();
+}
+
+void PreviewCache::Request(const QString& path)
+{
+    if (previews_.contains(path) || pending_.contains(path))
+        return;
+
+    pending_.insert(path);
+    pool_.start(new PreviewTask(this, path, cacheDir_));
+}
+
+void PreviewCache::Invalidate(const QString& path)
+{
+    previews_.remove(path);
+}
+
+QPixmap PreviewCache::GetFrame(const QString& path) const
+{
+    QVector<QPixmap>* frames = previews_.object(path);
+    if (!frames || frames->isEmpty())
+        return QPixmap();
+
+    return frames->at(frame_ % frames->size());
+}
+
+void PreviewCache::HandleTaskFinished(const QString& path, const QImage& strip)
+{
+    pending_.remove(path);
+    if (strip.isNull())
+        return;
+
+    // Pixmaps can only be created in the GUI thread
+    int size = strip.height();
+    QVector<QPixmap>* frames = new QVector<QPixmap>();
+    for (int x = 0; x + size <= strip.width(); x += size)
+        frames->push_back(QPixmap::fromImage(strip.copy(x, 0, size, size)));
+
+    previews_.insert(path, frames, strip.width() * strip.height() * 4 / 1024);
+    emit previewReady(path);
+}
+
+QImage PreviewCache::Render(const EffectParams& params, const QImage& sprite)
+{
+    const float timeStep = PREVIEW_DURATION / (PREVIEW_FRAMES * PREVIEW_STEPS_PER_FRAME);
+    const int warmupSteps = (int)(PREVIEW_WARMUP / timeStep);
+
+    // First pass finds the area covered by the whole animation
+    ParticleSimulator simulator(params);
+    for (int i = 0; i < warmupSteps; ++i)
+        simulator.Update(timeStep);
+
+    Vector2 min(M_INFINITY, M_INFINITY);
+    Vector2 max(-M_INFINITY, -M_INFINITY);
+    for (int i = 0; i < PREVIEW_FRAMES * PREVIEW_STEPS_PER_FRAME; ++i) {
+        simulator.Update(timeStep);
+        Vector2 frameMin, frameMax;
+        simulator.GetBounds(frameMin, frameMax);
+        min = Vector2(Min(min.x_, frameMin.x_), Min(min.y_, frameMin.y_));
+        max = Vector2(Max(max.x_, frameMax.x_), Max(max.y_, frameMax.y_));
+    }
+
+    // Second pass replays the same particles and draws them
+    ParticleRasterizer rasterizer(PREVIEW_SIZE, PREVIEW_SIZE);
+    rasterizer.SetSprite(sprite);
+    rasterizer.FitView(min, max);
+
+    QImage strip(PREVIEW_SIZE * PREVIEW_FRAMES, PREVIEW_SIZE, QImage::Format_RGB32);
+    QPainter painter(&strip);
+
+    simulator.Reset();
+    for (int i = 0; i < warmupSteps; ++i)
+        simulator.Update(timeStep);
+
+    for (int frame = 0; frame < PREVIEW_FRAMES; ++frame) {
+        for (int i = 0; i < PREVIEW_STEPS_PER_FRAME; ++i)
+            simulator.Update(timeStep);
+
+        rasterizer.Clear();
+        rasterizer.Draw(simulator);
+        painter.drawImage(frame * PREVIEW_SIZE, 0, rasterizer.GetImage());
+    }
+    painter.end();
+
+    return strip;
+}
+
+int PreviewCache::GetSize()
+{
+    return PREVIEW_SIZE;
+}
+
+int PreviewCache::GetNumFrames()
+{
+    return PREVIEW_FRAMES;
+}
+
+}
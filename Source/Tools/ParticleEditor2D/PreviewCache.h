@@ -0,0 +1,85 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "EffectParams.h"
+
+#include <QCache>
+#include <QImage>
+#include <QObject>
+#include <QPixmap>
+#include <QSet>
+#include <QThreadPool>
+#include <QTimer>
+#include <QVector>
+
+namespace Urho3D
+{
+
+/// Animated previews of .pex files, simulated and rasterized on the CPU by low priority workers and cached on disk
+/// by content hash of the effect and its texture.
+class PreviewCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    PreviewCache(QObject* parent = nullptr);
+    virtual ~PreviewCache();
+
+    /// Request preview of an effect file. Emits previewReady once available.
+    void Request(const QString& path);
+    /// Drop in-memory preview, e.g. after the file was saved.
+    void Invalidate(const QString& path);
+    /// Return current animation frame of the preview, or a null pixmap if not available yet.
+    QPixmap GetFrame(const QString& path) const;
+
+    /// Render preview strip of all animation frames side by side.
+    static QImage Render(const EffectParams& params, const QImage& sprite);
+    /// Return preview size in pixels.
+    static int GetSize();
+    /// Return number of animation frames.
+    static int GetNumFrames();
+
+signals:
+    void previewReady(const QString& path);
+    void frameChanged();
+
+private slots:
+    void HandleTaskFinished(const QString& path, const QImage& strip);
+
+private:
+    /// Worker pool.
+    QThreadPool pool_;
+    /// Loaded previews by file path, cost in KB.
+    QCache<QString, QVector<QPixmap>> previews_;
+    /// Requested but not yet finished paths.
+    QSet<QString> pending_;
+    /// Animation timer.
+    QTimer timer_;
+    /// Current animation frame.
+    int frame_;
+    /// On-disk cache folder.
+    QString cacheDir_;
+};
+
+}
@@ -0,0 +1,167 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "ParticleEditor.h"
+#include "RestartScheduler.h"
+
+#include <Urho3D/Scene/Scene.h>
+#include <Urho3D/Scene/SceneEvents.h>
+
+namespace Urho3D
+{
+
+/// Tick length in milliseconds.
+static const unsigned TICK_MS = 5;
+/// Number of wheel buckets, one revolution is TICK_MS * WHEEL_SIZE milliseconds.
+static const unsigned WHEEL_SIZE = 256;
+
+RestartScheduler::RestartScheduler(Context* context, Scene* scene) :
+    Object(context),
+    buckets_(WHEEL_SIZE),
+    tick_(0),
+    origin_(0),
+    remainder_(0.0f),
+    frame_(0),
+    stamp_(0)
+{
+    SubscribeToEvent(scene, E_SCENEUPDATE, URHO3D_HANDLER(RestartScheduler, HandleSceneUpdate));
+}
+
+void RestartScheduler::SetPeriod(LayerHandle layer, unsigned periodMs)
+{
+    if (!periodMs)
+    {
+        // Bucket items of removed layers are dropped when their bucket comes up
+        entries_.Remove(layer);
+        return;
+    }
+
+    Entry* entry = entries_.Get(layer);
+    if (!entry)
+    {
+        entries_.InsertAt(layer, Entry());
+        entry = entries_.Get(layer);
+    }
+
+    // Next multiple of the period since the origin keeps layers in phase with each other
+    entry->period_ = Max((periodMs + TICK_MS / 2) / TICK_MS, 1U);
+    entry->deadline_ = origin_ + ((tick_ - origin_) / entry->period_ + 1) * entry->period_;
+    Schedule(layer);
+}
+
+void RestartScheduler::AlignPhases()
+{
+    origin_ = tick_;
+    ++frame_;
+
+    std::vector<LayerHandle> layers;
+    entries_.ForEach([&layers](LayerHandle layer, const Entry&) {
+        layers.push_back(layer);
+    });
+
+    for (LayerHandle layer: layers)
+    {
+        Entry* entry = entries_.Get(layer);
+        entry->deadline_ = origin_ + entry->period_;
+        Schedule(layer);
+        Restart(layer);
+    }
+}
+
+void RestartScheduler::Advance(float timeStep)
+{
+    ++frame_;
+    if (!entries_.Size())
+    {
+        // Nothing to restart, keep the clock without visiting buckets
+        const unsigned long long ticks = (unsigned long long)((remainder_ + timeStep * 1000.0f) / TICK_MS);
+        remainder_ += timeStep * 1000.0f - ticks * TICK_MS;
+        tick_ += ticks;
+        return;
+    }
+
+    remainder_ += timeStep * 1000.0f;
+    while (remainder_ >= TICK_MS)
+    {
+        remainder_ -= TICK_MS;
+        ++tick_;
+
+        std::vector<BucketItem>& bucket = buckets_[tick_ % WHEEL_SIZE];
+        if (bucket.empty())
+            continue;
+
+        // Rescheduling may append to the same bucket, so work on a copy
+        processing_.swap(bucket);
+        for (const BucketItem& item: processing_)
+        {
+            Entry* entry = entries_.Get(item.layer_);
+            if (!entry || entry->stamp_ != item.stamp_)
+                continue;
+
+            if (entry->deadline_ > tick_)
+            {
+                // Due in a later revolution
+                bucket.push_back(item);
+                continue;
+            }
+
+            entry->deadline_ += entry->period_;
+            Schedule(item.layer_);
+            Restart(item.layer_);
+        }
+        processing_.clear();
+    }
+}
+
+unsigned RestartScheduler::GetPeriod(LayerHandle layer) const
+{
+    const Entry* entry = entries_.Get(layer);
+    return entry ? (unsigned)entry->period_ * TICK_MS : 0;
+}
+
+void RestartScheduler::HandleSceneUpdate(StringHash eventType, VariantMap& eventData)
+{
+    using namespace SceneUpdate;
+    Advance(eventData[P_TIMESTEP].GetFloat());
+}
+
+void RestartScheduler::Schedule(LayerHandle layer)
+{
+    Entry* entry = entries_.Get(layer);
+    BucketItem item;
+    item.layer_ = layer;
+    item.stamp_ = entry->stamp_ = ++stamp_;
+    buckets_[entry->deadline_ % WHEEL_SIZE].push_back(item);
+}
+
+void RestartScheduler::Restart(LayerHandle layer)
+{
+    // Periods shorter than a frame restart once per frame
+    Entry* entry = entries_.Get(layer);
+    if (entry->lastFrame_ == frame_)
+        return;
+
+    entry->lastFrame_ = frame_;
+    ParticleEditor::Get()->restartEmiter(layer);
+}
+
+}
@@ -0,0 +1,109 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "LayerTable.h"
+
+#include <Urho3D/Core/Object.h>
+
+#include <vector>
+
+namespace Urho3D
+{
+
+class Scene;
+
+/// Restarts layer emitters periodically on the scene clock. Layers wait in a timer wheel of fixed ticks, so a frame
+/// only visits the buckets of the ticks that passed, however many layers are scheduled. Deadlines are multiples of
+/// the period counted from a common origin, so layers with equal or related periods restart in the same frame.
+class RestartScheduler : public Object
+{
+    URHO3D_OBJECT(RestartScheduler, Object)
+
+public:
+    /// Construct and follow the scene clock.
+    RestartScheduler(Context* context, Scene* scene);
+
+    /// Set restart period of layer in milliseconds, zero to stop restarting it.
+    void SetPeriod(LayerHandle layer, unsigned periodMs);
+    /// Stop restarting layer.
+    void Remove(LayerHandle layer) { SetPeriod(layer, 0); }
+    /// Restart every scheduled layer now and count all periods from here.
+    void AlignPhases();
+    /// Advance clock by seconds and restart the layers that became due.
+    void Advance(float timeStep);
+
+    /// Return restart period of layer in milliseconds, zero if not scheduled.
+    unsigned GetPeriod(LayerHandle layer) const;
+    /// Return number of scheduled layers.
+    unsigned GetNumScheduled() const { return entries_.Size(); }
+
+private:
+    /// Handle scene update.
+    void HandleSceneUpdate(StringHash eventType, VariantMap& eventData);
+    /// Put layer into the bucket of its deadline.
+    void Schedule(LayerHandle layer);
+    /// Restart layer once per frame.
+    void Restart(LayerHandle layer);
+
+    /// Scheduled layer.
+    struct Entry
+    {
+        /// Period in ticks.
+        unsigned long long period_ = 0;
+        /// Tick of the next restart.
+        unsigned long long deadline_ = 0;
+        /// Matches the bucket item of the current schedule, older items are dropped.
+        unsigned stamp_ = 0;
+        /// Frame of the last restart.
+        unsigned lastFrame_ = 0;
+    };
+
+    /// Layer waiting in a bucket.
+    struct BucketItem
+    {
+        /// Layer.
+        LayerHandle layer_;
+        /// Entry stamp when scheduled.
+        unsigned stamp_;
+    };
+
+    /// Scheduled layers.
+    LayerTable<Entry> entries_;
+    /// Wheel buckets, indexed by deadline modulo wheel size.
+    std::vector<std::vector<BucketItem> > buckets_;
+    /// Bucket being processed, reused between ticks.
+    std::vector<BucketItem> processing_;
+    /// Elapsed ticks.
+    unsigned long long tick_;
+    /// Tick that all periods are counted from.
+    unsigned long long origin_;
+    /// Time not yet converted to ticks, in milliseconds.
+    float remainder_;
+    /// Frame counter.
+    unsigned frame_;
+    /// Last issued schedule stamp.
+    unsigned stamp_;
+};
+
+}
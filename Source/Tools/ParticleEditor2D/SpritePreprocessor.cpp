@@ -0,0 +1,202 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "SpritePreprocessor.h"
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Graphics/Texture2D.h>
+#include <Urho3D/IO/File.h>
+#include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/Resource/Image.h>
+#include <Urho3D/Urho2D/Sprite2D.h>
+
+#include <QBuffer>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QImageReader>
+#include <QStandardPaths>
+
+namespace
+{
+/// Bump when processing changes to invalidate processed textures on disk.
+const char* SPRITE_VERSION = "1";
+/// Never go below this, tiny textures cost nothing and mip selection needs some texels.
+const int MIN_SPRITE_SIZE = 8;
+}
+
+namespace Urho3D
+{
+
+SpritePreprocessor::SpritePreprocessor(Context* context) :
+    Object(context),
+    enabled_(true),
+    premultiply_(false),
+    scale_(1.0f),
+    sourceMemory_(0),
+    processedMemory_(0)
+{
+    cacheDir_ = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/sprites";
+    QDir().mkpath(cacheDir_);
+}
+
+SharedPtr<Sprite2D> SpritePreprocessor::GetSprite(const String& textureFileName, const EffectParams& params)
+{
+    if (!enabled_)
+        return SharedPtr<Sprite2D>();
+
+    ProcessedSprite processed = Process(textureFileName, params);
+    if (processed.path_.isEmpty())
+        return SharedPtr<Sprite2D>();
+
+    // Saved effects reference the sprite by file name, so only the texture is shared between different names
+    const String path(processed.path_.toUtf8().constData());
+    const String spriteKey = path + "|" + GetFileNameAndExtension(textureFileName);
+    HashMap<String, SharedPtr<Sprite2D> >::Iterator it = sprites_.Find(spriteKey);
+    if (it != sprites_.End())
+        return it->second_;
+
+    SharedPtr<Texture2D> texture;
+    HashMap<String, SharedPtr<Texture2D> >::Iterator textureIt = textures_.Find(path);
+    if (textureIt != textures_.End())
+        texture = textureIt->second_;
+    else
+    {
+        File file(context_);
+        SharedPtr<Image> image(new Image(context_));
+        if (!file.Open(path, FILE_READ) || !image->Load(file))
+            return SharedPtr<Sprite2D>();
+
+        // Processed images are already at the size needed, build the full mip chain for minification
+        texture = new Texture2D(context_);
+        texture->SetName(textureFileName);
+        texture->SetNumLevels(0);
+        if (!texture->SetData(image, true))
+            return SharedPtr<Sprite2D>();
+
+        sourceMemory_ += GetTextureMemory(processed.sourceWidth_, processed.sourceHeight_);
+        processedMemory_ += GetTextureMemory(processed.width_, processed.height_);
+        if (processed.width_ != processed.sourceWidth_ || processed.height_ != processed.sourceHeight_)
+        {
+            URHO3D_LOGINFO("Sprite " + textureFileName + " downscaled from " + String(processed.sourceWidth_) + "x" +
+                String(processed.sourceHeight_) + " to " + String(processed.width_) + "x" + String(processed.height_));
+        }
+
+        textures_[path] = texture;
+    }
+
+    SharedPtr<Sprite2D> sprite(new Sprite2D(context_));
+    sprite->SetName(textureFileName);
+    sprite->SetTexture(texture);
+    sprite->SetRectangle(IntRect(0, 0, texture->GetWidth(), texture->GetHeight()));
+
+    sprites_[spriteKey] = sprite;
+    return sprite;
+}
+
+ProcessedSprite SpritePreprocessor::Process(const String& textureFileName, const EffectParams& params) const
+{
+    ProcessedSprite result;
+    result.sourceWidth_ = result.sourceHeight_ = 0;
+    result.width_ = result.height_ = 0;
+
+    QFile file(QString::fromUtf8(textureFileName.CString()));
+    if (!file.open(QIODevice::ReadOnly))
+        return result;
+    const QByteArray data = file.readAll();
+
+    // Only the header is needed to find the key, decode when the cache misses
+    QBuffer buffer;
+    buffer.setData(data);
+    QImageReader reader(&buffer);
+    const QSize size = reader.size();
+    if (!size.isValid())
+        return result;
+    result.sourceWidth_ = size.width();
+    result.sourceHeight_ = size.height();
+
+    // Smallest power of two that holds the largest particle, never upscaled
+    const int required = NextPowerOfTwo((unsigned)Max(CeilToInt(GetMaxParticleSize(params) * scale_), MIN_SPRITE_SIZE));
+    const int sourceSize = Max(size.width(), size.height());
+    const int targetSize = Min(required, sourceSize);
+    const bool premultiply = premultiply_ && (BlendMode)(int)params.Get(PARAM_BLEND_MODE) == BLEND_PREMULALPHA;
+
+    result.width_ = Max(1, size.width() * targetSize / sourceSize);
+    result.height_ = Max(1, size.height() * targetSize / sourceSize);
+
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    hash.addData(QByteArray(SPRITE_VERSION));
+    hash.addData(data);
+    hash.addData(QByteArray::number(result.width_) + "x" + QByteArray::number(result.height_));
+    hash.addData(QByteArray(premultiply ? "p" : "s"));
+    const QString cachePath = cacheDir_ + "/" + QString::fromLatin1(hash.result().toHex()) + ".png";
+
+    if (!QFileInfo(cachePath).exists())
+    {
+        QImage image = QImage::fromData(data).convertToFormat(QImage::Format_ARGB32);
+        if (image.isNull())
+            return result;
+        if (image.width() != result.width_ || image.height() != result.height_)
+            image = image.scaled(result.width_, result.height_, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+
+        if (premultiply)
+        {
+            // Qt unpremultiplies premultiplied formats on save, so reinterpret the pixels as straight alpha
+            QImage premultiplied = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+            image = QImage(premultiplied.constBits(), premultiplied.width(), premultiplied.height(),
+                premultiplied.bytesPerLine(), QImage::Format_ARGB32).copy();
+        }
+
+        if (!image.save(cachePath, "PNG"))
+            return result;
+    }
+
+    result.path_ = cachePath;
+    return result;
+}
+
+float SpritePreprocessor::GetMaxParticleSize(const EffectParams& params)
+{
+    // Size interpolates linearly from start to finish, so the extremes are at either end
+    float start = params.Get(PARAM_START_PARTICLE_SIZE) + Abs(params.Get(PARAM_START_PARTICLE_SIZE_VARIANCE));
+    float finish = params.Get(PARAM_FINISH_PARTICLE_SIZE) + Abs(params.Get(PARAM_FINISH_PARTICLE_SIZE_VARIANCE));
+    return Max(start, finish);
+}
+
+unsigned SpritePreprocessor::GetTextureMemory(int width, int height)
+{
+    unsigned memory = 0;
+    for (;;)
+    {
+        memory += width * height * 4;
+        if (width == 1 && height == 1)
+            break;
+        width = Max(width / 2, 1);
+        height = Max(height / 2, 1);
+    }
+    return memory;
+}
+
+}
@@ -0,0 +1,111 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "EffectParams.h"
+
+#include <Urho3D/Container/HashMap.h>
+#include <Urho3D/Container/Ptr.h>
+#include <Urho3D/Core/Object.h>
+
+#include <QString>
+
+namespace Urho3D
+{
+
+class Sprite2D;
+class Texture2D;
+
+/// Result of preprocessing one texture.
+struct ProcessedSprite
+{
+    /// Processed image file, empty on failure.
+    QString path_;
+    /// Source image size.
+    int sourceWidth_;
+    int sourceHeight_;
+    /// Processed image size.
+    int width_;
+    int height_;
+};
+
+/// Import step that shrinks effect textures to the largest size a particle can reach on screen, optionally
+/// premultiplies alpha for the premulalpha blend mode, and caches the result on disk by source content hash.
+/// Processed sprites keep the source name, so saved effects still reference the original texture.
+/// Sources with identical content share one processed texture.
+class SpritePreprocessor : public Object
+{
+    URHO3D_OBJECT(SpritePreprocessor, Object)
+
+public:
+    /// Construct.
+    SpritePreprocessor(Context* context);
+
+    /// Set whether textures are processed.
+    void SetEnabled(bool enable) { enabled_ = enable; }
+    /// Set whether premulalpha effects get premultiplied textures.
+    void SetPremultiply(bool enable) { premultiply_ = enable; }
+    /// Set magnification headroom over the particle size in pixels, e.g. 2 to stay sharp at 2x zoom.
+    void SetScale(float scale) { scale_ = scale; }
+
+    /// Return whether textures are processed.
+    bool IsEnabled() const { return enabled_; }
+    /// Return whether premulalpha effects get premultiplied textures.
+    bool GetPremultiply() const { return premultiply_; }
+    /// Return magnification headroom.
+    float GetScale() const { return scale_; }
+
+    /// Return processed sprite for an effect, or null if processing failed or is disabled.
+    SharedPtr<Sprite2D> GetSprite(const String& textureFileName, const EffectParams& params);
+    /// Process texture without creating a GPU resource.
+    ProcessedSprite Process(const String& textureFileName, const EffectParams& params) const;
+
+    /// Return texture memory of the sources of all sprites returned so far, including mip levels.
+    unsigned GetSourceMemory() const { return sourceMemory_; }
+    /// Return texture memory of all sprites returned so far, including mip levels.
+    unsigned GetProcessedMemory() const { return processedMemory_; }
+
+    /// Return largest particle size in pixels.
+    static float GetMaxParticleSize(const EffectParams& params);
+    /// Return texture memory of an RGBA image with a full mip chain.
+    static unsigned GetTextureMemory(int width, int height);
+
+private:
+    /// Processed textures by processed file path.
+    HashMap<String, SharedPtr<Texture2D> > textures_;
+    /// Processed sprites by processed file path and source file name.
+    HashMap<String, SharedPtr<Sprite2D> > sprites_;
+    /// Cache directory.
+    QString cacheDir_;
+    /// Enabled.
+    bool enabled_;
+    /// Premultiply.
+    bool premultiply_;
+    /// Magnification headroom.
+    float scale_;
+    /// Memory statistics.
+    unsigned sourceMemory_;
+    unsigned processedMemory_;
+};
+
+}
@@ -0,0 +1,64 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "StartupTimings.h"
+#include "TraceRecorder.h"
+
+#include <cstdio>
+
+namespace Urho3D
+{
+
+StartupTimings::StartupTimings()
+{
+    start_ = last_ = TraceRecorder::Get().Now();
+}
+
+void StartupTimings::EndStage(const char* name)
+{
+    TraceRecorder& recorder = TraceRecorder::Get();
+    const long long now = recorder.Now();
+    recorder.Add(name, last_, now);
+
+    Stage stage;
+    stage.name_ = name;
+    stage.usec_ = now - last_;
+    stages_.Push(stage);
+    last_ = now;
+}
+
+String StartupTimings::GetReport() const
+{
+    String report;
+    char line[128];
+    for (unsigned i = 0; i < stages_.Size(); ++i)
+    {
+        snprintf(line, sizeof line, "%s: %.1f ms\n", stages_[i].name_, stages_[i].usec_ / 1000.0f);
+        report += line;
+    }
+    snprintf(line, sizeof line, "Total: %.1f ms", GetTotalUSec() / 1000.0f);
+    report += line;
+    return report;
+}
+
+}
@@ -0,0 +1,66 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <Urho3D/Container/Str.h>
+#include <Urho3D/Container/Vector.h>
+
+namespace Urho3D
+{
+
+/// Duration of each startup stage, measured from construction. Stages are also added to the trace recorder.
+class StartupTimings
+{
+public:
+    /// Startup stage.
+    struct Stage
+    {
+        /// Stage name, a string literal.
+        const char* name_;
+        /// Duration in microseconds.
+        long long usec_;
+    };
+
+    /// Construct and start timing the first stage.
+    StartupTimings();
+
+    /// End current stage under name and start the next one.
+    void EndStage(const char* name);
+    /// Return stages in order.
+    const PODVector<Stage>& GetStages() const { return stages_; }
+    /// Return microseconds from construction to the end of the last stage.
+    long long GetTotalUSec() const { return last_ - start_; }
+    /// Return one line per stage followed by the total.
+    String GetReport() const;
+
+private:
+    /// Finished stages.
+    PODVector<Stage> stages_;
+    /// Trace time of construction.
+    long long start_;
+    /// Trace time the current stage started.
+    long long last_;
+};
+
+}
@@ -0,0 +1,297 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "EffectMemory.h"
+#include "EffectParams.h"
+#include "LayerStats.h"
+#include "ParticleClone2D.h"
+#include "ParticleEditor.h"
+#include "StressGrid.h"
+#include "TraceRecorder.h"
+
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Core/Timer.h>
+#include <Urho3D/Graphics/Graphics.h>
+#include <Urho3D/Graphics/Renderer.h>
+#include <Urho3D/Graphics/Texture2D.h>
+#include <Urho3D/Scene/Scene.h>
+#include <Urho3D/Urho2D/Drawable2D.h>
+#include <Urho3D/Urho2D/ParticleEffect2D.h>
+#include <Urho3D/Urho2D/ParticleEmitter2D.h>
+#include <Urho3D/Urho2D/Sprite2D.h>
+
+#include <cmath>
+#include <cstdio>
+
+namespace Urho3D
+{
+
+/// Time per frame spent creating instances, in microseconds.
+static const long long GROW_BUDGET_USEC = 8000;
+
+/// Return string with JSON special characters escaped.
+static String EscapeJson(const String& value)
+{
+    String result;
+    for (unsigned i = 0; i < value.Length(); ++i)
+    {
+        if (value[i] == '"' || value[i] == '\\')
+            result += '\\';
+        result += value[i];
+    }
+    return result;
+}
+
+StressGrid::StressGrid(Context* context, Scene* scene) :
+    Object(context),
+    scene_(scene),
+    state_(STATE_IDLE),
+    step_(0),
+    instances_(0),
+    warmupLeft_(0),
+    frames_(0),
+    totalUSec_(0),
+    maxUSec_(0),
+    totalBatches_(0)
+{
+}
+
+StressGrid::~StressGrid()
+{
+    if (root_)
+        root_->Remove();
+}
+
+bool StressGrid::Start(ParticleEffect2D* effect, const StressGridSettings& settings)
+{
+    const unsigned total = settings.columns_ * settings.rows_;
+    if (IsRunning() || !effect || !scene_ || !total || !settings.steps_ || !settings.measureFrames_)
+        return false;
+
+    effect_ = effect;
+    effectName_ = effect->GetName();
+    settings_ = settings;
+    samples_.Clear();
+
+    // Geometric spacing keeps the small counts, where the curve usually bends, well sampled
+    steps_.Clear();
+    for (unsigned i = 0; i < settings.steps_; ++i)
+    {
+        const float t = settings.steps_ > 1 ? (float)i / (settings.steps_ - 1) : 1.0f;
+        const unsigned count = Clamp((unsigned)(powf((float)total, t) + 0.5f), 1u, total);
+        if (steps_.Empty() || count > steps_.Back())
+            steps_.Push(count);
+    }
+
+    // Layers would add their own cost to every sample. Clones too, they copy the vertices of their source each frame.
+    hiddenNodes_.Clear();
+    const Vector<SharedPtr<Node> >& children = scene_->GetChildren();
+    for (unsigned i = 0; i < children.Size(); ++i)
+    {
+        Node* node = children[i];
+        if (node->IsEnabled() && (node->GetComponent<ParticleEmitter2D>() || node->GetComponent<ParticleClone2D>()))
+        {
+            node->SetEnabled(false);
+            hiddenNodes_.Push(WeakPtr<Node>(node));
+        }
+    }
+
+    root_ = scene_->CreateChild("StressGrid", LOCAL);
+    instances_ = 0;
+    step_ = 0;
+    state_ = STATE_GROWING;
+    return true;
+}
+
+void StressGrid::Stop()
+{
+    if (!IsRunning())
+        return;
+
+    state_ = STATE_IDLE;
+    root_->Remove();
+    root_.Reset();
+    effect_.Reset();
+    instances_ = 0;
+
+    for (unsigned i = 0; i < hiddenNodes_.Size(); ++i)
+    {
+        if (hiddenNodes_[i])
+            hiddenNodes_[i]->SetEnabled(true);
+    }
+    hiddenNodes_.Clear();
+
+    emit finished();
+}
+
+void StressGrid::AddFrame(long long usec)
+{
+    switch (state_)
+    {
+    case STATE_IDLE:
+        return;
+
+    case STATE_GROWING:
+        if (Grow())
+        {
+            warmupLeft_ = settings_.warmupFrames_;
+            state_ = STATE_WARMUP;
+        }
+        return;
+
+    case STATE_WARMUP:
+        // The frame that follows growing still pays for the new instances, so it is never measured
+        if (warmupLeft_)
+        {
+            --warmupLeft_;
+            return;
+        }
+        frames_ = 0;
+        totalUSec_ = 0;
+        maxUSec_ = 0;
+        totalBatches_ = 0;
+        state_ = STATE_MEASURE;
+        return;
+
+    case STATE_MEASURE:
+        ++frames_;
+        totalUSec_ += usec;
+        maxUSec_ = Max(maxUSec_, usec);
+        totalBatches_ += GetSubsystem<Renderer>()->GetNumBatches();
+        if (frames_ < settings_.measureFrames_)
+            return;
+
+        Sample();
+        if (++step_ < steps_.Size())
+            state_ = STATE_GROWING;
+        else
+            Stop();
+        return;
+    }
+}
+
+bool StressGrid::Grow()
+{
+    EDITOR_TRACE("StressGrid::Grow");
+
+    // Row-major from the top left, centered on the origin
+    const unsigned target = steps_[step_];
+    const float left = -0.5f * (settings_.columns_ - 1) * settings_.spacing_;
+    const float top = 0.5f * (settings_.rows_ - 1) * settings_.spacing_;
+
+    HiresTimer timer;
+    while (instances_ < target && timer.GetUSec(false) < GROW_BUDGET_USEC)
+    {
+        const unsigned column = instances_ % settings_.columns_;
+        const unsigned row = instances_ / settings_.columns_;
+        Node* node = root_->CreateChild(String::EMPTY, LOCAL);
+        node->SetPosition2D(Vector2(left + column * settings_.spacing_, top - row * settings_.spacing_));
+        node->CreateComponent<ParticleEmitter2D>(LOCAL)->SetEffect(effect_);
+        ++instances_;
+    }
+    return instances_ == target;
+}
+
+void StressGrid::Sample()
+{
+    StressSample sample;
+    sample.instances_ = instances_;
+    sample.avgFrameMSec_ = totalUSec_ / 1000.0f / frames_;
+    sample.maxFrameMSec_ = maxUSec_ / 1000.0f;
+    sample.updateMSec_ = ParticleEditor::Get()->GetLayerStats()->GetSceneUpdateUSec() / 1000.0f;
+    sample.batches_ = (float)totalBatches_ / frames_;
+    sample.particles_ = 0;
+
+    // Same accounting as LayerStats, with the shared effect and texture counted once
+    sample.memory_ = sizeof(ParticleEffect2D);
+    const Sprite2D* sprite = effect_->GetSprite();
+    if (const Texture2D* texture = sprite ? sprite->GetTexture() : nullptr)
+        sample.memory_ += texture->GetMemoryUse();
+
+    const Vector<SharedPtr<Node> >& children = root_->GetChildren();
+    for (unsigned i = 0; i < children.Size(); ++i)
+    {
+        ParticleEmitter2D* emitter = children[i]->GetComponent<ParticleEmitter2D>();
+        sample.memory_ += sizeof(Node) + sizeof(ParticleEmitter2D) + GetParticleArrayMemory(emitter->GetMaxParticles());
+
+        const Vector<SourceBatch2D>& batches = emitter->GetSourceBatches();
+        for (unsigned j = 0; j < batches.Size(); ++j)
+        {
+            sample.particles_ += batches[j].vertices_.Size() / 4;
+            sample.memory_ += GetVertexArrayMemory(batches[j].vertices_.Capacity());
+        }
+    }
+
+    samples_.Push(sample);
+    emit sampled();
+}
+
+bool StressGrid::SaveCsv(const String& fileName) const
+{
+    FILE* file = fopen(fileName.CString(), "wb");
+    if (!file)
+        return false;
+
+    fputs("instances,avg_frame_ms,max_frame_ms,update_ms,batches,particles,memory_bytes\n", file);
+    for (unsigned i = 0; i < samples_.Size(); ++i)
+    {
+        const StressSample& sample = samples_[i];
+        fprintf(file, "%u,%s,%s,%s,%s,%u,%llu\n", sample.instances_, FormatNumber(sample.avgFrameMSec_, 'f', 3).CString(),
+            FormatNumber(sample.maxFrameMSec_, 'f', 3).CString(), FormatNumber(sample.updateMSec_, 'f', 3).CString(),
+            FormatNumber(sample.batches_, 'f', 1).CString(), sample.particles_, sample.memory_);
+    }
+
+    return fclose(file) == 0;
+}
+
+bool StressGrid::SaveJson(const String& fileName) const
+{
+    FILE* file = fopen(fileName.CString(), "wb");
+    if (!file)
+        return false;
+
+    // Results only compare on the same machine and backbuffer, so both are recorded
+    Graphics* graphics = GetSubsystem<Graphics>();
+    fprintf(file, "{\n\"effect\":\"%s\",\n", EscapeJson(effectName_).CString());
+    fprintf(file, "\"grid\":{\"columns\":%u,\"rows\":%u,\"spacing\":%s,\"warmupFrames\":%u,\"measureFrames\":%u},\n",
+        settings_.columns_, settings_.rows_, FormatNumber(settings_.spacing_, 'g', 6).CString(), settings_.warmupFrames_,
+        settings_.measureFrames_);
+    fprintf(file, "\"machine\":{\"platform\":\"%s\",\"cpus\":%u,\"graphicsApi\":\"%s\",\"width\":%d,\"height\":%d},\n",
+        EscapeJson(GetPlatform()).CString(), GetNumPhysicalCPUs(), EscapeJson(Graphics::GetApiName()).CString(),
+        graphics->GetWidth(), graphics->GetHeight());
+
+    fputs("\"samples\":[\n", file);
+    for (unsigned i = 0; i < samples_.Size(); ++i)
+    {
+        const StressSample& sample = samples_[i];
+        fprintf(file, "%s{\"instances\":%u,\"avgFrameMs\":%s,\"maxFrameMs\":%s,\"updateMs\":%s,\"batches\":%s,"
+            "\"particles\":%u,\"memoryBytes\":%llu}", i ? ",\n" : "", sample.instances_,
+            FormatNumber(sample.avgFrameMSec_, 'f', 3).CString(), FormatNumber(sample.maxFrameMSec_, 'f', 3).CString(),
+            FormatNumber(sample.updateMSec_, 'f', 3).CString(), FormatNumber(sample.batches_, 'f', 1).CString(),
+            sample.particles_, sample.memory_);
+    }
+    fputs("\n]}\n", file);
+
+    return fclose(file) == 0;
+}
+
+}
@@ -0,0 +1,167 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <Urho3D/Container/Ptr.h>
+#include <Urho3D/Container/Vector.h>
+#include <Urho3D/Core/Object.h>
+
+#include <QObject>
+
+namespace Urho3D
+{
+
+class Node;
+class ParticleEffect2D;
+class Scene;
+
+/// Stress grid settings.
+struct StressGridSettings
+{
+    /// Grid columns.
+    unsigned columns_ = 10;
+    /// Grid rows.
+    unsigned rows_ = 10;
+    /// Distance between instances in world units.
+    float spacing_ = 2.0f;
+    /// Number of instance counts measured, spaced geometrically up to the whole grid.
+    unsigned steps_ = 10;
+    /// Frames rendered after reaching an instance count before measuring, so emitters reach steady state.
+    unsigned warmupFrames_ = 60;
+    /// Frames measured per instance count.
+    unsigned measureFrames_ = 60;
+};
+
+/// Measurement at one instance count.
+struct StressSample
+{
+    /// Emitter instances.
+    unsigned instances_;
+    /// Average frame time in milliseconds.
+    float avgFrameMSec_;
+    /// Longest frame time in milliseconds.
+    float maxFrameMSec_;
+    /// Scene update time in milliseconds, as sampled by LayerStats.
+    float updateMSec_;
+    /// Average draw calls per frame.
+    float batches_;
+    /// Live particles in the last measured frame.
+    unsigned particles_;
+    /// Estimated bytes of all instances, effect and texture counted once.
+    unsigned long long memory_;
+};
+
+/// Instantiates one effect in a grid at growing instance counts and measures how frame time, draw calls and memory
+/// scale, to find where the cost curve of an effect bends on a machine. Instances are plain scene nodes sharing the
+/// effect, not layers, and the layers are hidden while the grid runs.
+class StressGrid : public QObject, public Object
+{
+    Q_OBJECT
+    URHO3D_OBJECT(StressGrid, Object)
+
+public:
+    /// Construct.
+    StressGrid(Context* context, Scene* scene);
+    /// Destruct.
+    virtual ~StressGrid();
+
+    /// Start measuring effect. Return false if already running or the grid is empty.
+    bool Start(ParticleEffect2D* effect, const StressGridSettings& settings);
+    /// Stop, remove the instances and show the layers again. Samples taken so far are kept.
+    void Stop();
+    /// Advance after a rendered frame that took usec.
+    void AddFrame(long long usec);
+
+    /// Return whether running.
+    bool IsRunning() const { return state_ != STATE_IDLE; }
+    /// Return settings of the last run.
+    const StressGridSettings& GetSettings() const { return settings_; }
+    /// Return instance counts of the last run.
+    const PODVector<unsigned>& GetSteps() const { return steps_; }
+    /// Return measurements of the last run.
+    const PODVector<StressSample>& GetSamples() const { return samples_; }
+    /// Return name of the measured effect.
+    const String& GetEffectName() const { return effectName_; }
+
+    /// Write measurements as CSV. Return true on success.
+    bool SaveCsv(const String& fileName) const;
+    /// Write settings, machine and measurements as JSON. Return true on success.
+    bool SaveJson(const String& fileName) const;
+
+signals:
+    /// Emitted after every measured instance count.
+    void sampled();
+    /// Emitted when the last instance count is measured or the run is stopped.
+    void finished();
+
+private:
+    /// Run state.
+    enum State
+    {
+        STATE_IDLE = 0,
+        STATE_GROWING,
+        STATE_WARMUP,
+        STATE_MEASURE
+    };
+
+    /// Create instances up to the current step within the frame budget. Return true when done.
+    bool Grow();
+    /// Finish measuring the current step.
+    void Sample();
+
+    /// Scene.
+    WeakPtr<Scene> scene_;
+    /// Parent of all instances.
+    SharedPtr<Node> root_;
+    /// Measured effect.
+    SharedPtr<ParticleEffect2D> effect_;
+    /// Effect resource name.
+    String effectName_;
+    /// Layer nodes hidden during the run.
+    Vector<WeakPtr<Node> > hiddenNodes_;
+    /// Settings.
+    StressGridSettings settings_;
+    /// Instance counts to measure.
+    PODVector<unsigned> steps_;
+    /// Measurements.
+    PODVector<StressSample> samples_;
+    /// Run state.
+    State state_;
+    /// Index of the current step.
+    unsigned step_;
+    /// Instances created.
+    unsigned instances_;
+    /// Frames left in the warmup.
+    unsigned warmupLeft_;
+    /// Measured frames of the current step.
+    unsigned frames_;
+    /// Sum of measured frame times.
+    long long totalUSec_;
+    /// Longest measured frame time.
+    long long maxUSec_;
+    /// Sum of draw calls of measured frames.
+    unsigned long long totalBatches_;
+};
+
+}
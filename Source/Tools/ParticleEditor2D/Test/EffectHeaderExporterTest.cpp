@@ -0,0 +1,139 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "EffectParams.h"
+#include "ExportedEffects.h"
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/Core/ProcessUtils.h>
+#include <Urho3D/Engine/Engine.h>
+#include <Urho3D/Engine/EngineDefs.h>
+#include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/Resource/ResourceCache.h>
+#include <Urho3D/Resource/XMLFile.h>
+#include <Urho3D/Urho2D/ParticleEffect2D.h>
+
+#include <cstring>
+
+using namespace Urho3D;
+
+/// Return whether two floats have the same bits.
+static bool SameBits(float a, float b)
+{
+    return memcmp(&a, &b, sizeof(float)) == 0;
+}
+
+/// Load effect the way a game does without the header. Return params, or false if the effect does not load.
+static bool LoadSourceParams(ResourceCache* cache, const String& resourceName, EffectParams& params)
+{
+    ParticleEffect2D* effect = cache->GetResource<ParticleEffect2D>(resourceName);
+    if (!effect)
+        return false;
+    ReadEffectParams(effect, params);
+
+    // PexImporter applies the miscased tag some exporters write, ParticleEffect2D ignores it
+    XMLElement root = cache->GetResource<XMLFile>(resourceName)->GetRoot();
+    XMLElement miscased = root.GetChild("FinishParticleSizeVariance");
+    if (miscased && !root.GetChild("finishParticleSizeVariance"))
+        params.Set(PARAM_FINISH_PARTICLE_SIZE_VARIANCE, miscased.GetFloat("value"));
+
+    return true;
+}
+
+/// Compare generated effect with the source. Return number of mismatches, each printed.
+static unsigned CompareEffect(Context* context, const String& resourceDir, const ExportedEffects::EffectData& data)
+{
+    const String resourceName = resourceDir + data.file;
+    EffectParams expected;
+    if (!LoadSourceParams(context->GetSubsystem<ResourceCache>(), resourceName, expected))
+    {
+        PrintLine(resourceName + ": could not load source effect", true);
+        return 1;
+    }
+
+    SharedPtr<ParticleEffect2D> effect = ExportedEffects::CreateEffect(context, data, GetPath(resourceName));
+    EffectParams generated;
+    ReadEffectParams(effect, generated);
+
+    unsigned mismatches = 0;
+    if (generated.texture_ != expected.texture_ || !effect->GetSprite())
+    {
+        PrintLine(resourceName + ": texture " + generated.texture_ + ", expected " + expected.texture_, true);
+        ++mismatches;
+    }
+    for (unsigned i = 0; i < MAX_EFFECT_PARAMS; ++i)
+    {
+        if (!SameBits(generated.values_[i], expected.values_[i]))
+        {
+            PrintLine(resourceName + ": " + GetEffectParamName((EffectParam)i) + " " + String(generated.values_[i]) +
+                ", expected " + String(expected.values_[i]), true);
+            ++mismatches;
+        }
+    }
+
+    // Lifetime tables start and end at the effect's own values
+    const unsigned last = ExportedEffects::LIFETIME_SAMPLES - 1;
+    const Color startColor = expected.GetColor(PARAM_START_COLOR_R);
+    const Color finishColor = expected.GetColor(PARAM_FINISH_COLOR_R);
+    if (!SameBits(data.size[0], expected.Get(PARAM_START_PARTICLE_SIZE)) ||
+        !SameBits(data.size[last], expected.Get(PARAM_FINISH_PARTICLE_SIZE)) ||
+        !SameBits(data.rotation[0], expected.Get(PARAM_ROTATION_START)) ||
+        !SameBits(data.rotation[last], expected.Get(PARAM_ROTATION_END)) ||
+        Color(data.color[0][0], data.color[0][1], data.color[0][2], data.color[0][3]) != startColor ||
+        Color(data.color[last][0], data.color[last][1], data.color[last][2], data.color[last][3]) != finishColor)
+    {
+        PrintLine(resourceName + ": lifetime tables do not match start and finish values", true);
+        ++mismatches;
+    }
+
+    return mismatches;
+}
+
+int main(int argc, char** argv)
+{
+    // Resource directory the header was exported from, e.g. Urho2D/
+    const String resourceDir = AddTrailingSlash(argc > 1 ? String(argv[1]) : String("Urho2D"));
+
+    SharedPtr<Context> context(new Context());
+    SharedPtr<Engine> engine(new Engine(context));
+
+    VariantMap engineParameters;
+    engineParameters[EP_HEADLESS] = true;
+    engineParameters[EP_RESOURCE_PATHS] = "CoreData;Data";
+    engineParameters[EP_LOG_NAME] = String::EMPTY;
+    engineParameters[EP_LOG_QUIET] = true;
+    if (!engine->Initialize(engineParameters))
+        return 1;
+
+    if (ExportedEffects::NUM_EFFECTS == 0)
+    {
+        PrintLine("No effects exported", true);
+        return 1;
+    }
+
+    unsigned mismatches = 0;
+    for (unsigned i = 0; i < ExportedEffects::NUM_EFFECTS; ++i)
+        mismatches += CompareEffect(context, resourceDir, *ExportedEffects::EFFECTS[i]);
+
+    PrintLine(String(ExportedEffects::NUM_EFFECTS) + " effects, " + String(mismatches) + " mismatches");
+    return mismatches ? 1 : 0;
+}
@@ -0,0 +1,122 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "TraceRecorder.h"
+
+#include <Urho3D/Core/Profiler.h>
+#include <Urho3D/Core/Thread.h>
+
+#include <cstdio>
+
+namespace Urho3D
+{
+
+/// Number of events kept, about ten seconds of a busy editor at 60 frames per second.
+static const unsigned TRACE_CAPACITY = 64 * 1024;
+
+TraceRecorder& TraceRecorder::Get()
+{
+    static TraceRecorder recorder;
+    return recorder;
+}
+
+TraceRecorder::TraceRecorder() :
+    events_(TRACE_CAPACITY),
+    head_(0),
+    count_(0),
+    profiler_(nullptr)
+{
+}
+
+void TraceRecorder::Add(const char* name, long long start, long long end)
+{
+    // Workers would need a lock, their work shows up where the main thread waits for it
+    if (!Thread::IsMainThread())
+        return;
+
+    TraceEvent& event = events_[head_];
+    event.name_ = name;
+    event.start_ = start;
+    event.duration_ = (unsigned)(end - start);
+
+    head_ = (head_ + 1) % events_.size();
+    if (count_ < events_.size())
+        ++count_;
+}
+
+void TraceRecorder::Clear()
+{
+    head_ = 0;
+    count_ = 0;
+}
+
+bool TraceRecorder::WriteChromeTrace(const String& fileName, float seconds, long long end)
+{
+    FILE* file = fopen(fileName.CString(), "wb");
+    if (!file)
+        return false;
+
+    if (!end)
+        end = Now();
+    const long long since = end - (long long)(seconds * 1000000.0f);
+    const unsigned first = (head_ + (unsigned)events_.size() - count_) % events_.size();
+
+    // Complete events; nesting follows from the timestamps
+    fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", file);
+    bool firstEvent = true;
+    for (unsigned i = 0; i < count_; ++i)
+    {
+        const TraceEvent& event = events_[(first + i) % events_.size()];
+        if (event.start_ + event.duration_ < since || event.start_ > end)
+            continue;
+
+        fprintf(file, "%s{\"name\":\"%s\",\"cat\":\"editor\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%u,\"pid\":1,\"tid\":1}",
+            firstEvent ? "" : ",\n", event.name_, event.start_, event.duration_);
+        firstEvent = false;
+    }
+    fputs("\n]}\n", file);
+
+    return fclose(file) == 0;
+}
+
+TraceScope::TraceScope(const char* name, bool profile) :
+    name_(name),
+    start_(TraceRecorder::Get().Now()),
+    profiled_(false)
+{
+    Profiler* profiler = TraceRecorder::Get().GetProfiler();
+    if (profile && profiler && Thread::IsMainThread())
+    {
+        profiler->BeginBlock(name);
+        profiled_ = true;
+    }
+}
+
+TraceScope::~TraceScope()
+{
+    TraceRecorder& recorder = TraceRecorder::Get();
+    if (profiled_)
+        recorder.GetProfiler()->EndBlock();
+    recorder.Add(name_, start_, recorder.Now());
+}
+
+}
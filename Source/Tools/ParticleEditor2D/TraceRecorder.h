@@ -0,0 +1,113 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include <Urho3D/Container/Str.h>
+#include <Urho3D/Core/Timer.h>
+
+#include <vector>
+
+namespace Urho3D
+{
+
+class Profiler;
+
+/// One timed section.
+struct TraceEvent
+{
+    /// Section name, a string literal.
+    const char* name_;
+    /// Start time in microseconds since the recorder was created.
+    long long start_;
+    /// Duration in microseconds.
+    unsigned duration_;
+};
+
+/// Ring buffer of timed main thread sections that can be written as Chrome trace JSON, for chrome://tracing or
+/// Perfetto. Recording is a timer read and a copy into a preallocated slot, so it stays on all the time.
+class TraceRecorder
+{
+public:
+    /// Return the recorder.
+    static TraceRecorder& Get();
+
+    /// Set profiler that timed sections are reported to as well.
+    void SetProfiler(Profiler* profiler) { profiler_ = profiler; }
+    /// Return profiler.
+    Profiler* GetProfiler() const { return profiler_; }
+    /// Return microseconds since the recorder was created.
+    long long Now() { return timer_.GetUSec(false); }
+    /// Record finished section. Ignored outside the main thread.
+    void Add(const char* name, long long start, long long end);
+    /// Remove all events.
+    void Clear();
+    /// Write events of the seconds before end, or before now if end is zero, as Chrome trace JSON. Return true on
+    /// success.
+    bool WriteChromeTrace(const String& fileName, float seconds, long long end = 0);
+
+    /// Return number of recorded events.
+    unsigned GetNumEvents() const { return count_; }
+    /// Return capacity.
+    unsigned GetCapacity() const { return (unsigned)events_.size(); }
+
+private:
+    /// Construct.
+    TraceRecorder();
+
+    /// Events, oldest at head_ once the buffer is full.
+    std::vector<TraceEvent> events_;
+    /// Next slot to write.
+    unsigned head_;
+    /// Number of valid events.
+    unsigned count_;
+    /// Time base.
+    HiresTimer timer_;
+    /// Profiler, or null.
+    Profiler* profiler_;
+};
+
+/// Times the enclosing scope into the trace recorder and the Urho3D profiler.
+class TraceScope
+{
+public:
+    /// Start section. Name must be a string literal. Sections that enclose Engine::RunFrame must not be reported
+    /// to the profiler, which restarts its block tree every frame.
+    explicit TraceScope(const char* name, bool profile = true);
+    /// End section.
+    ~TraceScope();
+
+private:
+    /// Section name.
+    const char* name_;
+    /// Start time.
+    long long start_;
+    /// Profiler block was opened.
+    bool profiled_;
+};
+
+}
+
+#define EDITOR_TRACE_CONCAT_IMPL(a, b) a ## b
+#define EDITOR_TRACE_CONCAT(a, b) EDITOR_TRACE_CONCAT_IMPL(a, b)
+/// Time the rest of the scope under name.
+#define EDITOR_TRACE(name) Urho3D::TraceScope EDITOR_TRACE_CONCAT(traceScope, __LINE__)(name)
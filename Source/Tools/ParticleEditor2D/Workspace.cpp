@@ -0,0 +1,428 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "Workspace.h"
+
+#include <Urho3D/Core/Context.h>
+#include <Urho3D/IO/File.h>
+#include <Urho3D/IO/FileSystem.h>
+#include <Urho3D/IO/Log.h>
+#include <Urho3D/IO/MemoryBuffer.h>
+
+#include <cstring>
+
+namespace Urho3D
+{
+
+/// File identifier.
+static const char* WORKSPACE_ID = "PEWS";
+/// Format version, bump on incompatible changes.
+static const unsigned WORKSPACE_VERSION = 1;
+/// Appended records never trigger a rewrite below this size.
+static const unsigned MIN_COMPACT_SIZE = 4096;
+
+/// Return file the snapshot is written to before it replaces the workspace.
+static String GetTempFileName(const String& fileName)
+{
+    return fileName + ".tmp";
+}
+
+/// Return whether size more bytes can be read.
+static bool HasBytes(MemoryBuffer& source, unsigned size)
+{
+    return source.GetSize() - source.GetPosition() >= size;
+}
+
+/// Return whether a whole null-terminated string can be read.
+static bool HasString(MemoryBuffer& source)
+{
+    return memchr(source.GetData() + source.GetPosition(), 0, source.GetSize() - source.GetPosition()) != nullptr;
+}
+
+/// Record types. Each record is a type byte, a layer handle and a payload.
+enum WorkspaceRecord
+{
+    RECORD_ADD = 1,
+    RECORD_REMOVE,
+    RECORD_FILE_NAME,
+    RECORD_POSITION,
+    RECORD_VISIBLE,
+    RECORD_RESTART_PERIOD,
+    RECORD_ZOOM,
+    RECORD_BACKGROUND_COLOR,
+    RECORD_SOURCE
+};
+
+Workspace::Workspace(Context* context) :
+    Object(context),
+    zoom_(1.0f),
+    backgroundColor_(Color::BLACK),
+    hasBackgroundColor_(false),
+    snapshotSize_(0),
+    appendedSize_(0)
+{
+}
+
+Workspace::~Workspace()
+{
+}
+
+bool Workspace::Load(const String& fileName)
+{
+    Clear();
+    zoom_ = 1.0f;
+    hasBackgroundColor_ = false;
+
+    // Compact deletes the old file before renaming the new snapshot over it, a crash in between leaves only the
+    // snapshot, which is complete by then
+    FileSystem* fileSystem = GetSubsystem<FileSystem>();
+    String loadFileName = fileName;
+    if (!fileSystem->FileExists(loadFileName))
+        loadFileName = GetTempFileName(fileName);
+    if (!fileSystem->FileExists(loadFileName))
+        return false;
+
+    // One read, the records are replayed from memory
+    File file(context_, loadFileName);
+    PODVector<unsigned char> data(file.GetSize());
+    if (data.Empty() || file.Read(&data[0], data.Size()) != data.Size())
+        return false;
+    file.Close();
+
+    MemoryBuffer source(data);
+    if (source.ReadFileID() != WORKSPACE_ID || source.ReadUInt() != WORKSPACE_VERSION)
+    {
+        URHO3D_LOGWARNING(fileName + " is not a workspace of this version");
+        return false;
+    }
+
+    // A record cut short by a crash ends the replay. MemoryBuffer fills short reads with zeros, so every payload is
+    // checked to be complete before it is read.
+    while (!source.IsEof())
+    {
+        if (!HasBytes(source, sizeof(unsigned char) + sizeof(LayerHandle)))
+            break;
+        const unsigned char type = source.ReadUByte();
+        const LayerHandle layer = source.ReadUInt();
+
+        WorkspaceLayer* state = layers_.Get(layer);
+        switch (type)
+        {
+        case RECORD_ADD:
+        {
+            if (!HasString(source))
+                return true;
+            WorkspaceLayer added;
+            added.fileName_ = source.ReadString();
+            if (!HasBytes(source, sizeof(Vector2) + sizeof(bool) + sizeof(unsigned)))
+                return true;
+            added.position_ = source.ReadVector2();
+            added.visible_ = source.ReadBool();
+            added.restartPeriod_ = source.ReadUInt();
+            layers_.InsertAt(layer, added);
+            break;
+        }
+        case RECORD_REMOVE:
+            layers_.Remove(layer);
+            break;
+        case RECORD_FILE_NAME:
+        {
+            if (!HasString(source))
+                return true;
+            String name = source.ReadString();
+            if (state)
+                state->fileName_ = name;
+            break;
+        }
+        case RECORD_POSITION:
+        {
+            if (!HasBytes(source, sizeof(Vector2)))
+                return true;
+            Vector2 position = source.ReadVector2();
+            if (state)
+                state->position_ = position;
+            break;
+        }
+        case RECORD_VISIBLE:
+        {
+            if (!HasBytes(source, sizeof(bool)))
+                return true;
+            bool visible = source.ReadBool();
+            if (state)
+                state->visible_ = visible;
+            break;
+        }
+        case RECORD_RESTART_PERIOD:
+        {
+            if (!HasBytes(source, sizeof(unsigned)))
+                return true;
+            unsigned period = source.ReadUInt();
+            if (state)
+                state->restartPeriod_ = period;
+            break;
+        }
+        case RECORD_SOURCE:
+        {
+            if (!HasBytes(source, sizeof(LayerHandle)))
+                return true;
+            LayerHandle cloneSource = source.ReadUInt();
+            if (state)
+                state->source_ = cloneSource;
+            break;
+        }
+        case RECORD_ZOOM:
+            if (!HasBytes(source, sizeof(float)))
+                return true;
+            zoom_ = source.ReadFloat();
+            break;
+        case RECORD_BACKGROUND_COLOR:
+            if (!HasBytes(source, sizeof(Color)))
+                return true;
+            backgroundColor_ = source.ReadColor();
+            hasBackgroundColor_ = true;
+            break;
+        default:
+            URHO3D_LOGWARNING(fileName + " has an unknown record, the rest is ignored");
+            return true;
+        }
+    }
+
+    return true;
+}
+
+bool Workspace::Open(const String& fileName)
+{
+    fileName_ = fileName;
+    return Compact();
+}
+
+void Workspace::Clear()
+{
+    layers_ = LayerTable<WorkspaceLayer>();
+}
+
+void Workspace::AddLayer(LayerHandle layer, const WorkspaceLayer& state)
+{
+    layers_.InsertAt(layer, state);
+
+    VectorBuffer& record = BeginRecord(RECORD_ADD, layer);
+    record.WriteString(state.fileName_);
+    record.WriteVector2(state.position_);
+    record.WriteBool(state.visible_);
+    record.WriteUInt(state.restartPeriod_);
+    EndRecord();
+
+    if (state.source_ != INVALID_LAYER)
+    {
+        BeginRecord(RECORD_SOURCE, layer).WriteUInt(state.source_);
+        EndRecord();
+    }
+}
+
+void Workspace::RemoveLayer(LayerHandle layer)
+{
+    if (!layers_.Remove(layer))
+        return;
+
+    BeginRecord(RECORD_REMOVE, layer);
+    EndRecord();
+}
+
+void Workspace::SetFileName(LayerHandle layer, const String& fileName)
+{
+    WorkspaceLayer* state = layers_.Get(layer);
+    if (!state || state->fileName_ == fileName)
+        return;
+    state->fileName_ = fileName;
+
+    BeginRecord(RECORD_FILE_NAME, layer).WriteString(fileName);
+    EndRecord();
+}
+
+void Workspace::SetPosition(LayerHandle layer, const Vector2& position)
+{
+    WorkspaceLayer* state = layers_.Get(layer);
+    if (!state || state->position_ == position)
+        return;
+    state->position_ = position;
+
+    BeginRecord(RECORD_POSITION, layer).WriteVector2(position);
+    EndRecord();
+}
+
+void Workspace::SetVisible(LayerHandle layer, bool visible)
+{
+    WorkspaceLayer* state = layers_.Get(layer);
+    if (!state || state->visible_ == visible)
+        return;
+    state->visible_ = visible;
+
+    BeginRecord(RECORD_VISIBLE, layer).WriteBool(visible);
+    EndRecord();
+}
+
+void Workspace::SetRestartPeriod(LayerHandle layer, unsigned periodMs)
+{
+    WorkspaceLayer* state = layers_.Get(layer);
+    if (!state || state->restartPeriod_ == periodMs)
+        return;
+    state->restartPeriod_ = periodMs;
+
+    BeginRecord(RECORD_RESTART_PERIOD, layer).WriteUInt(periodMs);
+    EndRecord();
+}
+
+void Workspace::SetSource(LayerHandle layer, LayerHandle source)
+{
+    WorkspaceLayer* state = layers_.Get(layer);
+    if (!state || state->source_ == source)
+        return;
+    state->source_ = source;
+
+    BeginRecord(RECORD_SOURCE, layer).WriteUInt(source);
+    EndRecord();
+}
+
+void Workspace::SetZoom(float zoom)
+{
+    if (zoom == zoom_)
+        return;
+    zoom_ = zoom;
+
+    BeginRecord(RECORD_ZOOM, INVALID_LAYER).WriteFloat(zoom);
+    EndRecord();
+}
+
+void Workspace::SetBackgroundColor(const Color& color)
+{
+    if (hasBackgroundColor_ && color == backgroundColor_)
+        return;
+    backgroundColor_ = color;
+    hasBackgroundColor_ = true;
+
+    BeginRecord(RECORD_BACKGROUND_COLOR, INVALID_LAYER).WriteColor(color);
+    EndRecord();
+}
+
+PODVector<LayerHandle> Workspace::GetLayers() const
+{
+    PODVector<LayerHandle> layers;
+    layers_.ForEach([&layers](LayerHandle layer, const WorkspaceLayer&) {
+        layers.Push(layer);
+    });
+    return layers;
+}
+
+VectorBuffer& Workspace::BeginRecord(unsigned char type, LayerHandle layer)
+{
+    record_.Clear();
+    record_.WriteUByte(type);
+    record_.WriteUInt(layer);
+    return record_;
+}
+
+void Workspace::EndRecord()
+{
+    if (!file_)
+        return;
+
+    file_->Write(record_.GetData(), record_.GetSize());
+    file_->Flush();
+    appendedSize_ += record_.GetSize();
+
+    // Replaying a long history of drags and zooms would cost more than rewriting the state
+    if (appendedSize_ > Max(snapshotSize_, MIN_COMPACT_SIZE))
+        Compact();
+}
+
+void Workspace::WriteSnapshot(VectorBuffer& dest) const
+{
+    dest.WriteFileID(WORKSPACE_ID);
+    dest.WriteUInt(WORKSPACE_VERSION);
+
+    layers_.ForEach([&dest](LayerHandle layer, const WorkspaceLayer& state) {
+        dest.WriteUByte(RECORD_ADD);
+        dest.WriteUInt(layer);
+        dest.WriteString(state.fileName_);
+        dest.WriteVector2(state.position_);
+        dest.WriteBool(state.visible_);
+        dest.WriteUInt(state.restartPeriod_);
+
+        if (state.source_ != INVALID_LAYER)
+        {
+            dest.WriteUByte(RECORD_SOURCE);
+            dest.WriteUInt(layer);
+            dest.WriteUInt(state.source_);
+        }
+    });
+
+    dest.WriteUByte(RECORD_ZOOM);
+    dest.WriteUInt(INVALID_LAYER);
+    dest.WriteFloat(zoom_);
+
+    if (hasBackgroundColor_)
+    {
+        dest.WriteUByte(RECORD_BACKGROUND_COLOR);
+        dest.WriteUInt(INVALID_LAYER);
+        dest.WriteColor(backgroundColor_);
+    }
+}
+
+bool Workspace::Compact()
+{
+    file_.Reset();
+    if (fileName_.Empty())
+        return false;
+
+    VectorBuffer snapshot;
+    WriteSnapshot(snapshot);
+
+    // Write beside the old file first, so a failed write keeps the old workspace
+    FileSystem* fileSystem = GetSubsystem<FileSystem>();
+    const String tempFileName = GetTempFileName(fileName_);
+    {
+        File file(context_);
+        if (!file.Open(tempFileName, FILE_WRITE) || file.Write(snapshot.GetData(), snapshot.GetSize()) != snapshot.GetSize())
+        {
+            URHO3D_LOGERROR("Could not write workspace " + tempFileName);
+            return false;
+        }
+    }
+    if (fileSystem->FileExists(fileName_))
+        fileSystem->Delete(fileName_);
+    if (!fileSystem->Rename(tempFileName, fileName_))
+        return false;
+
+    file_ = new File(context_);
+    if (!file_->Open(fileName_, FILE_READWRITE))
+    {
+        file_.Reset();
+        return false;
+    }
+    file_->Seek(file_->GetSize());
+
+    snapshotSize_ = snapshot.GetSize();
+    appendedSize_ = 0;
+    return true;
+}
+
+}
@@ -0,0 +1,134 @@
+//
+// Copyright (c) 2014 the ParticleEditor2D project.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include "LayerTable.h"
+
+#include <Urho3D/Container/Ptr.h>
+#include <Urho3D/Core/Object.h>
+#include <Urho3D/IO/VectorBuffer.h>
+#include <Urho3D/Math/Color.h>
+#include <Urho3D/Math/Vector2.h>
+
+namespace Urho3D
+{
+
+class File;
+
+/// Layer state kept in the workspace.
+struct WorkspaceLayer
+{
+    /// Effect file.
+    String fileName_;
+    /// Node position.
+    Vector2 position_;
+    /// Node is visible.
+    bool visible_ = true;
+    /// Restart period in milliseconds, zero if not restarting.
+    unsigned restartPeriod_ = 0;
+    /// Layer whose simulation a clone shares, invalid if not a clone.
+    LayerHandle source_ = INVALID_LAYER;
+};
+
+/// Binary workspace file: open layers with their position, visibility and restart period, plus zoom and background.
+/// Every change appends a small record, and once the records outgrow the state they describe the file is rewritten
+/// as a snapshot. Loading is one read followed by replaying the records in memory.
+class Workspace : public Object
+{
+    URHO3D_OBJECT(Workspace, Object)
+
+public:
+    /// Construct.
+    Workspace(Context* context);
+    /// Destruct.
+    virtual ~Workspace();
+
+    /// Read workspace file. Return false if it does not exist or is not a workspace; the state is then empty.
+    bool Load(const String& fileName);
+    /// Start recording to file, rewriting it with the current state. Layers are keyed by the handles passed to the
+    /// recording functions from here on, so call Clear and re-add layers under their new handles first.
+    bool Open(const String& fileName);
+    /// Remove all layers.
+    void Clear();
+
+    /// Record added layer.
+    void AddLayer(LayerHandle layer, const WorkspaceLayer& state);
+    /// Record removed layer.
+    void RemoveLayer(LayerHandle layer);
+    /// Record new file name of layer.
+    void SetFileName(LayerHandle layer, const String& fileName);
+    /// Record layer position.
+    void SetPosition(LayerHandle layer, const Vector2& position);
+    /// Record layer visibility.
+    void SetVisible(LayerHandle layer, bool visible);
+    /// Record layer restart period.
+    void SetRestartPeriod(LayerHandle layer, unsigned periodMs);
+    /// Record layer a clone shares the simulation of, invalid once it has a file of its own.
+    void SetSource(LayerHandle layer, LayerHandle source);
+    /// Record camera zoom.
+    void SetZoom(float zoom);
+    /// Record background color.
+    void SetBackgroundColor(const Color& color);
+
+    /// Return layers in slot order. Slots of removed layers are reused, so this is not the order they were added in.
+    PODVector<LayerHandle> GetLayers() const;
+    /// Return layer state, or null if unknown.
+    const WorkspaceLayer* GetLayer(LayerHandle layer) const { return layers_.Get(layer); }
+    /// Return camera zoom.
+    float GetZoom() const { return zoom_; }
+    /// Return whether a background color was recorded.
+    bool HasBackgroundColor() const { return hasBackgroundColor_; }
+    /// Return background color.
+    const Color& GetBackgroundColor() const { return backgroundColor_; }
+
+private:
+    /// Start record in the record buffer and return it for the payload.
+    VectorBuffer& BeginRecord(unsigned char type, LayerHandle layer);
+    /// Append record buffer to the file, compacting it if needed.
+    void EndRecord();
+    /// Write current state as records.
+    void WriteSnapshot(VectorBuffer& dest) const;
+    /// Rewrite file as snapshot and reopen it for appending.
+    bool Compact();
+
+    /// Layer states.
+    LayerTable<WorkspaceLayer> layers_;
+    /// Camera zoom.
+    float zoom_;
+    /// Background color.
+    Color backgroundColor_;
+    /// Background color was recorded.
+    bool hasBackgroundColor_;
+    /// Workspace file name.
+    String fileName_;
+    /// File records are appended to.
+    SharedPtr<File> file_;
+    /// Record being written.
+    VectorBuffer record_;
+    /// Bytes of the last snapshot.
+    unsigned snapshotSize_;
+    /// Bytes appended since the last snapshot.
+    unsigned appendedSize_;
+};
+
+}